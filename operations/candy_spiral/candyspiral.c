@@ -22,6 +22,7 @@
 #include <math.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -110,7 +111,7 @@ property_double (rotation, _("Rotation"), 0.0)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     candyspiral
 #define GEGL_OP_C_SOURCE candyspiral.c
 
@@ -119,17 +120,15 @@ property_double (rotation, _("Rotation"), 0.0)
 static void
 prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static gboolean
-process (GeglOperation       *operation,
-         void               *in_buf,
-         void               *out_buf,
-         glong               n_pixels,
-         const GeglRectangle *roi,
-         gint                level)
+render (GeglOperation       *operation,
+        void               *out_buf,
+        glong               n_pixels,
+        const GeglRectangle *roi,
+        gint                level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out_pixel = (gfloat *) out_buf;
@@ -241,14 +240,26 @@ process (GeglOperation       *operation,
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name", "ai/lb:spiral",
@@ -22,6 +22,8 @@
 #include <math.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
+#include "lb-noise.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -141,73 +143,78 @@ property_seed (seed, _("Seed"), rand)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     cellularnoise
 #define GEGL_OP_C_SOURCE cellularnoise.c
 
 #include "gegl-op.h"
 
-// Simple hash function for randomization
-static gfloat
-hash (gfloat x, gfloat y, gint seed)
-{
-  gint hash = (gint)(x * 73856093 + y * 19349663 + seed * 83492791) & 0x7fffffff;
-  return (hash % 10000) / 10000.0;
-}
+// Largest neighbourhood searched by cellular_noise (range 3 in each direction)
+#define CELLULAR_MAX_WINDOW 7
 
-// Value noise implementation (needed for Rusty Patina)
-static gfloat
-value_noise (gfloat x, gfloat y, gint seed)
+// Jittered feature points of one seed and jitter over the block of cells a
+// process() call can reach, stored row by row as separate x and y arrays
+typedef struct
 {
-  gint xi = (gint) x;
-  gint yi = (gint) y;
-  gfloat xf = x - xi;
-  gfloat yf = y - yi;
-
-  gfloat v00 = hash (xi, yi, seed);
-  gfloat v10 = hash (xi + 1, yi, seed);
-  gfloat v01 = hash (xi, yi + 1, seed);
-  gfloat v11 = hash (xi + 1, yi + 1, seed);
-
-  gfloat u = xf * xf * (3.0 - 2.0 * xf);
-  gfloat v = yf * yf * (3.0 - 2.0 * yf);
+  gint    seed;
+  gfloat  jitter;
+  gint    cell_x0;
+  gint    cell_y0;
+  gint    width;
+  gint    height;
+  gfloat *point_x;
+  gfloat *point_y;
+} CellularFeatures;
 
-  gfloat nx0 = v00 + u * (v10 - v00);
-  gfloat nx1 = v01 + u * (v11 - v01);
+static void
+cellular_feature_point (gint cx, gint cy, gint seed, gfloat jitter, gfloat *px, gfloat *py)
+{
+  *px = cx + lb_noise_hash_float (cx, cy, seed);
+  *py = cy + lb_noise_hash_float (cx + 1, cy, seed);
 
-  return nx0 + v * (nx1 - nx0);
+  gfloat jitter_x = (lb_noise_hash_float (cx, cy + 1, seed) - 0.5) * jitter;
+  gfloat jitter_y = (lb_noise_hash_float (cx + 1, cy + 1, seed) - 0.5) * jitter;
+  *px += jitter_x;
+  *py += jitter_y;
 }
 
-// Perlin noise implementation (needed for Rippled Dots, Voronoi Ripples, and cell distortion)
-static gfloat
-perlin_noise (gfloat x, gfloat y, gint seed)
+// Cache the feature points for queries inside box (min x, min y, max x,
+// max y) scaled by scale_x and scale_y; queries outside still work, they
+// just hash their points on the fly
+static void
+cellular_features_init (CellularFeatures *features, gint seed, gfloat jitter,
+                        const gfloat *box, gfloat scale_x, gfloat scale_y)
 {
-  gint xi = (gint) x;
-  gint yi = (gint) y;
-  gfloat xf = x - xi;
-  gfloat yf = y - yi;
-
-  gfloat g00 = hash (xi, yi, seed) * 2.0 * G_PI;
-  gfloat g10 = hash (xi + 1, yi, seed) * 2.0 * G_PI;
-  gfloat g01 = hash (xi, yi + 1, seed) * 2.0 * G_PI;
-  gfloat g11 = hash (xi + 1, yi + 1, seed) * 2.0 * G_PI;
-
-  gfloat d00 = cos (g00) * xf + sin (g00) * yf;
-  gfloat d10 = cos (g10) * (xf - 1.0) + sin (g10) * yf;
-  gfloat d01 = cos (g01) * xf + sin (g01) * (yf - 1.0);
-  gfloat d11 = cos (g11) * (xf - 1.0) + sin (g11) * (yf - 1.0);
-
-  gfloat u = xf * xf * (3.0 - 2.0 * xf);
-  gfloat v = yf * yf * (3.0 - 2.0 * yf);
+  gint margin = CELLULAR_MAX_WINDOW / 2 + 1;
+
+  features->seed = seed;
+  features->jitter = jitter;
+  features->cell_x0 = (gint) floor (box[0] * scale_x) - margin;
+  features->cell_y0 = (gint) floor (box[1] * scale_y) - margin;
+  features->width = (gint) ceil (box[2] * scale_x) + margin + 1 - features->cell_x0;
+  features->height = (gint) ceil (box[3] * scale_y) + margin + 1 - features->cell_y0;
+
+  features->point_x = g_new (gfloat, features->width * features->height);
+  features->point_y = g_new (gfloat, features->width * features->height);
+
+  for (gint j = 0; j < features->height; j++)
+    for (gint i = 0; i < features->width; i++)
+      cellular_feature_point (features->cell_x0 + i, features->cell_y0 + j, seed, jitter,
+                              &features->point_x[j * features->width + i],
+                              &features->point_y[j * features->width + i]);
+}
 
-  gfloat nx0 = d00 + u * (d10 - d00);
-  gfloat nx1 = d01 + u * (d11 - d01);
-  return nx0 + v * (nx1 - nx0);
+static void
+cellular_features_clear (CellularFeatures *features)
+{
+  g_free (features->point_x);
+  g_free (features->point_y);
+  features->point_x = features->point_y = NULL;
 }
 
 // Cellular/Worley noise (distance to nearest point) with new sliders and cell shape
 static gfloat
-cellular_noise (gfloat x, gfloat y, gint seed, gfloat jitter, gfloat sharpness, gfloat scale, GeglCellShape231 shape)
+cellular_noise (const CellularFeatures *features, gfloat x, gfloat y, gfloat sharpness, gfloat scale, GeglCellShape231 shape)
 {
   gint xi = (gint) x;
   gint yi = (gint) y;
@@ -215,63 +222,87 @@ cellular_noise (gfloat x, gfloat y, gint seed, gfloat jitter, gfloat sharpness,
 
   // Dynamically adjust the sampling range based on scale
   gint range = (scale < 50.0) ? 3 : 2; // Use a larger range for scale < 50
-
-  for (gint i = -range; i <= range; i++)
-    for (gint j = -range; j <= range; j++)
+  gint size = 2 * range + 1;
+  gint count = size * size;
+
+  // Offsets to every feature point of the window, from the cache when the
+  // whole window is inside it
+  gfloat dx[CELLULAR_MAX_WINDOW * CELLULAR_MAX_WINDOW];
+  gfloat dy[CELLULAR_MAX_WINDOW * CELLULAR_MAX_WINDOW];
+  gint first_x = xi - range - features->cell_x0;
+  gint first_y = yi - range - features->cell_y0;
+
+  if (first_x >= 0 && first_y >= 0 &&
+      first_x + size <= features->width && first_y + size <= features->height)
+  {
+    for (gint j = 0; j < size; j++)
     {
-      gfloat px = xi + i + hash (xi + i, yi + j, seed);
-      gfloat py = yi + j + hash (xi + i + 1, yi + j, seed);
-
-      gfloat jitter_x = (hash (xi + i, yi + j + 1, seed) - 0.5) * jitter;
-      gfloat jitter_y = (hash (xi + i + 1, yi + j + 1, seed) - 0.5) * jitter;
-      px += jitter_x;
-      py += jitter_y;
-
-      gfloat dx = x - px;
-      gfloat dy = y - py;
-      gfloat dist;
-
-      switch (shape)
+      const gfloat *point_x = features->point_x + (first_y + j) * features->width + first_x;
+      const gfloat *point_y = features->point_y + (first_y + j) * features->width + first_x;
+      for (gint i = 0; i < size; i++)
       {
-        case GEGL_CELL_SHAPE_CIRCLE:
-          dist = sqrt (dx * dx + dy * dy); // Euclidean distance
-          break;
-
-        case GEGL_CELL_SHAPE_SQUARE:
-          dist = fabs (dx) + fabs (dy); // Manhattan distance
-          break;
-
-        case GEGL_CELL_SHAPE_DIAMOND:
-          dist = fmax (fabs (dx), fabs (dy)); // Chebyshev distance
-          break;
+        dx[j * size + i] = x - point_x[i];
+        dy[j * size + i] = y - point_y[i];
+      }
+    }
+  }
+  else
+  {
+    for (gint j = 0; j < size; j++)
+      for (gint i = 0; i < size; i++)
+      {
+        gfloat px, py;
+        cellular_feature_point (xi - range + i, yi - range + j, features->seed, features->jitter, &px, &py);
+        dx[j * size + i] = x - px;
+        dy[j * size + i] = y - py;
+      }
+  }
 
-        case GEGL_CELL_SHAPE_OVAL:
-          dist = sqrt (dx * dx * 0.5 + dy * dy * 2.0); // Scaled Euclidean for elongation
-          break;
+  // One branch-free pass per shape so the compiler can vectorise it
+  switch (shape)
+  {
+    case GEGL_CELL_SHAPE_SQUARE:
+      for (gint k = 0; k < count; k++)
+        min_dist = MIN (min_dist, fabsf (dx[k]) + fabsf (dy[k])); // Manhattan distance
+      break;
 
-        case GEGL_CELL_SHAPE_STAR:
-          {
-            gfloat angle = atan2 (dy, dx);
-            gfloat radius = sqrt (dx * dx + dy * dy);
-            dist = radius * (1.0 + 0.3 * sin (5.0 * angle)); // 5-pointed star
-          }
-          break;
+    case GEGL_CELL_SHAPE_DIAMOND:
+      for (gint k = 0; k < count; k++)
+        min_dist = MIN (min_dist, MAX (fabsf (dx[k]), fabsf (dy[k]))); // Chebyshev distance
+      break;
 
-/*        case GEGL_CELL_SHAPE_FLOWER: */
-          {
-            gfloat angle = atan2 (dy, dx);
-            gfloat radius = sqrt (dx * dx + dy * dy);
-            dist = radius * (1.0 + 0.2 * sin (6.0 * angle)); // 6-petal flower
-          }
-          break;
+    case GEGL_CELL_SHAPE_OVAL:
+      {
+        gfloat min_dist_sq = 1000.0 * 1000.0;
+        for (gint k = 0; k < count; k++)
+          min_dist_sq = MIN (min_dist_sq, dx[k] * dx[k] * 0.5f + dy[k] * dy[k] * 2.0f); // Scaled Euclidean for elongation
+        min_dist = sqrtf (min_dist_sq);
+      }
+      break;
 
-        default:
-          dist = sqrt (dx * dx + dy * dy); // Fallback to Euclidean
+    case GEGL_CELL_SHAPE_STAR:
+      for (gint k = 0; k < count; k++)
+      {
+        // 5-pointed star, radius * (1 + 0.3 sin (5 angle)) with
+        // sin (5 angle) expanded in s = sin (angle) to avoid atan2
+        gfloat radius = sqrtf (dx[k] * dx[k] + dy[k] * dy[k]);
+        gfloat s = radius > 0.0f ? dy[k] / radius : 0.0f;
+        gfloat s2 = s * s;
+        gfloat sin5 = s * (5.0f + s2 * (-20.0f + s2 * 16.0f));
+        min_dist = MIN (min_dist, radius * (1.0f + 0.3f * sin5));
       }
+      break;
 
-      if (dist < min_dist)
-        min_dist = dist;
-    }
+    case GEGL_CELL_SHAPE_CIRCLE:
+    default:
+      {
+        gfloat min_dist_sq = 1000.0 * 1000.0;
+        for (gint k = 0; k < count; k++)
+          min_dist_sq = MIN (min_dist_sq, dx[k] * dx[k] + dy[k] * dy[k]); // Euclidean distance
+        min_dist = sqrtf (min_dist_sq);
+      }
+      break;
+  }
 
   if (sharpness != 0.0)
   {
@@ -294,21 +325,93 @@ cellular_noise (gfloat x, gfloat y, gint seed, gfloat jitter, gfloat sharpness,
 static void
 prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static gboolean
-process (GeglOperation       *operation,
-         void               *in_buf,
-         void               *out_buf,
-         glong               n_pixels,
-         const GeglRectangle *roi,
-         gint                level)
+render (GeglOperation       *operation,
+        void               *out_buf,
+        glong               n_pixels,
+        const GeglRectangle *roi,
+        gint                level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out_pixel = (gfloat *) out_buf;
 
+  // Noise coordinates this call can reach, plain and with the distortion
+  // (bounded by the distortion amount) and stretch applied
+  gfloat plain[4] = { roi->x / o->scale, roi->y / o->scale,
+                      (roi->x + roi->width - 1) / o->scale, (roi->y + roi->height - 1) / o->scale };
+  gfloat distorted[4] = { (plain[0] - o->cell_distortion) * o->cell_stretch, plain[1] - o->cell_distortion,
+                          (plain[2] + o->cell_distortion) * o->cell_stretch, plain[3] + o->cell_distortion };
+
+  // Feature points for each cellular_noise() lookup of the noise type
+  CellularFeatures features[2] = { { 0 } };
+  switch (o->noise_type)
+  {
+    case GEGL_NOISE_TYPE_CELLULAR:
+    case GEGL_NOISE_TYPE_VORONOI:
+    case GEGL_NOISE_TYPE_CELLULAR_SHARDS:
+    case GEGL_NOISE_TYPE_VORONOI_RIPPLES:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter, distorted, 1.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_WORLEY:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter, plain, 1.0, 1.0);
+      cellular_features_init (&features[1], o->seed, o->cell_jitter, plain, 2.0, 2.0);
+      break;
+
+    case GEGL_NOISE_TYPE_CELLULAR_CRACKED:
+    case GEGL_NOISE_TYPE_FRACTURED_TILES:
+      cellular_features_init (&features[0], o->seed, 0.0, plain, 1.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_CELLULAR_MOSAIC:
+      cellular_features_init (&features[0], o->seed, 0.0, plain, 1.0, 1.0);
+      cellular_features_init (&features[1], o->seed + 1, 0.0, plain, 4.0, 4.0);
+      break;
+
+    case GEGL_NOISE_TYPE_RUSTY_PATINA:
+      cellular_features_init (&features[0], o->seed + 1, 0.0, plain, 2.0, 2.0);
+      break;
+
+    case GEGL_NOISE_TYPE_RIPPLED_DOTS:
+      cellular_features_init (&features[0], o->seed, 0.0, plain, 2.0, 2.0);
+      break;
+
+    case GEGL_NOISE_TYPE_CRYSTAL_LATTICE:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter, plain, 1.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_ORGANIC_BLOBS:
+      cellular_features_init (&features[0], o->seed, 1.0, distorted, 1.0, 1.0); // High jitter for irregularity
+      break;
+
+    case GEGL_NOISE_TYPE_BUBBLE_FOAM:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter, distorted, 1.0, 1.0);
+      cellular_features_init (&features[1], o->seed + 1, o->cell_jitter, distorted, 1.5, 1.5);
+      break;
+
+    case GEGL_NOISE_TYPE_SQUARE_CELLS:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter * 0.2, distorted, 1.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_JELLY_BEAN:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter, distorted, o->cell_stretch * 2.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_HEXAGONAL:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter * 0.5, distorted, 1.0, 1.0);
+      break;
+
+    case GEGL_NOISE_TYPE_ROUNDED_SQUARES:
+      cellular_features_init (&features[0], o->seed, o->cell_jitter * 0.3, distorted, 1.0, 1.0);
+      break;
+
+    default:
+      break;
+  }
+
   for (glong i = 0; i < n_pixels; i++)
   {
     // Compute local coordinates within the roi
@@ -333,8 +436,8 @@ process (GeglOperation       *operation,
         o->noise_type == GEGL_NOISE_TYPE_ROUNDED_SQUARES)
     {
       // Apply distortion using Perlin noise
-      gfloat distortion_x = perlin_noise(nx * 0.5, ny * 0.5, o->seed + 100) * o->cell_distortion;
-      gfloat distortion_y = perlin_noise(nx * 0.5 + 1000.0, ny * 0.5, o->seed + 200) * o->cell_distortion;
+      gfloat distortion_x = lb_noise_perlin2 (nx * 0.5, ny * 0.5, o->seed + 100) * o->cell_distortion;
+      gfloat distortion_y = lb_noise_perlin2 (nx * 0.5 + 1000.0, ny * 0.5, o->seed + 200) * o->cell_distortion;
       distorted_nx += distortion_x;
       distorted_ny += distortion_y;
 
@@ -347,30 +450,30 @@ process (GeglOperation       *operation,
     switch (o->noise_type)
     {
       case GEGL_NOISE_TYPE_CELLULAR:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, o->edge_sharpness, o->scale, o->cell_shape);
         noise = 1.0 - noise;
         break;
 
       case GEGL_NOISE_TYPE_WORLEY:
-        noise = cellular_noise (nx, ny, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE) * 
-                cellular_noise (nx * 2.0, ny * 2.0, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        noise = cellular_noise (&features[0], nx, ny, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE) * 
+                cellular_noise (&features[1], nx * 2.0, ny * 2.0, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         break;
 
       case GEGL_NOISE_TYPE_VORONOI:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, o->edge_sharpness, o->scale, o->cell_shape);
         noise = noise * noise;
         break;
 
       case GEGL_NOISE_TYPE_CELLULAR_CRACKED:
-        noise = cellular_noise (nx, ny, o->seed, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        noise = cellular_noise (&features[0], nx, ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         noise = 1.0 - noise;
         noise = noise * noise * o->roughness;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_CELLULAR_MOSAIC:
-        noise = cellular_noise (nx, ny, o->seed, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
-        gfloat detail = cellular_noise (nx * 4.0, ny * 4.0, o->seed + 1, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE) * o->roughness;
+        noise = cellular_noise (&features[0], nx, ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        gfloat detail = cellular_noise (&features[1], nx * 4.0, ny * 4.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE) * o->roughness;
         noise = noise + detail * 0.3;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
@@ -384,7 +487,7 @@ process (GeglOperation       *operation,
 
           for (gint j = 0; j < o->octaves; j++)
           {
-            noise += amplitude * value_noise (nx * frequency * o->detail_scale, ny * frequency * o->detail_scale, o->seed + j);
+            noise += amplitude * lb_noise_value2 (nx * frequency * o->detail_scale, ny * frequency * o->detail_scale, o->seed + j);
             total_amplitude += amplitude;
             amplitude *= o->roughness;
             frequency *= 2.0;
@@ -392,16 +495,16 @@ process (GeglOperation       *operation,
 
           noise /= total_amplitude;
           noise = (noise + 1.0) * 0.5;
-          noise = noise + cellular_noise (nx * 2.0, ny * 2.0, o->seed + 1, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE) * 0.3;
+          noise = noise + cellular_noise (&features[0], nx * 2.0, ny * 2.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE) * 0.3;
           noise = CLAMP (noise, 0.0, 1.0);
         }
         break;
 
       case GEGL_NOISE_TYPE_RIPPLED_DOTS:
         {
-          noise = cellular_noise (nx * 2.0, ny * 2.0, o->seed, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+          noise = cellular_noise (&features[0], nx * 2.0, ny * 2.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
           noise = 1.0 - noise; // Invert for dots
-          gfloat ripple = perlin_noise (nx, ny, o->seed + 1);
+          gfloat ripple = lb_noise_perlin2 (nx, ny, o->seed + 1);
           noise += sin (ripple * o->roughness * G_PI) * 0.3; // Add rippling effect
           noise = (noise + 1.0) * 0.5;
           noise = CLAMP (noise, 0.0, 1.0);
@@ -409,71 +512,71 @@ process (GeglOperation       *operation,
         break;
 
       case GEGL_NOISE_TYPE_CELLULAR_SHARDS:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, o->edge_sharpness, o->scale, o->cell_shape);
         noise = pow (noise, 1.0 + o->roughness * 0.5); // Sharpen edges
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_CRYSTAL_LATTICE:
-        noise = cellular_noise (nx, ny, o->seed, o->cell_jitter, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        noise = cellular_noise (&features[0], nx, ny, o->edge_sharpness, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         noise = sin (noise * 10.0); // Create sharp, crystalline transitions
         noise = (noise + 1.0) * 0.5;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_ORGANIC_BLOBS:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, 1.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE); // High jitter for irregularity
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         noise = 1.0 - noise;
         noise = pow (noise, 2.0 - o->softness); // Apply softness
-        noise = noise + perlin_noise (nx * 0.5, ny * 0.5, o->seed + 1) * o->roughness * 0.2;
+        noise = noise + lb_noise_perlin2 (nx * 0.5, ny * 0.5, o->seed + 1) * o->roughness * 0.2;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_FRACTURED_TILES:
-        noise = cellular_noise (nx, ny, o->seed, 0.0, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
-        gfloat fractures = perlin_noise (nx * 2.0 * o->detail_scale, ny * 2.0 * o->detail_scale, o->seed + 1);
+        noise = cellular_noise (&features[0], nx, ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        gfloat fractures = lb_noise_perlin2 (nx * 2.0 * o->detail_scale, ny * 2.0 * o->detail_scale, o->seed + 1);
         noise = noise + fractures * o->fracture_intensity * o->roughness * 0.5;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_BUBBLE_FOAM:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         noise = 1.0 - noise;
-        gfloat secondary = cellular_noise (distorted_nx * 1.5, distorted_ny * 1.5, o->seed + 1, o->cell_jitter, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        gfloat secondary = cellular_noise (&features[1], distorted_nx * 1.5, distorted_ny * 1.5, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
         noise = noise * (1.0 - secondary * 0.5); // Overlap bubbles
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_VORONOI_RIPPLES:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
-        gfloat ripple = perlin_noise (nx * 2.0 * o->detail_scale, ny * 2.0 * o->detail_scale, o->seed + 1);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, 0.0, o->scale, GEGL_CELL_SHAPE_CIRCLE);
+        gfloat ripple = lb_noise_perlin2 (nx * 2.0 * o->detail_scale, ny * 2.0 * o->detail_scale, o->seed + 1);
         noise = noise + sin (noise * 10.0 + ripple) * o->ripple_strength * o->roughness * 0.2;
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_SQUARE_CELLS:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter * 0.2, o->edge_sharpness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, o->edge_sharpness, o->scale, o->cell_shape);
         noise = 1.0 - noise;
         noise = pow (noise, 1.0 + o->edge_sharpness); // Sharpen for square-like edges
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_JELLY_BEAN:
-        noise = cellular_noise (distorted_nx * o->cell_stretch * 2.0, distorted_ny, o->seed, o->cell_jitter, -o->softness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx * o->cell_stretch * 2.0, distorted_ny, -o->softness, o->scale, o->cell_shape);
         noise = 1.0 - noise;
         noise = pow (noise, 2.0 - o->softness); // Soft, elongated shapes
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_HEXAGONAL:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter * 0.5, o->edge_sharpness * 0.7, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, o->edge_sharpness * 0.7, o->scale, o->cell_shape);
         noise = 1.0 - noise;
         noise = pow (noise, 1.5); // Slightly sharpen for hexagonal appearance
         noise = CLAMP (noise, 0.0, 1.0);
         break;
 
       case GEGL_NOISE_TYPE_ROUNDED_SQUARES:
-        noise = cellular_noise (distorted_nx, distorted_ny, o->seed, o->cell_jitter * 0.3, -o->edge_sharpness, o->scale, o->cell_shape);
+        noise = cellular_noise (&features[0], distorted_nx, distorted_ny, -o->edge_sharpness, o->scale, o->cell_shape);
         noise = 1.0 - noise;
         noise = pow (noise, 2.0 - o->edge_sharpness); // Soften edges for rounded squares
         noise = CLAMP (noise, 0.0, 1.0);
@@ -495,17 +598,32 @@ process (GeglOperation       *operation,
     out_pixel += 4;
   }
 
+  cellular_features_clear (&features[0]);
+  cellular_features_clear (&features[1]);
+
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "ai/lb:cellular-noise",
@@ -23,6 +23,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include <string.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -93,7 +95,7 @@ property_double (rotation, _("Pattern Rotation Angle"), 0.0)
 static void prepare (GeglOperation *operation)
 {
   const Babl *format = babl_format ("RGBA float");
-  gegl_operation_set_format (operation, "output", format);
+  lb_generator_set_format (operation, format);
 }
 
 static GeglRectangle get_bounding_box (GeglOperation *operation)
@@ -109,32 +111,50 @@ process (GeglOperation       *operation,
          gint                 level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
-  const GeglRectangle *rect = result;
-  gint x, y;
-  gfloat output_pixel[4];
+  const Babl *format = gegl_operation_get_format (operation, "output");
+  gint bpp = babl_format_get_bytes_per_pixel (format);
+  GeglBufferIterator *iter;
+  GeglColor *colors[8];
+  gfloat palette[8][4];
+  guchar packed[8 * 16];
+  gint i;
 
   gdouble size = o->pattern_size;
   gdouble angle = o->rotation * G_PI / 180.0;
   gdouble cos_angle = cos(angle);
   gdouble sin_angle = sin(angle);
+  gdouble alpha;
 
-  gdouble c1_r, c1_g, c1_b, c1_a;
-  gdouble c2_r, c2_g, c2_b, c2_a;
-  gdouble c3_r, c3_g, c3_b, c3_a;
-  gdouble c4_r, c4_g, c4_b, c4_a;
-  gdouble c5_r, c5_g, c5_b, c5_a;
-  gdouble c6_r, c6_g, c6_b, c6_a;
-  gdouble c7_r, c7_g, c7_b, c7_a;
-  gdouble c8_r, c8_g, c8_b, c8_a;
-
-  gegl_color_get_rgba (o->pattern_color1, &c1_r, &c1_g, &c1_b, &c1_a);
-  gegl_color_get_rgba (o->pattern_color2, &c2_r, &c2_g, &c2_b, &c2_a);
-  gegl_color_get_rgba (o->pattern_color3, &c3_r, &c3_g, &c3_b, &c3_a);
-  gegl_color_get_rgba (o->pattern_color4, &c4_r, &c4_g, &c4_b, &c4_a);
-  gegl_color_get_rgba (o->pattern_color5, &c5_r, &c5_g, &c5_b, &c5_a);
-  gegl_color_get_rgba (o->pattern_color6, &c6_r, &c6_g, &c6_b, &c6_a);
-  gegl_color_get_rgba (o->pattern_color7, &c7_r, &c7_g, &c7_b, &c7_a);
-  gegl_color_get_rgba (o->pattern_color8, &c8_r, &c8_g, &c8_b, &c8_a);
+  if (result->width < 1 || result->height < 1)
+    return TRUE;
+
+  colors[0] = o->pattern_color1;
+  colors[1] = o->pattern_color2;
+  colors[2] = o->pattern_color3;
+  colors[3] = o->pattern_color4;
+  colors[4] = o->pattern_color5;
+  colors[5] = o->pattern_color6;
+  colors[6] = o->pattern_color7;
+  colors[7] = o->pattern_color8;
+
+  /* The whole pattern takes its alpha from the first color */
+  gegl_color_get_rgba (o->pattern_color1, NULL, NULL, NULL, &alpha);
+
+  for (i = 0; i < 8; i++)
+    {
+      gdouble r, g, b, a;
+
+      gegl_color_get_rgba (colors[i], &r, &g, &b, &a);
+      palette[i][0] = (gfloat) r;
+      palette[i][1] = (gfloat) g;
+      palette[i][2] = (gfloat) b;
+      palette[i][3] = (gfloat) alpha;
+    }
+
+  /* The cells are flat colors, so convert the palette to the output
+   * format once and copy whole pixels, whatever their precision */
+  babl_process (babl_fish (babl_format ("RGBA float"), format),
+                palette, packed, 8);
 
   gint num_colors;
   switch (o->num_colors)
@@ -149,68 +169,33 @@ process (GeglOperation       *operation,
     default: num_colors = 3; break;
   }
 
-  for (y = rect->y; y < rect->y + rect->height; y++)
-  {
-    for (x = rect->x; x < rect->x + rect->width; x++)
+  iter = gegl_buffer_iterator_new (output, result, 0, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
     {
-      gdouble rx = x * cos_angle - y * sin_angle;
-      gdouble ry = x * sin_angle + y * cos_angle;
-      
-      gint u = (gint)floor(rx / size);
-      gint v = (gint)floor(ry / size);
-
-      gint index = (abs(u) + abs(v)) % num_colors;
-
-      switch (index)
-      {
-        case 0:
-          output_pixel[0] = (gfloat)c1_r;
-          output_pixel[1] = (gfloat)c1_g;
-          output_pixel[2] = (gfloat)c1_b;
-          break;
-        case 1:
-          output_pixel[0] = (gfloat)c2_r;
-          output_pixel[1] = (gfloat)c2_g;
-          output_pixel[2] = (gfloat)c2_b;
-          break;
-        case 2:
-          output_pixel[0] = (gfloat)c3_r;
-          output_pixel[1] = (gfloat)c3_g;
-          output_pixel[2] = (gfloat)c3_b;
-          break;
-        case 3:
-          output_pixel[0] = (gfloat)c4_r;
-          output_pixel[1] = (gfloat)c4_g;
-          output_pixel[2] = (gfloat)c4_b;
-          break;
-        case 4:
-          output_pixel[0] = (gfloat)c5_r;
-          output_pixel[1] = (gfloat)c5_g;
-          output_pixel[2] = (gfloat)c5_b;
-          break;
-        case 5:
-          output_pixel[0] = (gfloat)c6_r;
-          output_pixel[1] = (gfloat)c6_g;
-          output_pixel[2] = (gfloat)c6_b;
-          break;
-        case 6:
-          output_pixel[0] = (gfloat)c7_r;
-          output_pixel[1] = (gfloat)c7_g;
-          output_pixel[2] = (gfloat)c7_b;
-          break;
-        case 7:
-          output_pixel[0] = (gfloat)c8_r;
-          output_pixel[1] = (gfloat)c8_g;
-          output_pixel[2] = (gfloat)c8_b;
-          break;
-      }
-      output_pixel[3] = (gfloat)c1_a;
-
-      GeglRectangle pixel_rect = {x, y, 1, 1};
-      gegl_buffer_set (output, &pixel_rect, 0, babl_format ("RGBA float"), 
-                      output_pixel, GEGL_AUTO_ROWSTRIDE);
+      guchar *out_pixel = iter->items[0].data;
+      GeglRectangle roi = iter->items[0].roi;
+      gint x, y;
+
+      for (y = roi.y; y < roi.y + roi.height; y++)
+        {
+          /* Every pixel is placed from its absolute coordinates, so the
+           * cell edges do not depend on how the region was chunked */
+          gdouble row_u = y * sin_angle;
+          gdouble row_v = y * cos_angle;
+
+          for (x = roi.x; x < roi.x + roi.width; x++)
+            {
+              gint u = (gint) floor ((x * cos_angle - row_u) / size);
+              gint v = (gint) floor ((x * sin_angle + row_v) / size);
+              gint index = (abs (u) + abs (v)) % num_colors;
+
+              memcpy (out_pixel, packed + index * bpp, bpp);
+              out_pixel += bpp;
+            }
+        }
     }
-  }
 
   return TRUE;
 }
@@ -223,8 +208,13 @@ gegl_op_class_init (GeglOpClass *klass)
 
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   filter_class->process = process;
 
+  /* Every pixel is a pure function of its coordinates, so GEGL may
+   * split the requested region across worker threads */
+  operation_class->threaded = TRUE;
+
   gegl_operation_class_set_keys (operation_class,
     "name",        "ai/lb:checkerboard",
     "title",       _("Checkerboard Patterns"),
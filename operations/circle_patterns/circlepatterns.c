@@ -21,6 +21,9 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-noise.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -67,9 +70,12 @@ property_color(outline_color, _("Outline Color"), "#000000")
     description(_("Color of the circle outline (default is black)"))
     ui_meta("visible", "draw_outline")
 
+property_boolean(antialias, _("Antialiasing"), FALSE)
+    description(_("Smooth the circle edges using their distance to each pixel"))
+
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     circlepatterns
 #define GEGL_OP_C_SOURCE circlepatterns.c
 
@@ -79,8 +85,7 @@ static void
 prepare(GeglOperation *operation)
 {
   const Babl *space = gegl_operation_get_source_space(operation, "input");
-  gegl_operation_set_format(operation, "input", babl_format_with_space("RGBA float", space));
-  gegl_operation_set_format(operation, "output", babl_format_with_space("RGBA float", space));
+  lb_generator_set_format(operation, babl_format_with_space("RGBA float", space));
 }
 
 static GeglRectangle
@@ -96,22 +101,15 @@ get_bounding_box(GeglOperation *operation)
   }
 }
 
-// Simple hash function for pseudo-random numbers
-static guint32
-hash_position(gint x, gint y)
-{
-  return (x * 131 + y * 151) ^ (x + y);
-}
-
 // Pseudo-random float between 0 and 1 based on position
 static gfloat
 random_float(gint x, gint y)
 {
-  return (hash_position(x, y) % 1000) / 1000.0f;
+  return lb_noise_hash_float(x, y, 0);
 }
 
 static gboolean
-process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
+render(GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   gfloat circle_rgb[3], bg_rgb[3], outline_rgb[3];
@@ -136,8 +134,6 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
       gint idx = ((y - roi->y) * roi->width + (x - roi->x)) * 4;
       gfloat min_distance = G_MAXFLOAT;
       gfloat current_radius = radius;
-      gboolean is_inside = FALSE;
-      gboolean is_outline = FALSE;
 
       switch (o->pattern)
       {
@@ -307,64 +303,60 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
         }
       }
 
-      if (min_distance <= current_radius)
-      {
-        is_inside = TRUE;
-        if (o->draw_outline && min_distance >= (current_radius - outline_thickness))
-        {
-          is_outline = TRUE;
-        }
-      }
+      gfloat *pixel = out_data + idx;
+      gfloat shape_rgb[3];
 
-      if (is_inside)
+      if (o->enable_background)
       {
-        if (is_outline)
-        {
-          out_data[idx + 0] = outline_rgb[0];
-          out_data[idx + 1] = outline_rgb[1];
-          out_data[idx + 2] = outline_rgb[2];
-          out_data[idx + 3] = 1.0f;
-        }
-        else
-        {
-          out_data[idx + 0] = circle_rgb[0];
-          out_data[idx + 1] = circle_rgb[1];
-          out_data[idx + 2] = circle_rgb[2];
-          out_data[idx + 3] = 1.0f;
-        }
+        pixel[0] = bg_rgb[0];
+        pixel[1] = bg_rgb[1];
+        pixel[2] = bg_rgb[2];
+        pixel[3] = 1.0f;  // Opaque background
       }
       else
       {
-        if (o->enable_background)
-        {
-          out_data[idx + 0] = bg_rgb[0];
-          out_data[idx + 1] = bg_rgb[1];
-          out_data[idx + 2] = bg_rgb[2];
-          out_data[idx + 3] = 1.0f;  // Opaque background
-        }
-        else
-        {
-          out_data[idx + 0] = 0.0f;
-          out_data[idx + 1] = 0.0f;
-          out_data[idx + 2] = 0.0f;
-          out_data[idx + 3] = 0.0f;  // Transparent background
-        }
+        pixel[0] = 0.0f;
+        pixel[1] = 0.0f;
+        pixel[2] = 0.0f;
+        pixel[3] = 0.0f;  // Transparent background
       }
+
+      // Blend towards the outline color across the inner edge of the ring
+      gfloat outline = 0.0f;
+      if (o->draw_outline)
+        outline = 1.0f - lb_coverage(min_distance - (current_radius - outline_thickness), o->antialias);
+
+      for (gint c = 0; c < 3; c++)
+        shape_rgb[c] = circle_rgb[c] * (1.0f - outline) + outline_rgb[c] * outline;
+
+      lb_coverage_over(pixel, shape_rgb, lb_coverage(min_distance - current_radius, o->antialias));
     }
   }
 
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
       "name",        "ai/lb:circle-patterns",
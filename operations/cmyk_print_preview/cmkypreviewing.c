@@ -45,11 +45,152 @@ property_enum (algorithm, _("CMYK Algorithm"),
 #include <gegl-op.h>
 #include <math.h>
 
+/* Grid points per axis of the baked soft-proof table, 33^3 RGB floats */
+#define CMYK_LUT_SIZE 33
+
+typedef struct
+{
+  gint   algorithm;
+  gfloat lut[CMYK_LUT_SIZE * CMYK_LUT_SIZE * CMYK_LUT_SIZE * 3];
+} CmykPreviewLut;
+
+/* Reference conversion of one color through the selected algorithm */
+static void
+cmyk_preview_color (gint          algorithm,
+                    const gfloat *rgb,
+                    gfloat       *out)
+{
+  gfloat c, m, y, k;
+
+  /* Base RGB to CMY conversion */
+  c = 1.0 - rgb[0];
+  m = 1.0 - rgb[1];
+  y = 1.0 - rgb[2];
+
+  switch (algorithm)
+    {
+    case CMYK_ORIGINAL:
+      /* Original: Slight amplification for visibility */
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001);
+      m = (m - k) / (1.0 - k + 0.0001);
+      y = (y - k) / (1.0 - k + 0.0001);
+      c = CLAMP (c * 1.1, 0.0, 1.0);
+      m = CLAMP (m * 1.1, 0.0, 1.0);
+      y = CLAMP (y * 1.1, 0.0, 1.0);
+      k = CLAMP (k * 0.9, 0.0, 1.0);
+      break;
+
+    case CMYK_VIBRANT_REDUCTION:
+      /* Vibrant Reduction: Reduce vibrancy to mimic CMYK gamut */
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001) * 0.8;
+      m = (m - k) / (1.0 - k + 0.0001) * 0.8;
+      y = (y - k) / (1.0 - k + 0.0001) * 0.8;
+      c = CLAMP (c, 0.0, 1.0);
+      m = CLAMP (m, 0.0, 1.0);
+      y = CLAMP (y, 0.0, 1.0);
+      break;
+
+    case CMYK_GAMUT_COMPRESSION:
+      /* Gamut Compression: Perceptual adjustment to fit CMYK gamut */
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001);
+      m = (m - k) / (1.0 - k + 0.0001);
+      y = (y - k) / (1.0 - k + 0.0001);
+      gfloat saturation = (c + m + y) / 3.0;
+      c = c * (1.0 - saturation * 0.3);
+      m = m * (1.0 - saturation * 0.3);
+      y = y * (1.0 - saturation * 0.3);
+      c = CLAMP (c, 0.0, 1.0);
+      m = CLAMP (m, 0.0, 1.0);
+      y = CLAMP (y, 0.0, 1.0);
+      break;
+
+    case CMYK_MATTE_PAPER:
+      /* Matte Paper: Simulate ink absorption, duller colors, lower contrast */
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001) * 0.75; /* Stronger vibrancy reduction */
+      m = (m - k) / (1.0 - k + 0.0001) * 0.75;
+      y = (y - k) / (1.0 - k + 0.0001) * 0.75;
+      k = k * 1.1; /* Slightly increase black to simulate ink spread */
+      k = CLAMP (k, 0.0, 1.0);
+      c = CLAMP (c, 0.0, 1.0);
+      m = CLAMP (m, 0.0, 1.0);
+      y = CLAMP (y, 0.0, 1.0);
+      break;
+
+    case CMYK_GLOSSY_PAPER:
+      /* Glossy Paper: Slightly higher contrast, still duller than RGB */
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001) * 0.85; /* Moderate vibrancy reduction */
+      m = (m - k) / (1.0 - k + 0.0001) * 0.85;
+      y = (y - k) / (1.0 - k + 0.0001) * 0.85;
+      k = k * 0.95; /* Slightly reduce black for higher contrast */
+      k = CLAMP (k, 0.0, 1.0);
+      c = CLAMP (c, 0.0, 1.0);
+      m = CLAMP (m, 0.0, 1.0);
+      y = CLAMP (y, 0.0, 1.0);
+      break;
+
+    default:
+      k = MIN (MIN (c, m), y);
+      c = (c - k) / (1.0 - k + 0.0001);
+      m = (m - k) / (1.0 - k + 0.0001);
+      y = (y - k) / (1.0 - k + 0.0001);
+      break;
+    }
+
+  /* Convert back to RGB for preview */
+  out[0] = CLAMP (1.0 - (c * (1.0 - k) + k), 0.0, 1.0);
+  out[1] = CLAMP (1.0 - (m * (1.0 - k) + k), 0.0, 1.0);
+  out[2] = CLAMP (1.0 - (y * (1.0 - k) + k), 0.0, 1.0);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
+  GeglProperties *o   = GEGL_PROPERTIES (operation);
+  CmykPreviewLut *lut = o->user_data;
+  gint            r, g, b;
+
   gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
   gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+
+  if (! lut)
+    {
+      lut = g_new0 (CmykPreviewLut, 1);
+      lut->algorithm = -1;
+      o->user_data = lut;
+    }
+
+  /* Bake the algorithm only when it was changed */
+  if (lut->algorithm == o->algorithm)
+    return;
+
+  for (b = 0; b < CMYK_LUT_SIZE; b++)
+    for (g = 0; g < CMYK_LUT_SIZE; g++)
+      for (r = 0; r < CMYK_LUT_SIZE; r++)
+        {
+          gfloat rgb[3] = { (gfloat) r / (CMYK_LUT_SIZE - 1),
+                            (gfloat) g / (CMYK_LUT_SIZE - 1),
+                            (gfloat) b / (CMYK_LUT_SIZE - 1) };
+          gint   index  = ((b * CMYK_LUT_SIZE + g) * CMYK_LUT_SIZE + r) * 3;
+
+          cmyk_preview_color (o->algorithm, rgb, &lut->lut[index]);
+        }
+
+  lut->algorithm = o->algorithm;
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, g_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
 }
 
 static gboolean
@@ -61,106 +202,66 @@ process (GeglOperation *operation,
          gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
+  const gfloat *lut = ((CmykPreviewLut *) o->user_data)->lut;
   gfloat *in = in_buf;
   gfloat *out = out_buf;
 
-  /* Debug output to confirm processing */
-  g_print ("Processing %ld pixels in smooth.c with algorithm %d\n", n_pixels, o->algorithm);
+  /* Offsets of the neighbouring grid points along each axis */
+  const gint step_r = 3;
+  const gint step_g = CMYK_LUT_SIZE * 3;
+  const gint step_b = CMYK_LUT_SIZE * CMYK_LUT_SIZE * 3;
 
-  for (gint i = 0; i < n_pixels; i++)
+  for (glong i = 0; i < n_pixels; i++)
     {
-      /* Read RGB and alpha values */
-      gfloat r = in[0];
-      gfloat g = in[1];
-      gfloat b = in[2];
-      gfloat a = in[3];
+      gfloat pos[3], frac[3];
+      gint   cell[3];
 
-      gfloat c, m, y, k;
+      for (gint j = 0; j < 3; j++)
+        {
+          /* Written so NaN lands on 0 instead of indexing off the LUT */
+          pos[j]  = (in[j] > 0.0f ? MIN (in[j], 1.0f) : 0.0f) * (CMYK_LUT_SIZE - 1);
+          cell[j] = MIN ((gint) pos[j], CMYK_LUT_SIZE - 2);
+          frac[j] = pos[j] - cell[j];
+        }
 
-      /* Base RGB to CMY conversion */
-      c = 1.0 - r;
-      m = 1.0 - g;
-      y = 1.0 - b;
+      gfloat fr = frac[0], fg = frac[1], fb = frac[2];
+      gint   base = ((cell[2] * CMYK_LUT_SIZE + cell[1]) * CMYK_LUT_SIZE + cell[0]) * 3;
+      gint   first, second;
+      gfloat w0, w1, w2, w3;
 
-      switch (o->algorithm)
+      /* Tetrahedral interpolation: walk from the cell origin to its far
+       * corner along the axes in order of decreasing fraction. The
+       * tetrahedra split the cell where the channel order changes, which
+       * is also where k = min (c, m, y) switches channel. */
+      if (fr >= fg)
+        {
+          if (fg >= fb)
+            { first = step_r; second = step_r + step_g; w1 = fr - fg; w2 = fg - fb; w3 = fb; }
+          else if (fr >= fb)
+            { first = step_r; second = step_r + step_b; w1 = fr - fb; w2 = fb - fg; w3 = fg; }
+          else
+            { first = step_b; second = step_r + step_b; w1 = fb - fr; w2 = fr - fg; w3 = fg; }
+        }
+      else
         {
-        case CMYK_ORIGINAL:
-          /* Original: Slight amplification for visibility */
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001);
-          m = (m - k) / (1.0 - k + 0.0001);
-          y = (y - k) / (1.0 - k + 0.0001);
-          c = CLAMP (c * 1.1, 0.0, 1.0);
-          m = CLAMP (m * 1.1, 0.0, 1.0);
-          y = CLAMP (y * 1.1, 0.0, 1.0);
-          k = CLAMP (k * 0.9, 0.0, 1.0);
-          break;
-
-        case CMYK_VIBRANT_REDUCTION:
-          /* Vibrant Reduction: Reduce vibrancy to mimic CMYK gamut */
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001) * 0.8;
-          m = (m - k) / (1.0 - k + 0.0001) * 0.8;
-          y = (y - k) / (1.0 - k + 0.0001) * 0.8;
-          c = CLAMP (c, 0.0, 1.0);
-          m = CLAMP (m, 0.0, 1.0);
-          y = CLAMP (y, 0.0, 1.0);
-          break;
-
-        case CMYK_GAMUT_COMPRESSION:
-          /* Gamut Compression: Perceptual adjustment to fit CMYK gamut */
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001);
-          m = (m - k) / (1.0 - k + 0.0001);
-          y = (y - k) / (1.0 - k + 0.0001);
-          gfloat saturation = (c + m + y) / 3.0;
-          c = c * (1.0 - saturation * 0.3);
-          m = m * (1.0 - saturation * 0.3);
-          y = y * (1.0 - saturation * 0.3);
-          c = CLAMP (c, 0.0, 1.0);
-          m = CLAMP (m, 0.0, 1.0);
-          y = CLAMP (y, 0.0, 1.0);
-          break;
-
-        case CMYK_MATTE_PAPER:
-          /* Matte Paper: Simulate ink absorption, duller colors, lower contrast */
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001) * 0.75; /* Stronger vibrancy reduction */
-          m = (m - k) / (1.0 - k + 0.0001) * 0.75;
-          y = (y - k) / (1.0 - k + 0.0001) * 0.75;
-          k = k * 1.1; /* Slightly increase black to simulate ink spread */
-          k = CLAMP (k, 0.0, 1.0);
-          c = CLAMP (c, 0.0, 1.0);
-          m = CLAMP (m, 0.0, 1.0);
-          y = CLAMP (y, 0.0, 1.0);
-          break;
-
-        case CMYK_GLOSSY_PAPER:
-          /* Glossy Paper: Slightly higher contrast, still duller than RGB */
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001) * 0.85; /* Moderate vibrancy reduction */
-          m = (m - k) / (1.0 - k + 0.0001) * 0.85;
-          y = (y - k) / (1.0 - k + 0.0001) * 0.85;
-          k = k * 0.95; /* Slightly reduce black for higher contrast */
-          k = CLAMP (k, 0.0, 1.0);
-          c = CLAMP (c, 0.0, 1.0);
-          m = CLAMP (m, 0.0, 1.0);
-          y = CLAMP (y, 0.0, 1.0);
-          break;
-
-        default:
-          k = MIN (MIN (c, m), y);
-          c = (c - k) / (1.0 - k + 0.0001);
-          m = (m - k) / (1.0 - k + 0.0001);
-          y = (y - k) / (1.0 - k + 0.0001);
-          break;
+          if (fr >= fb)
+            { first = step_g; second = step_r + step_g; w1 = fg - fr; w2 = fr - fb; w3 = fb; }
+          else if (fg >= fb)
+            { first = step_g; second = step_g + step_b; w1 = fg - fb; w2 = fb - fr; w3 = fr; }
+          else
+            { first = step_b; second = step_g + step_b; w1 = fb - fg; w2 = fg - fr; w3 = fr; }
         }
+      w0 = 1.0f - w1 - w2 - w3;
+
+      const gfloat *c0 = &lut[base];
+      const gfloat *c1 = &lut[base + first];
+      const gfloat *c2 = &lut[base + second];
+      const gfloat *c3 = &lut[base + step_r + step_g + step_b];
 
-      /* Convert back to RGB for preview */
-      out[0] = CLAMP (1.0 - (c * (1.0 - k) + k), 0.0, 1.0);
-      out[1] = CLAMP (1.0 - (m * (1.0 - k) + k), 0.0, 1.0);
-      out[2] = CLAMP (1.0 - (y * (1.0 - k) + k), 0.0, 1.0);
-      out[3] = a; /* Preserve alpha */
+      out[0] = w0 * c0[0] + w1 * c1[0] + w2 * c2[0] + w3 * c3[0];
+      out[1] = w0 * c0[1] + w1 * c1[1] + w2 * c2[1] + w3 * c3[1];
+      out[2] = w0 * c0[2] + w1 * c1[2] + w2 * c2[2] + w3 * c3[2];
+      out[3] = in[3]; /* Preserve alpha */
 
       in += 4;
       out += 4;
@@ -175,6 +276,7 @@ gegl_op_class_init (GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
   GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
   operation_class->prepare = prepare;
   point_filter_class->process = process;
 
@@ -0,0 +1,117 @@
+/* This file is part of the LinuxBeaver GEGL plugins
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Block helpers for the point composer blend modes.
+ *
+ * The composers handle RGBA pixels in blocks of LB_BLEND_BLOCK with a
+ * fixed trip count and no branches, so the compiler vectorises them for
+ * whatever the build targets (SSE2, AVX2 or NEON). The pixels left over
+ * go through the op's scalar loop. Block loops run over the interleaved
+ * channels, alpha included, into a local array that cannot alias the
+ * buffers; lb_blend_store() then restores the destination alpha and
+ * copies the block out, which also keeps output and input sharing a
+ * buffer correct.
+ */
+
+#ifndef __LB_BLEND_H__
+#define __LB_BLEND_H__
+
+#include <math.h>
+#include <string.h>
+
+/* Pixels per vectorised block */
+#define LB_BLEND_BLOCK 64
+
+/* Destination moved towards the blended value by opacity */
+static inline gfloat
+lb_blend_mix (gfloat dest,
+              gfloat blended,
+              gfloat opacity)
+{
+  return dest + opacity * (blended - dest);
+}
+
+/* Copy a block blended over all channels to out with the destination alpha */
+static inline void
+lb_blend_store (const gfloat *in,
+                gfloat       *blended,
+                gfloat       *out)
+{
+  gint j;
+
+  for (j = 3; j < LB_BLEND_BLOCK * 4; j += 4)
+    blended[j] = in[j];
+
+  memcpy (out, blended, LB_BLEND_BLOCK * 4 * sizeof (gfloat));
+}
+
+/* Natural log of a positive normal x from its exponent and an atanh
+ * series of its mantissa; within 2e-6 of logf, and unlike the libm call
+ * it vectorises */
+static inline gfloat
+lb_blend_log (gfloat x)
+{
+  guint32 bits;
+  gfloat  mantissa, s, s2;
+  gint    exponent;
+
+  memcpy (&bits, &x, sizeof bits);
+  exponent = (gint) (bits >> 23) - 127;
+  bits     = (bits & 0x007fffffu) | 0x3f800000u;
+  memcpy (&mantissa, &bits, sizeof mantissa);
+
+  /* log (m) = 2 atanh (s) with s = (m - 1) / (m + 1) in [0, 1/3) */
+  s  = (mantissa - 1.0f) / (mantissa + 1.0f);
+  s2 = s * s;
+
+  return exponent * (gfloat) G_LN2 +
+         2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f + s2 * (1.0f / 9.0f)))));
+}
+
+/* e^x as a power of two times a polynomial in the remainder; within 1e-6
+ * relative of expf for |x| < 86, saturating beyond. The clamp is
+ * written with fabsf because a compare and select clamp keeps GCC from
+ * vectorising the loop around it. */
+static inline gfloat
+lb_blend_exp (gfloat x)
+{
+  gfloat  t = x * (gfloat) G_LOG_2_BASE_E;
+  gfloat  whole, f, p, scale;
+  guint32 bits;
+
+  t = 0.5f * (fabsf (t + 125.0f) - fabsf (t - 125.0f));
+
+  /* Round to nearest by adding and removing 1.5 * 2^23 */
+  whole = (t + 12582912.0f) - 12582912.0f;
+  f     = (t - whole) * (gfloat) G_LN2;
+
+  p = 1.0f + f * (1.0f + f * (1.0f / 2.0f + f * (1.0f / 6.0f + f * (1.0f / 24.0f +
+      f * (1.0f / 120.0f + f * (1.0f / 720.0f + f * (1.0f / 5040.0f)))))));
+
+  bits = (guint32) ((gint) whole + 127) << 23;
+  memcpy (&scale, &bits, sizeof scale);
+
+  return p * scale;
+}
+
+/* 1 / (1 + e^-x) */
+static inline gfloat
+lb_blend_logistic (gfloat x)
+{
+  return 1.0f / (1.0f + lb_blend_exp (-x));
+}
+
+#endif
@@ -0,0 +1,279 @@
+/* This file is part of the LinuxBeaver GEGL plugins
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Signed distance coverage for the pattern generators.
+ *
+ * Shapes report a signed distance in output pixels, negative inside and
+ * positive outside. lb_coverage() turns that into the fraction of the
+ * pixel covered by the shape, so a single evaluation per pixel gives a
+ * smooth edge without supersampling or a blur pass afterwards. With
+ * antialiasing off it degrades to the hard inside test the generators
+ * have always used.
+ */
+
+#ifndef __LB_COVERAGE_H__
+#define __LB_COVERAGE_H__
+
+#include <math.h>
+#include <string.h>
+
+static inline gfloat
+lb_coverage (gfloat   sd,
+             gboolean antialias)
+{
+  if (!antialias)
+    return sd <= 0.0f ? 1.0f : 0.0f;
+
+  return CLAMP (0.5f - sd, 0.0f, 1.0f);
+}
+
+/* Coverage of the condition a < b when (b - a) * scale measures pixels.
+ * Without antialiasing this is exactly the strict comparison. */
+static inline gfloat
+lb_coverage_less_scaled (gfloat   a,
+                         gfloat   b,
+                         gfloat   scale,
+                         gboolean antialias)
+{
+  if (!antialias)
+    return a < b ? 1.0f : 0.0f;
+
+  return lb_coverage ((a - b) * scale, TRUE);
+}
+
+static inline gfloat
+lb_coverage_less (gfloat   a,
+                  gfloat   b,
+                  gboolean antialias)
+{
+  return lb_coverage_less_scaled (a, b, 1.0f, antialias);
+}
+
+/* Coverage of value < width where value = fmod (x, period) for x >= 0;
+ * the edge where the modulo wraps back to zero is smoothed as well */
+static inline gfloat
+lb_coverage_band (gfloat   value,
+                  gfloat   width,
+                  gfloat   period,
+                  gboolean antialias)
+{
+  if (!antialias)
+    return value < width ? 1.0f : 0.0f;
+
+  if (value < width)
+    return lb_coverage (-MIN (value, width - value), TRUE);
+
+  return lb_coverage (MIN (value - width, period - value), TRUE);
+}
+
+static inline gfloat
+lb_sd_union (gfloat a,
+             gfloat b)
+{
+  return MIN (a, b);
+}
+
+static inline gfloat
+lb_sd_intersect (gfloat a,
+                 gfloat b)
+{
+  return MAX (a, b);
+}
+
+static inline gfloat
+lb_sd_subtract (gfloat a,
+                gfloat b)
+{
+  return MAX (a, -b);
+}
+
+/* Turn a filled shape into a band of the given width along its edge */
+static inline gfloat
+lb_sd_annulus (gfloat sd,
+               gfloat width)
+{
+  return fabsf (sd) - width * 0.5f;
+}
+
+static inline gfloat
+lb_sd_circle (gfloat px,
+              gfloat py,
+              gfloat cx,
+              gfloat cy,
+              gfloat radius)
+{
+  return hypotf (px - cx, py - cy) - radius;
+}
+
+/* Unsigned distance from (px, py) to the segment a-b */
+static inline gfloat
+lb_sd_segment (gfloat px,
+               gfloat py,
+               gfloat ax,
+               gfloat ay,
+               gfloat bx,
+               gfloat by)
+{
+  gfloat dx = bx - ax;
+  gfloat dy = by - ay;
+  gfloat len2 = dx * dx + dy * dy;
+  gfloat t = 0.0f;
+
+  if (len2 > 0.0f)
+    t = CLAMP (((px - ax) * dx + (py - ay) * dy) / len2, 0.0f, 1.0f);
+
+  return hypotf (px - (ax + t * dx), py - (ay + t * dy));
+}
+
+/* Closed polygon with n vertices packed as x0, y0, x1, y1, ...
+ * Inside follows the even-odd rule. */
+static inline gfloat
+lb_sd_polygon (gfloat        px,
+               gfloat        py,
+               const gfloat *xy,
+               gint          n)
+{
+  gfloat   dist = G_MAXFLOAT;
+  gboolean inside = FALSE;
+  gint     i, j;
+
+  for (i = 0, j = n - 1; i < n; j = i++)
+    {
+      gfloat x1 = xy[j * 2];
+      gfloat y1 = xy[j * 2 + 1];
+      gfloat x2 = xy[i * 2];
+      gfloat y2 = xy[i * 2 + 1];
+
+      dist = MIN (dist, lb_sd_segment (px, py, x1, y1, x2, y2));
+
+      if (((y1 > py) != (y2 > py)) &&
+          (px < (x2 - x1) * (py - y1) / (y2 - y1) + x1))
+        inside = !inside;
+    }
+
+  return inside ? -dist : dist;
+}
+
+static inline gfloat
+lb_sd_triangle (gfloat px,
+                gfloat py,
+                gfloat x1,
+                gfloat y1,
+                gfloat x2,
+                gfloat y2,
+                gfloat x3,
+                gfloat y3)
+{
+  const gfloat xy[6] = { x1, y1, x2, y2, x3, y3 };
+
+  return lb_sd_polygon (px, py, xy, 3);
+}
+
+/* Diamond |x| + |y| <= radius around the origin */
+static inline gfloat
+lb_sd_diamond (gfloat x,
+               gfloat y,
+               gfloat radius)
+{
+  return (fabsf (x) + fabsf (y) - radius) * 0.70710678f;
+}
+
+/* Square of half size half_size around the origin */
+static inline gfloat
+lb_sd_box (gfloat x,
+           gfloat y,
+           gfloat half_size)
+{
+  gfloat dx = fabsf (x) - half_size;
+  gfloat dy = fabsf (y) - half_size;
+
+  return hypotf (MAX (dx, 0.0f), MAX (dy, 0.0f)) + MIN (MAX (dx, dy), 0.0f);
+}
+
+/* First order distance estimate for an implicit shape f <= 0, given the
+ * value of f and its gradient in pixel units */
+static inline gfloat
+lb_sd_implicit (gfloat value,
+                gfloat grad_x,
+                gfloat grad_y)
+{
+  gfloat grad = hypotf (grad_x, grad_y);
+
+  return value / MAX (grad, 1e-6f);
+}
+
+/* Composite rgb with the given coverage over a straight alpha RGBA pixel */
+static inline void
+lb_coverage_over (gfloat       *pixel,
+                  const gfloat *rgb,
+                  gfloat        coverage)
+{
+  gfloat alpha = coverage + pixel[3] * (1.0f - coverage);
+  gint   c;
+
+  if (coverage <= 0.0f)
+    return;
+
+  if (coverage >= 1.0f || alpha <= 0.0f)
+    {
+      pixel[0] = rgb[0];
+      pixel[1] = rgb[1];
+      pixel[2] = rgb[2];
+      pixel[3] = alpha;
+      return;
+    }
+
+  for (c = 0; c < 3; c++)
+    pixel[c] = (rgb[c] * coverage + pixel[c] * pixel[3] * (1.0f - coverage)) / alpha;
+  pixel[3] = alpha;
+}
+
+/* Replace a straight alpha RGBA pixel by rgba where the coverage is full,
+ * fading between the two in premultiplied space across the edge */
+static inline void
+lb_coverage_mix (gfloat       *pixel,
+                 const gfloat *rgba,
+                 gfloat        coverage)
+{
+  gfloat alpha;
+  gint   c;
+
+  if (coverage <= 0.0f)
+    return;
+
+  if (coverage >= 1.0f)
+    {
+      memcpy (pixel, rgba, 4 * sizeof (gfloat));
+      return;
+    }
+
+  alpha = pixel[3] * (1.0f - coverage) + rgba[3] * coverage;
+
+  if (alpha <= 0.0f)
+    {
+      pixel[0] = rgba[0];
+      pixel[1] = rgba[1];
+      pixel[2] = rgba[2];
+      pixel[3] = 0.0f;
+      return;
+    }
+
+  for (c = 0; c < 3; c++)
+    pixel[c] = (pixel[c] * pixel[3] * (1.0f - coverage) + rgba[c] * rgba[3] * coverage) / alpha;
+  pixel[3] = alpha;
+}
+
+#endif
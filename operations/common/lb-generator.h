@@ -0,0 +1,109 @@
+/* This file is part of the LinuxBeaver GEGL plugins
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Generator mode for ops that draw without reading their input.
+ *
+ * The generators keep an input pad so they slot into a filter stack and
+ * can size themselves from the canvas, but none of them looks at an
+ * input pixel. Asking for an empty region of the input keeps GEGL from
+ * rendering and converting the upstream graph for every chunk, and
+ * lb_generator_process() walks only the output buffer, handing each
+ * piece to a render callback shaped like a point filter's process
+ * without the input buffer.
+ *
+ * A flat pattern bound for an 8 bit or half float image does not need
+ * four floats per pixel in the cache. GEGL does not tell an op what its
+ * consumer wants, so lb_generator_set_format() takes the precision of
+ * the input canvas as the stand-in and stores the output as R'G'B'A u8
+ * or RGBA half to match. The render callbacks still draw in float: the
+ * buffer iterator hands them a chunk sized float scratch and babl packs
+ * each chunk into the narrower tiles as it is released. Generators that
+ * can write the output format directly, like the checkerboard, skip that
+ * pack.
+ */
+
+#ifndef __LB_GENERATOR_H__
+#define __LB_GENERATOR_H__
+
+typedef gboolean (* LbGeneratorRender) (GeglOperation       *operation,
+                                        void                *out_buf,
+                                        glong                n_pixels,
+                                        const GeglRectangle *roi,
+                                        gint                 level);
+
+/* Only the input's bounding box is used, never its pixels */
+static inline GeglRectangle
+lb_generator_get_required_for_output (GeglOperation       *operation,
+                                      const gchar         *input_pad,
+                                      const GeglRectangle *roi)
+{
+  GeglRectangle empty = { 0, 0, 0, 0 };
+
+  return empty;
+}
+
+/* Set the output to R'G'B'A u8 or RGBA half when the input canvas is
+ * stored at that precision and to render_format otherwise. render_format
+ * is the RGBA float format the op draws in and also lends its space. */
+static inline void
+lb_generator_set_format (GeglOperation *operation,
+                         const Babl    *render_format)
+{
+  const Babl *source = gegl_operation_get_source_format (operation, "input");
+  const Babl *format = render_format;
+
+  if (source)
+    {
+      const Babl *type = babl_format_get_type (source, 0);
+
+      if (type == babl_type ("u8"))
+        format = babl_format_with_space ("R'G'B'A u8", render_format);
+      else if (type == babl_type ("half"))
+        format = babl_format_with_space ("RGBA half", render_format);
+    }
+
+  gegl_operation_set_format (operation, "output", format);
+}
+
+/* RGBA float in the space of the output, whatever its precision */
+static inline const Babl *
+lb_generator_render_format (GeglOperation *operation)
+{
+  return babl_format_with_space ("RGBA float",
+                                 gegl_operation_get_format (operation, "output"));
+}
+
+static inline gboolean
+lb_generator_process (GeglOperation       *operation,
+                      GeglBuffer          *output,
+                      const GeglRectangle *result,
+                      gint                 level,
+                      LbGeneratorRender    render)
+{
+  const Babl         *format = lb_generator_render_format (operation);
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (output, result, level, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
+    render (operation, iter->items[0].data, iter->length,
+            &iter->items[0].roi, level);
+
+  return TRUE;
+}
+
+#endif
@@ -0,0 +1,209 @@
+/* This file is part of the LinuxBeaver GEGL plugins
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Lattice hash and 2D gradient noise shared by the generators.
+ *
+ * Everything is keyed on integer lattice points and a seed, so results do
+ * not depend on how a region is split into chunks or threads. The hash is
+ * an integer avalanche mix, giving 24 bits of randomness per float instead
+ * of the few hundred levels of the old per-op hashes. Gradients come from
+ * a fixed table, so no noise function calls trigonometry per sample, and
+ * none of them branch, which keeps loops over them vectorisable.
+ */
+
+#ifndef __LB_NOISE_H__
+#define __LB_NOISE_H__
+
+#include <math.h>
+
+/* Unit gradients at multiples of 45 degrees */
+static const gfloat lb_noise_gradients[8][2] =
+{
+  {  1.0f,        0.0f        },
+  {  0.70710678f, 0.70710678f },
+  {  0.0f,        1.0f        },
+  { -0.70710678f, 0.70710678f },
+  { -1.0f,        0.0f        },
+  { -0.70710678f, -0.70710678f },
+  {  0.0f,        -1.0f       },
+  {  0.70710678f, -0.70710678f },
+};
+
+static inline guint32
+lb_noise_hash (gint    x,
+               gint    y,
+               guint32 seed)
+{
+  guint32 h = (guint32) x * 0x8da6b343u ^ (guint32) y * 0xd8163841u ^ seed * 0xcb1ab31fu;
+
+  h ^= h >> 16;
+  h *= 0x7feb352du;
+  h ^= h >> 15;
+  h *= 0x846ca68bu;
+  h ^= h >> 16;
+
+  return h;
+}
+
+/* Uniform float in [0, 1) for a lattice point */
+static inline gfloat
+lb_noise_hash_float (gint    x,
+                     gint    y,
+                     guint32 seed)
+{
+  return (lb_noise_hash (x, y, seed) >> 8) * (1.0f / 16777216.0f);
+}
+
+static inline gint
+lb_noise_floor (gfloat v)
+{
+  gint i = (gint) v;
+
+  return i - (v < (gfloat) i);
+}
+
+/* Quintic fade, continuous up to the second derivative across cells */
+static inline gfloat
+lb_noise_fade (gfloat t)
+{
+  return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+static inline gfloat
+lb_noise_gradient_dot (gint    x,
+                       gint    y,
+                       guint32 seed,
+                       gfloat  dx,
+                       gfloat  dy)
+{
+  const gfloat *g = lb_noise_gradients[lb_noise_hash (x, y, seed) >> 29];
+
+  return g[0] * dx + g[1] * dy;
+}
+
+/* Value noise in [0, 1] */
+static inline gfloat
+lb_noise_value2 (gfloat  x,
+                 gfloat  y,
+                 guint32 seed)
+{
+  gint   xi = lb_noise_floor (x);
+  gint   yi = lb_noise_floor (y);
+  gfloat u  = lb_noise_fade (x - xi);
+  gfloat v  = lb_noise_fade (y - yi);
+
+  gfloat v00 = lb_noise_hash_float (xi,     yi,     seed);
+  gfloat v10 = lb_noise_hash_float (xi + 1, yi,     seed);
+  gfloat v01 = lb_noise_hash_float (xi,     yi + 1, seed);
+  gfloat v11 = lb_noise_hash_float (xi + 1, yi + 1, seed);
+
+  gfloat nx0 = v00 + u * (v10 - v00);
+  gfloat nx1 = v01 + u * (v11 - v01);
+
+  return nx0 + v * (nx1 - nx0);
+}
+
+/* Perlin gradient noise in about [-0.7, 0.7], zero on lattice points */
+static inline gfloat
+lb_noise_perlin2 (gfloat  x,
+                  gfloat  y,
+                  guint32 seed)
+{
+  gint   xi = lb_noise_floor (x);
+  gint   yi = lb_noise_floor (y);
+  gfloat xf = x - xi;
+  gfloat yf = y - yi;
+  gfloat u  = lb_noise_fade (xf);
+  gfloat v  = lb_noise_fade (yf);
+
+  gfloat d00 = lb_noise_gradient_dot (xi,     yi,     seed, xf,        yf);
+  gfloat d10 = lb_noise_gradient_dot (xi + 1, yi,     seed, xf - 1.0f, yf);
+  gfloat d01 = lb_noise_gradient_dot (xi,     yi + 1, seed, xf,        yf - 1.0f);
+  gfloat d11 = lb_noise_gradient_dot (xi + 1, yi + 1, seed, xf - 1.0f, yf - 1.0f);
+
+  gfloat nx0 = d00 + u * (d10 - d00);
+  gfloat nx1 = d01 + u * (d11 - d01);
+
+  return nx0 + v * (nx1 - nx0);
+}
+
+/* Simplex noise in about [-1, 1]; three corners per sample instead of four
+ * and no axis-aligned artefacts */
+static inline gfloat
+lb_noise_simplex2 (gfloat  x,
+                   gfloat  y,
+                   guint32 seed)
+{
+  const gfloat F2 = 0.36602540f; /* (sqrt (3) - 1) / 2 */
+  const gfloat G2 = 0.21132487f; /* (3 - sqrt (3)) / 6 */
+
+  gfloat skew = (x + y) * F2;
+  gint   i    = lb_noise_floor (x + skew);
+  gint   j    = lb_noise_floor (y + skew);
+  gfloat t    = (i + j) * G2;
+  gfloat x0   = x - (i - t);
+  gfloat y0   = y - (j - t);
+
+  /* Pick the triangle of the skewed cell the point falls in */
+  gint   i1 = x0 > y0;
+  gint   j1 = 1 - i1;
+  gfloat x1 = x0 - i1 + G2;
+  gfloat y1 = y0 - j1 + G2;
+  gfloat x2 = x0 - 1.0f + 2.0f * G2;
+  gfloat y2 = y0 - 1.0f + 2.0f * G2;
+
+  gfloat t0 = MAX (0.5f - x0 * x0 - y0 * y0, 0.0f);
+  gfloat t1 = MAX (0.5f - x1 * x1 - y1 * y1, 0.0f);
+  gfloat t2 = MAX (0.5f - x2 * x2 - y2 * y2, 0.0f);
+
+  t0 *= t0;
+  t1 *= t1;
+  t2 *= t2;
+
+  return 99.0f * (t0 * t0 * lb_noise_gradient_dot (i,      j,      seed, x0, y0) +
+                  t1 * t1 * lb_noise_gradient_dot (i + i1, j + j1, seed, x1, y1) +
+                  t2 * t2 * lb_noise_gradient_dot (i + 1,  j + 1,  seed, x2, y2));
+}
+
+/* Fractal sum of Perlin octaves, each at lacunarity times the frequency
+ * and gain times the amplitude of the previous one, normalised back to the
+ * range of a single octave */
+static inline gfloat
+lb_noise_fbm2 (gfloat  x,
+               gfloat  y,
+               guint32 seed,
+               gint    octaves,
+               gfloat  lacunarity,
+               gfloat  gain)
+{
+  gfloat sum       = 0.0f;
+  gfloat amplitude = 1.0f;
+  gfloat total     = 0.0f;
+  gint   octave;
+
+  for (octave = 0; octave < octaves; octave++)
+    {
+      sum       += amplitude * lb_noise_perlin2 (x, y, seed + octave);
+      total     += amplitude;
+      amplitude *= gain;
+      x         *= lacunarity;
+      y         *= lacunarity;
+    }
+
+  return total > 0.0f ? sum / total : 0.0f;
+}
+
+#endif
@@ -0,0 +1,218 @@
+/* This file is part of the LinuxBeaver GEGL plugins
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Uniform grid index over a set of line segments.
+ *
+ * Generators that draw strokes as "distance to the nearest segment is at
+ * most r" only ever need the segments within r of a pixel. The grid keeps,
+ * for every cell, the segments that come within r of some point of the
+ * cell, so a query reads a single cell and stays exact for distances up
+ * to r. Segments are stored as parallel arrays; the per cell lists are
+ * one offsets array into one index array.
+ */
+
+#ifndef __LB_SEGMENT_GRID_H__
+#define __LB_SEGMENT_GRID_H__
+
+#include <math.h>
+
+typedef struct
+{
+  gint    n_segments;
+  gfloat *data;
+  gfloat *x1;
+  gfloat *y1;
+  gfloat *dx;
+  gfloat *dy;
+  gfloat *inv_length_sq;
+
+  gint    grid_size;
+  gfloat  grid_x;
+  gfloat  grid_y;
+  gfloat  inv_cell_size;
+  guint  *cell_start;
+  guint  *cell_segments;
+} LbSegmentGrid;
+
+/* Squared distance from (x, y) to segment s */
+static inline gfloat
+lb_segment_grid_distance_squared (const LbSegmentGrid *grid,
+                                  guint                s,
+                                  gfloat               x,
+                                  gfloat               y)
+{
+  gfloat dx    = grid->dx[s];
+  gfloat dy    = grid->dy[s];
+  gfloat rel_x = x - grid->x1[s];
+  gfloat rel_y = y - grid->y1[s];
+  gfloat t     = CLAMP ((rel_x * dx + rel_y * dy) * grid->inv_length_sq[s], 0.0f, 1.0f);
+
+  rel_x -= t * dx;
+  rel_y -= t * dy;
+
+  return rel_x * rel_x + rel_y * rel_y;
+}
+
+/* Range of cell_segments holding every segment within reach of (x, y);
+ * FALSE when no segment is that close */
+static inline gboolean
+lb_segment_grid_lookup (const LbSegmentGrid *grid,
+                        gfloat               x,
+                        gfloat               y,
+                        guint               *first,
+                        guint               *last)
+{
+  gfloat gx = (x - grid->grid_x) * grid->inv_cell_size;
+  gfloat gy = (y - grid->grid_y) * grid->inv_cell_size;
+  gint   cell;
+
+  if (!(gx >= 0.0f && gy >= 0.0f && gx < grid->grid_size && gy < grid->grid_size))
+    return FALSE;
+
+  cell   = (gint) gy * grid->grid_size + (gint) gx;
+  *first = grid->cell_start[cell];
+  *last  = grid->cell_start[cell + 1];
+
+  return *first < *last;
+}
+
+/* Build the index for n segments packed as x1, y1, x2, y2, ... over a
+ * grid_size x grid_size grid; queries are exact up to distance reach.
+ * Degenerate segments are dropped. */
+static inline LbSegmentGrid *
+lb_segment_grid_new (const gfloat *segments,
+                     gint          n,
+                     gfloat        reach,
+                     gint          grid_size)
+{
+  LbSegmentGrid *grid    = g_new0 (LbSegmentGrid, 1);
+  gint           n_cells = grid_size * grid_size;
+  gfloat         min_x = G_MAXFLOAT, min_y = G_MAXFLOAT;
+  gfloat         max_x = -G_MAXFLOAT, max_y = -G_MAXFLOAT;
+  gfloat         cell_size, cell_reach;
+  guint         *fill = NULL;
+  gint           count = 0;
+  gint           i, pass;
+
+  grid->data          = g_new (gfloat, 5 * MAX (n, 1));
+  grid->x1            = grid->data;
+  grid->y1            = grid->x1 + n;
+  grid->dx            = grid->y1 + n;
+  grid->dy            = grid->dx + n;
+  grid->inv_length_sq = grid->dy + n;
+
+  for (i = 0; i < n; i++)
+    {
+      const gfloat *seg = segments + i * 4;
+      gfloat        dx  = seg[2] - seg[0];
+      gfloat        dy  = seg[3] - seg[1];
+      gfloat        length_sq = dx * dx + dy * dy;
+
+      if (length_sq < 1e-12f)
+        continue;
+
+      grid->x1[count]            = seg[0];
+      grid->y1[count]            = seg[1];
+      grid->dx[count]            = dx;
+      grid->dy[count]            = dy;
+      grid->inv_length_sq[count] = 1.0f / length_sq;
+      count++;
+
+      min_x = MIN (min_x, MIN (seg[0], seg[2]));
+      min_y = MIN (min_y, MIN (seg[1], seg[3]));
+      max_x = MAX (max_x, MAX (seg[0], seg[2]));
+      max_y = MAX (max_y, MAX (seg[1], seg[3]));
+    }
+  grid->n_segments = count;
+
+  if (count == 0)
+    {
+      min_x = min_y = 0.0f;
+      max_x = max_y = 1.0f;
+    }
+
+  /* Square cells covering the segments grown by reach */
+  cell_size  = MAX (MAX (max_x - min_x, max_y - min_y) + 2.0f * reach, 1e-6f) / grid_size;
+  cell_reach = reach + cell_size * (gfloat) G_SQRT2 * 0.5f;
+
+  grid->grid_size     = grid_size;
+  grid->grid_x        = min_x - reach;
+  grid->grid_y        = min_y - reach;
+  grid->inv_cell_size = 1.0f / cell_size;
+  grid->cell_start    = g_new0 (guint, n_cells + 1);
+
+  /* Count the segments of every cell, then fill the lists */
+  for (pass = 0; pass < 2; pass++)
+    {
+      if (pass == 1)
+        {
+          for (i = 0; i < n_cells; i++)
+            grid->cell_start[i + 1] += grid->cell_start[i];
+
+          grid->cell_segments = g_new (guint, MAX (grid->cell_start[n_cells], 1));
+          fill = g_new (guint, n_cells);
+          for (i = 0; i < n_cells; i++)
+            fill[i] = grid->cell_start[i];
+        }
+
+      for (i = 0; i < count; i++)
+        {
+          gfloat x1 = grid->x1[i];
+          gfloat y1 = grid->y1[i];
+          gfloat x2 = x1 + grid->dx[i];
+          gfloat y2 = y1 + grid->dy[i];
+          gint   cx0 = CLAMP ((gint) ((MIN (x1, x2) - reach - grid->grid_x) * grid->inv_cell_size), 0, grid_size - 1);
+          gint   cx1 = CLAMP ((gint) ((MAX (x1, x2) + reach - grid->grid_x) * grid->inv_cell_size), 0, grid_size - 1);
+          gint   cy0 = CLAMP ((gint) ((MIN (y1, y2) - reach - grid->grid_y) * grid->inv_cell_size), 0, grid_size - 1);
+          gint   cy1 = CLAMP ((gint) ((MAX (y1, y2) + reach - grid->grid_y) * grid->inv_cell_size), 0, grid_size - 1);
+          gint   gx, gy;
+
+          for (gy = cy0; gy <= cy1; gy++)
+            for (gx = cx0; gx <= cx1; gx++)
+              {
+                gfloat centre_x = grid->grid_x + (gx + 0.5f) * cell_size;
+                gfloat centre_y = grid->grid_y + (gy + 0.5f) * cell_size;
+                gint   cell     = gy * grid_size + gx;
+
+                if (lb_segment_grid_distance_squared (grid, i, centre_x, centre_y) > cell_reach * cell_reach)
+                  continue;
+
+                if (pass == 0)
+                  grid->cell_start[cell + 1]++;
+                else
+                  grid->cell_segments[fill[cell]++] = i;
+              }
+        }
+    }
+
+  g_free (fill);
+
+  return grid;
+}
+
+static inline void
+lb_segment_grid_free (LbSegmentGrid *grid)
+{
+  if (!grid)
+    return;
+
+  g_free (grid->data);
+  g_free (grid->cell_start);
+  g_free (grid->cell_segments);
+  g_free (grid);
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -126,98 +127,121 @@ property_double (rotate, _("Rotate"), 0.0)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     concentric_shapes
 #define GEGL_OP_C_SOURCE concentric-shapes.c
 
 #include "gegl-op.h"
 
+// Shape outline with the rotation and polygon axes resolved once per
+// process() call, so the per-pixel work is a few multiplies
+typedef struct
+{
+  GeglConcentricShapeType3501 shape_type;
+  gfloat inv_skew;
+  gfloat cos_rot;
+  gfloat sin_rot;
+  gint   n_axes;
+  gfloat axis_cos[5];
+  gfloat axis_sin[5];
+  gfloat axis_scale;
+} ConcentricShape;
+
 // Function prototypes
 static void prepare (GeglOperation *operation);
-static gboolean process (GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level);
-static gboolean is_point_in_shape (gfloat x, gfloat y, gfloat radius, GeglConcentricShapeType3501 shape_type, gfloat rotate_angle, gfloat skew);
+static gboolean render (GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level);
+static void concentric_shape_init (ConcentricShape *shape, GeglConcentricShapeType3501 shape_type, gfloat rotate_angle, gfloat skew);
+static gfloat shape_radius_at (const ConcentricShape *shape, gfloat x, gfloat y);
 
-static gboolean
-is_point_in_shape (gfloat x, gfloat y, gfloat radius, GeglConcentricShapeType3501 shape_type, gfloat rotate_angle, gfloat skew)
+static void
+concentric_shape_init (ConcentricShape *shape, GeglConcentricShapeType3501 shape_type, gfloat rotate_angle, gfloat skew)
 {
-  // Apply skew by stretching the x-coordinate
-  gfloat skewed_x = x / skew;
-
   // Convert rotation angle from degrees to radians
   gfloat angle_rad = rotate_angle * G_PI / 180.0;
 
-  // Rotate the point (skewed_x, y) by -angle_rad to simulate rotating the shape by angle_rad
-  gfloat rotated_x = skewed_x * cos(angle_rad) + y * sin(angle_rad);
-  gfloat rotated_y = -skewed_x * sin(angle_rad) + y * cos(angle_rad);
-
-  gfloat angle = atan2(rotated_y, rotated_x);
-  if (angle < 0) angle += 2.0 * G_PI;
-  gfloat dist = sqrt(rotated_x * rotated_x + rotated_y * rotated_y);
+  shape->shape_type = shape_type;
+  shape->inv_skew = 1.0 / skew;
+  shape->cos_rot = cos(angle_rad);
+  shape->sin_rot = sin(angle_rad);
+  shape->n_axes = 0;
+  shape->axis_scale = 1.0;
 
   switch (shape_type)
   {
-    case GEGL_CONCENTRIC_SHAPE_CIRCLE:
-      return dist <= radius;
+    case GEGL_CONCENTRIC_SHAPE_HEXAGON:  shape->n_axes = 3; break;
+    case GEGL_CONCENTRIC_SHAPE_OCTAGON:  shape->n_axes = 4; break;
+    case GEGL_CONCENTRIC_SHAPE_DECAGON:  shape->n_axes = 5; break;
+    default: break;
+  }
 
-    case GEGL_CONCENTRIC_SHAPE_SQUARE:
+  if (shape->n_axes > 0)
+  {
+    // Opposite sides share an axis because the projection is taken absolute
+    gint sides = shape->n_axes * 2;
+    gfloat angle_increment = 2.0 * G_PI / sides;
+    for (gint i = 0; i < shape->n_axes; i++)
     {
-      gfloat abs_x = fabs(rotated_x);
-      gfloat abs_y = fabs(rotated_y);
-      return MAX(abs_x, abs_y) <= radius;
+      shape->axis_cos[i] = cos(i * angle_increment);
+      shape->axis_sin[i] = sin(i * angle_increment);
     }
+    shape->axis_scale = cos(G_PI / sides);
+  }
+}
+
+// Radius of the concentric outline passing through (x, y). Every shape is
+// a scaled copy of the same outline, so a point is inside the shape of
+// radius r exactly when this value is at most r.
+static gfloat
+shape_radius_at (const ConcentricShape *shape, gfloat x, gfloat y)
+{
+  // Apply skew by stretching the x-coordinate
+  gfloat skewed_x = x * shape->inv_skew;
+
+  // Rotate the point (skewed_x, y) by -angle_rad to simulate rotating the shape by angle_rad
+  gfloat rotated_x = skewed_x * shape->cos_rot + y * shape->sin_rot;
+  gfloat rotated_y = -skewed_x * shape->sin_rot + y * shape->cos_rot;
+
+  switch (shape->shape_type)
+  {
+    case GEGL_CONCENTRIC_SHAPE_CIRCLE:
+      return sqrt(rotated_x * rotated_x + rotated_y * rotated_y);
+
+    case GEGL_CONCENTRIC_SHAPE_SQUARE:
+      return MAX(fabs(rotated_x), fabs(rotated_y));
 
     case GEGL_CONCENTRIC_SHAPE_DIAMOND:
-    {
-      gfloat abs_x = fabs(rotated_x);
-      gfloat abs_y = fabs(rotated_y);
-      return (abs_x + abs_y) <= radius * sqrt(2.0);
-    }
+      return (fabs(rotated_x) + fabs(rotated_y)) * (gfloat) M_SQRT1_2;
 
     case GEGL_CONCENTRIC_SHAPE_HEXAGON:
     case GEGL_CONCENTRIC_SHAPE_OCTAGON:
     case GEGL_CONCENTRIC_SHAPE_DECAGON:
     {
-      gint sides;
-      if (shape_type == GEGL_CONCENTRIC_SHAPE_HEXAGON)
-        sides = 6;
-      else if (shape_type == GEGL_CONCENTRIC_SHAPE_OCTAGON)
-        sides = 8;
-      else // GEGL_CONCENTRIC_SHAPE_DECAGON
-        sides = 10;
-
-      gfloat angle_increment = 2.0 * G_PI / sides;
       gfloat max_dist = 0.0;
-      for (gint i = 0; i < sides; i++)
+      for (gint i = 0; i < shape->n_axes; i++)
       {
-        gfloat axis_angle = i * angle_increment;
-        gfloat projection = fabs(rotated_x * cos(axis_angle) + rotated_y * sin(axis_angle));
-        if (projection > max_dist)
-          max_dist = projection;
+        gfloat projection = fabs(rotated_x * shape->axis_cos[i] + rotated_y * shape->axis_sin[i]);
+        max_dist = MAX(max_dist, projection);
       }
-      gfloat side_angle = G_PI / sides;
-      gfloat scale_factor = 1.0 / cos(side_angle);
-      return max_dist <= radius * scale_factor;
+      return max_dist * shape->axis_scale;
     }
 
     default:
-      return FALSE;
+      return 0.0;
   }
 }
 
 static void
 prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static gboolean
-process (GeglOperation       *operation,
-         void               *in_buf,
-         void               *out_buf,
-         glong               n_pixels,
-         const GeglRectangle *roi,
-         gint                level)
+render (GeglOperation       *operation,
+        void               *out_buf,
+        glong               n_pixels,
+        const GeglRectangle *roi,
+        gint                level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out_pixel = (gfloat *) out_buf;
@@ -253,6 +277,10 @@ process (GeglOperation       *operation,
     default: num_colors = 5;
   }
 
+  ConcentricShape shape;
+  concentric_shape_init(&shape, o->shape_type, o->rotate, o->skew);
+  gfloat ring_width = o->shape_spacing * o->shape_thickness;
+
   for (glong i = 0; i < n_pixels; i++)
   {
     gint x = (i % roi->width) + roi->x;
@@ -260,23 +288,14 @@ process (GeglOperation       *operation,
 
     gfloat dx = x - cx;
     gfloat dy = y - cy;
-    gfloat dist = sqrt(dx * dx + dy * dy);
 
     gfloat *color = c1; // Default to the first color to ensure no background
-    gint color_index = 0;
 
-    // Find the innermost shape that contains the point
-    for (gint shape_index = 0; ; shape_index++)
-    {
-      gfloat radius = (shape_index + 1) * o->shape_spacing * o->shape_thickness;
-      if (is_point_in_shape(dx, dy, radius, o->shape_type, o->rotate, o->skew))
-      {
-        color_index = shape_index % num_colors;
-        break;
-      }
-      if (radius > dist + o->shape_spacing * o->shape_thickness)
-        break;
-    }
+    // The innermost containing shape is the first whose radius
+    // (shape_index + 1) * ring_width reaches the outline through the point
+    gfloat ring = shape_radius_at(&shape, dx, dy) / ring_width;
+    gint shape_index = MAX((gint) ceil(ring) - 1, 0);
+    gint color_index = shape_index % num_colors;
 
     // Assign the color based on the color_index
     switch (color_index)
@@ -303,14 +322,26 @@ process (GeglOperation       *operation,
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name", "ai/lb:concentric-shapes",
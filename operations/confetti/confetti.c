@@ -24,6 +24,7 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <string.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -76,7 +77,7 @@ property_double (density, _("Confetti Density"), 5.0)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     confetti
 #define GEGL_OP_C_SOURCE confetti.c
 
@@ -85,16 +86,89 @@ property_double (density, _("Confetti Density"), 5.0)
 // Structure for a confetti piece
 typedef struct {
   gdouble x, y;         // Center position
-  gdouble angle;        // Rotation in radians
-  gfloat color[4];      // RGBA color
+  gfloat cos_a, sin_a;  // Rotation into confetti-local coordinates
+  gfloat min_x, min_y;  // Bounding box of the rotated rectangle
+  gfloat max_x, max_y;
+  gint color;           // Index into the confetti colors
 } ConfettiPiece;
 
+#define CONFETTI_NUM_COLORS 7
+#define CONFETTI_MAX_PIECES 15 // Cap per tile for performance
+
+// Every piece of the tiles around a region, generated once per process()
+// call in tile order; pieces of tile t are pieces[tile_start[t]] up to
+// pieces[tile_start[t + 1]]
+typedef struct {
+  gint tile_x0, tile_y0;
+  gint tiles_x, tiles_y;
+  gint *tile_start;
+  ConfettiPiece *pieces;
+} ConfettiTiles;
+
+static void
+confetti_tiles_init(ConfettiTiles *tiles, GeglProperties *o, const GeglRectangle *roi, gfloat canvas_width)
+{
+  gfloat tile_size = o->tile_size;
+  gfloat half_length = o->confetti_length / 2.0;
+  gfloat half_width = o->confetti_width / 2.0;
+  gfloat density = o->density;
+  GRand *rand = g_rand_new_with_seed(o->seed);
+
+  // Pixels look at the tiles next to their own, so cover one extra ring
+  tiles->tile_x0 = (gint)floorf(roi->x / tile_size) - 1;
+  tiles->tile_y0 = (gint)floorf(roi->y / tile_size) - 1;
+  tiles->tiles_x = (gint)floorf((roi->x + roi->width - 1) / tile_size) + 2 - tiles->tile_x0;
+  tiles->tiles_y = (gint)floorf((roi->y + roi->height - 1) / tile_size) + 2 - tiles->tile_y0;
+
+  gint n_tiles = tiles->tiles_x * tiles->tiles_y;
+  tiles->tile_start = g_new(gint, n_tiles + 1);
+  tiles->pieces = g_new(ConfettiPiece, n_tiles * CONFETTI_MAX_PIECES);
+  tiles->tile_start[0] = 0;
+
+  for (gint t = 0; t < n_tiles; t++) {
+    gint tx = tiles->tile_x0 + t / tiles->tiles_y;
+    gint ty = tiles->tile_y0 + t % tiles->tiles_y;
+    guint tile_seed = (tx + ty * (gint)(canvas_width / tile_size)) ^ o->seed;
+    g_rand_set_seed(rand, tile_seed);
+
+    gint num_pieces = g_rand_int_range(rand, (gint)density / 2, (gint)density + 1);
+    num_pieces = MIN(num_pieces, CONFETTI_MAX_PIECES);
+
+    ConfettiPiece *piece = tiles->pieces + tiles->tile_start[t];
+    for (gint j = 0; j < num_pieces; j++, piece++) {
+      piece->x = g_rand_double_range(rand, 0.0, tile_size) + tx * tile_size;
+      piece->y = g_rand_double_range(rand, 0.0, tile_size) + ty * tile_size;
+      gdouble angle = g_rand_double_range(rand, 0.0, 2.0 * G_PI);
+      piece->color = g_rand_int_range(rand, 0, CONFETTI_NUM_COLORS);
+
+      piece->cos_a = cosf(-angle);
+      piece->sin_a = sinf(-angle);
+
+      gfloat extent_x = fabsf(piece->cos_a) * half_length + fabsf(piece->sin_a) * half_width;
+      gfloat extent_y = fabsf(piece->sin_a) * half_length + fabsf(piece->cos_a) * half_width;
+      piece->min_x = piece->x - extent_x - 1.0f;
+      piece->max_x = piece->x + extent_x + 1.0f;
+      piece->min_y = piece->y - extent_y - 1.0f;
+      piece->max_y = piece->y + extent_y + 1.0f;
+    }
+    tiles->tile_start[t + 1] = tiles->tile_start[t] + num_pieces;
+  }
+
+  g_rand_free(rand);
+}
+
+static void
+confetti_tiles_clear(ConfettiTiles *tiles)
+{
+  g_free(tiles->tile_start);
+  g_free(tiles->pieces);
+}
+
 static void prepare(GeglOperation *operation) {
-  gegl_operation_set_format(operation, "input", babl_format("RGBA float"));
-  gegl_operation_set_format(operation, "output", babl_format("RGBA float"));
+  lb_generator_set_format(operation, babl_format("RGBA float"));
 }
 
-static gboolean process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level) {
+static gboolean render(GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level) {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   gfloat *out_pixel = (gfloat *)out_buf;
 
@@ -103,30 +177,23 @@ static gboolean process(GeglOperation *operation, void *in_buf, void *out_buf, g
   gegl_color_get_pixel(o->background_color, babl_format("RGBA float"), bg);
 
   // Collect confetti colors
-  GPtrArray *colors = g_ptr_array_new();
-  gfloat rgba[4];
-  gegl_color_get_pixel(o->color1, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color2, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color3, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color4, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color5, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color6, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
-  gegl_color_get_pixel(o->color7, babl_format("RGBA float"), rgba);
-  g_ptr_array_add(colors, g_memdup2(rgba, 4 * sizeof(gfloat)));
+  gfloat colors[CONFETTI_NUM_COLORS][4];
+  gegl_color_get_pixel(o->color1, babl_format("RGBA float"), colors[0]);
+  gegl_color_get_pixel(o->color2, babl_format("RGBA float"), colors[1]);
+  gegl_color_get_pixel(o->color3, babl_format("RGBA float"), colors[2]);
+  gegl_color_get_pixel(o->color4, babl_format("RGBA float"), colors[3]);
+  gegl_color_get_pixel(o->color5, babl_format("RGBA float"), colors[4]);
+  gegl_color_get_pixel(o->color6, babl_format("RGBA float"), colors[5]);
+  gegl_color_get_pixel(o->color7, babl_format("RGBA float"), colors[6]);
 
   GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
   gfloat canvas_width = canvas ? canvas->width : roi->width;
-  GRand *rand = g_rand_new_with_seed(o->seed);
   gfloat tile_size = o->tile_size;
   gfloat half_length = o->confetti_length / 2.0;
   gfloat half_width = o->confetti_width / 2.0;
-  gfloat density = o->density;
+
+  ConfettiTiles tiles;
+  confetti_tiles_init(&tiles, o, roi, canvas_width);
 
   for (glong i = 0; i < n_pixels; i++) {
     gfloat x = (i % roi->width) + roi->x;
@@ -139,39 +206,29 @@ static gboolean process(GeglOperation *operation, void *in_buf, void *out_buf, g
     out_pixel[3] = bg[3];
 
     // Check neighboring tiles
-    gint tile_x = (gint)floorf(x / tile_size);
-    gint tile_y = (gint)floorf(y / tile_size);
+    gint tile_x = (gint)floorf(x / tile_size) - tiles.tile_x0;
+    gint tile_y = (gint)floorf(y / tile_size) - tiles.tile_y0;
     for (gint dx = -1; dx <= 1; dx++) {
       for (gint dy = -1; dy <= 1; dy++) {
-        gint tx = tile_x + dx;
-        gint ty = tile_y + dy;
-        guint tile_seed = (tx + ty * (gint)(canvas_width / tile_size)) ^ o->seed;
-        g_rand_set_seed(rand, tile_seed);
-
-        gint num_pieces = g_rand_int_range(rand, (gint)density / 2, (gint)density + 1);
-        num_pieces = MIN(num_pieces, 15); // Cap for performance
-
-        for (gint j = 0; j < num_pieces; j++) {
-          ConfettiPiece piece;
-          piece.x = g_rand_double_range(rand, 0.0, tile_size) + tx * tile_size;
-          piece.y = g_rand_double_range(rand, 0.0, tile_size) + ty * tile_size;
-          piece.angle = g_rand_double_range(rand, 0.0, 2.0 * G_PI);
-          gfloat *color = (gfloat *)g_ptr_array_index(colors, g_rand_int_range(rand, 0, colors->len));
-          memcpy(piece.color, color, 4 * sizeof(gfloat));
+        gint t = (tile_x + dx) * tiles.tiles_y + (tile_y + dy);
+
+        for (gint j = tiles.tile_start[t]; j < tiles.tile_start[t + 1]; j++) {
+          const ConfettiPiece *piece = &tiles.pieces[j];
+
+          if (x < piece->min_x || x > piece->max_x || y < piece->min_y || y > piece->max_y)
+            continue;
 
           // Transform pixel to confetti-local coordinates
-          gfloat dx = x - piece.x;
-          gfloat dy = y - piece.y;
-          gfloat cos_a = cosf(-piece.angle);
-          gfloat sin_a = sinf(-piece.angle);
-          gfloat local_x = dx * cos_a - dy * sin_a;
-          gfloat local_y = dx * sin_a + dy * cos_a;
+          gfloat dx = x - piece->x;
+          gfloat dy = y - piece->y;
+          gfloat local_x = dx * piece->cos_a - dy * piece->sin_a;
+          gfloat local_y = dx * piece->sin_a + dy * piece->cos_a;
 
           // Check if pixel is inside rectangle
           if (fabsf(local_x) <= half_length && fabsf(local_y) <= half_width) {
-            out_pixel[0] = piece.color[0];
-            out_pixel[1] = piece.color[1];
-            out_pixel[2] = piece.color[2];
+            out_pixel[0] = colors[piece->color][0];
+            out_pixel[1] = colors[piece->color][1];
+            out_pixel[2] = colors[piece->color][2];
             out_pixel[3] = 1.0;
             goto next_pixel; // Skip other pieces
           }
@@ -182,19 +239,28 @@ next_pixel:
     out_pixel += 4;
   }
 
-  // Cleanup
-  g_ptr_array_foreach(colors, (GFunc)g_free, NULL);
-  g_ptr_array_free(colors, TRUE);
-  g_rand_free(rand);
+  confetti_tiles_clear(&tiles);
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void gegl_op_class_init(GeglOpClass *klass) {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
     "name", "ai/lb:confetti",
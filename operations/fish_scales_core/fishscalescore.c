@@ -23,6 +23,7 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -74,7 +75,7 @@ property_double(rotation, _("Rotation"), 0.0)
 
 static void prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static GeglRectangle get_bounding_box (GeglOperation *operation)
@@ -113,13 +114,14 @@ process (GeglOperation        *operation,
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GeglBuffer *output = gegl_operation_context_get_target (context, output_prop);
+  const Babl *format = babl_format ("RGBA float");
+  GeglBufferIterator *iter;
   gdouble scale_color[4], background[4] = {0.0, 0.0, 0.0, 0.0};
   gdouble size = o->scale_size;
   gdouble overlap_amount = o->overlap;
   gdouble h_spacing = o->horizontal_spacing;
   const gdouble smoothness = 0.03;
-  GeglRectangle rect = *result;
-  gint x, y;
+  gdouble scale = (gdouble) (1 << level);
 
   // Convert rotation to radians
   gdouble rotation_rad = o->rotation * G_PI / 180.0;
@@ -136,104 +138,115 @@ process (GeglOperation        *operation,
   gdouble hex_width = size * 2.0 * h_spacing;
   gdouble hex_height = size * sqrt(3.0);
 
-  for (y = rect.y; y < rect.y + rect.height; y++)
+  // Render straight into the linear rows of each destination tile; at
+  // mipmap levels every output pixel covers scale x scale source pixels
+  iter = gegl_buffer_iterator_new (output, result, level, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
   {
-    for (x = rect.x; x < rect.x + rect.width; x++)
+    gfloat *out = iter->items[0].data;
+    GeglRectangle roi = iter->items[0].roi;
+    gint x, y;
+
+    for (y = roi.y; y < roi.y + roi.height; y++)
     {
-      gdouble px = (gdouble)x;
-      gdouble py = (gdouble)y;
-      
-      // Apply rotation
-      gdouble rot_x = px * cos_rot - py * sin_rot;
-      gdouble rot_y = px * sin_rot + py * cos_rot;
-      
-      // Calculate grid position using rotated coordinates
-      gint row = floor(rot_y / (hex_height * (1.0 - overlap_amount)));
-      gdouble y_in_row = fmod(rot_y, hex_height * (1.0 - overlap_amount));
-      
-      // Offset every other row
-      gdouble x_offset = (row % 2) * size * h_spacing;
-      gdouble x_in_col = fmod(rot_x - x_offset, hex_width);
-      
-      // Convert to normalized hex coordinates
-      gdouble hex_x = (x_in_col / (size * h_spacing)) - 1.0;
-      gdouble hex_y = (y_in_row / (hex_height * (1.0 - overlap_amount))) * 2.0 - 1.0;
-      
-      // Fish scale shape with pattern modifier
-      gdouble dist = sqrt(hex_x*hex_x + hex_y*hex_y);
-      gdouble curved_dist = dist * get_pattern_modifier(o->scale_type, hex_x, hex_y);
-      
-      // Calculate coverage with fixed smoothness
-      gdouble coverage = 1.0;
-      gdouble edge = 1.0 - curved_dist;
-      if (edge < smoothness) {
-        coverage = edge / smoothness;
-      }
-      
-      if (coverage > 0.0 && hex_y < 0.6 + smoothness/2.0)
+      gdouble py = y * scale;
+
+      for (x = roi.x; x < roi.x + roi.width; x++, out += 4)
       {
-        gfloat out[4];
-        
-        if (o->enable_gradient)
+        gdouble px = x * scale;
+
+        // Apply rotation
+        gdouble rot_x = px * cos_rot - py * sin_rot;
+        gdouble rot_y = px * sin_rot + py * cos_rot;
+
+        // Calculate grid position using rotated coordinates
+        gint row = floor(rot_y / (hex_height * (1.0 - overlap_amount)));
+        gdouble y_in_row = fmod(rot_y, hex_height * (1.0 - overlap_amount));
+
+        // Offset every other row
+        gdouble x_offset = (row % 2) * size * h_spacing;
+        gdouble x_in_col = fmod(rot_x - x_offset, hex_width);
+
+        // Convert to normalized hex coordinates
+        gdouble hex_x = (x_in_col / (size * h_spacing)) - 1.0;
+        gdouble hex_y = (y_in_row / (hex_height * (1.0 - overlap_amount))) * 2.0 - 1.0;
+
+        // Fish scale shape with pattern modifier
+        gdouble dist = sqrt(hex_x*hex_x + hex_y*hex_y);
+        gdouble curved_dist = dist * get_pattern_modifier(o->scale_type, hex_x, hex_y);
+
+        // Calculate coverage with fixed smoothness
+        gdouble coverage = 1.0;
+        gdouble edge = 1.0 - curved_dist;
+        if (edge < smoothness) {
+          coverage = edge / smoothness;
+        }
+
+        if (coverage > 0.0 && hex_y < 0.6 + smoothness/2.0)
         {
-          // Calculate lighting for gradient effect
-          gdouble highlight_amount = pow(1.0 - fmax(0.0, hex_y), 2.0) * 0.8;
-          gdouble shadow_amount = pow(fmax(0.0, hex_y), 2.0) * 0.5;
-          
-          // Calculate highlight and shadow colors
-          gdouble highlight[3] = {
-            MIN(scale_color[0] * 1.3, 1.0),
-            MIN(scale_color[1] * 1.3, 1.0),
-            MIN(scale_color[2] * 1.3, 1.0)
-          };
-          gdouble shadow[3] = {
-            scale_color[0] * 0.7,
-            scale_color[1] * 0.7,
-            scale_color[2] * 0.7
-          };
-          
-          // Apply gradient effect
-          out[0] = scale_color[0] * (1.0 - highlight_amount - shadow_amount) 
-                 + highlight[0] * highlight_amount
-                 + shadow[0] * shadow_amount;
-          out[1] = scale_color[1] * (1.0 - highlight_amount - shadow_amount) 
-                 + highlight[1] * highlight_amount
-                 + shadow[1] * shadow_amount;
-          out[2] = scale_color[2] * (1.0 - highlight_amount - shadow_amount) 
-                 + highlight[2] * highlight_amount
-                 + shadow[2] * shadow_amount;
-          
-          // Edge darkening
-          gdouble edge_darken = pow(1.0 - curved_dist, 2.0) * 0.3 * coverage;
-          out[0] = out[0] * (1.0 - edge_darken) + shadow[0] * edge_darken;
-          out[1] = out[1] * (1.0 - edge_darken) + shadow[1] * edge_darken;
-          out[2] = out[2] * (1.0 - edge_darken) + shadow[2] * edge_darken;
+          if (o->enable_gradient)
+          {
+            // Calculate lighting for gradient effect
+            gdouble highlight_amount = pow(1.0 - fmax(0.0, hex_y), 2.0) * 0.8;
+            gdouble shadow_amount = pow(fmax(0.0, hex_y), 2.0) * 0.5;
+
+            // Calculate highlight and shadow colors
+            gdouble highlight[3] = {
+              MIN(scale_color[0] * 1.3, 1.0),
+              MIN(scale_color[1] * 1.3, 1.0),
+              MIN(scale_color[2] * 1.3, 1.0)
+            };
+            gdouble shadow[3] = {
+              scale_color[0] * 0.7,
+              scale_color[1] * 0.7,
+              scale_color[2] * 0.7
+            };
+
+            // Apply gradient effect
+            out[0] = scale_color[0] * (1.0 - highlight_amount - shadow_amount)
+                   + highlight[0] * highlight_amount
+                   + shadow[0] * shadow_amount;
+            out[1] = scale_color[1] * (1.0 - highlight_amount - shadow_amount)
+                   + highlight[1] * highlight_amount
+                   + shadow[1] * shadow_amount;
+            out[2] = scale_color[2] * (1.0 - highlight_amount - shadow_amount)
+                   + highlight[2] * highlight_amount
+                   + shadow[2] * shadow_amount;
+
+            // Edge darkening
+            gdouble edge_darken = pow(1.0 - curved_dist, 2.0) * 0.3 * coverage;
+            out[0] = out[0] * (1.0 - edge_darken) + shadow[0] * edge_darken;
+            out[1] = out[1] * (1.0 - edge_darken) + shadow[1] * edge_darken;
+            out[2] = out[2] * (1.0 - edge_darken) + shadow[2] * edge_darken;
+          }
+          else
+          {
+            // Solid color without gradient
+            out[0] = scale_color[0];
+            out[1] = scale_color[1];
+            out[2] = scale_color[2];
+          }
+
+          // Final color blending
+          if (o->enable_background) {
+            out[0] = out[0] * coverage + background[0] * (1.0 - coverage);
+            out[1] = out[1] * coverage + background[1] * (1.0 - coverage);
+            out[2] = out[2] * coverage + background[2] * (1.0 - coverage);
+            out[3] = 1.0;
+          } else {
+            out[3] = coverage;
+          }
         }
         else
         {
-          // Solid color without gradient
-          out[0] = scale_color[0];
-          out[1] = scale_color[1];
-          out[2] = scale_color[2];
-        }
-        
-        // Final color blending
-        if (o->enable_background) {
-          out[0] = out[0] * coverage + background[0] * (1.0 - coverage);
-          out[1] = out[1] * coverage + background[1] * (1.0 - coverage);
-          out[2] = out[2] * coverage + background[2] * (1.0 - coverage);
-          out[3] = 1.0;
-        } else {
-          out[3] = coverage;
+          // Background or transparent
+          out[0] = background[0];
+          out[1] = background[1];
+          out[2] = background[2];
+          out[3] = o->enable_background ? 1.0 : 0.0;
         }
-        
-        gegl_buffer_set (output, GEGL_RECTANGLE (x, y, 1, 1), 0, babl_format ("RGBA float"), out, GEGL_AUTO_ROWSTRIDE);
-      }
-      else
-      {
-        // Background or transparent
-        gfloat out[4] = {background[0], background[1], background[2], o->enable_background ? 1.0 : 0.0};
-        gegl_buffer_set (output, GEGL_RECTANGLE (x, y, 1, 1), 0, babl_format ("RGBA float"), out, GEGL_AUTO_ROWSTRIDE);
       }
     }
   }
@@ -247,6 +260,7 @@ gegl_op_class_init (GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   operation_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
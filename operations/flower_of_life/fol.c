@@ -22,6 +22,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-noise.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -108,17 +110,9 @@ property_color(background_color, _("Background Color"), "#70D0FF")
 
 #include "gegl-op.h"
 
-// Simple pseudo-random number generator for Random Offset variation
-static gdouble random_value(gint seed)
-{
-  seed = (seed * 1103515245 + 12345) & 0x7fffffff;
-  return (gdouble)(seed % 1000) / 1000.0;
-}
-
 static void prepare(GeglOperation *operation)
 {
-  gegl_operation_set_format(operation, "input", babl_format("RGBA float"));
-  gegl_operation_set_format(operation, "output", babl_format("RGBA float"));
+  lb_generator_set_format(operation, babl_format("RGBA float"));
 }
 
 static GeglRectangle get_bounding_box(GeglOperation *operation)
@@ -259,9 +253,8 @@ process(GeglOperation        *operation,
               }
               case RANDOM_OFFSET:
               {
-                gint seed = i * 1000 + j;
-                gdouble dx = (random_value(seed) - 0.5) * 0.2 * s;
-                gdouble dy = (random_value(seed + 1) - 0.5) * 0.2 * s;
+                gdouble dx = (lb_noise_hash_float(i, j, 0) - 0.5) * 0.2 * s;
+                gdouble dy = (lb_noise_hash_float(i, j, 1) - 0.5) * 0.2 * s;
                 cx += dx; cy += dy;
                 cx_offset += dx; cy_offset += dy;
                 break;
@@ -539,6 +532,7 @@ gegl_op_class_init(GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   operation_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
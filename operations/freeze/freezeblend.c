@@ -38,6 +38,7 @@ property_double (opacity, _("Opacity"), 1.0)
 #define GEGL_OP_C_SOURCE freezeblend.c
 
 #include "gegl-op.h"
+#include "lb-blend.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -122,8 +123,33 @@ process (GeglOperation       *op,
 
   /* Access the property */
   gdouble opacity = GEGL_PROPERTIES (op)->opacity;
+  gfloat  opacity_f = opacity;
 
-  for (i = 0; i < n_pixels; i++)
+  i = 0;
+  if (components == 4)
+    for (; i + LB_BLEND_BLOCK <= n_pixels; i += LB_BLEND_BLOCK)
+      {
+        gfloat blended[LB_BLEND_BLOCK * 4];
+
+        for (gint j = 0; j < LB_BLEND_BLOCK * 4; j++)
+          {
+            /* Divide and clamp unconditionally so the select below has no branch */
+            gfloat denom = 1.0f - aux[j];
+            gfloat quotient = (in[j] * in[j]) / MAX (denom, G_MINFLOAT);
+            gfloat clamped = CLAMP (quotient, 0.0f, 1.0f);
+            gfloat processed = denom > 0.0f ? clamped : in[j];
+
+            blended[j] = lb_blend_mix (in[j], processed, opacity_f);
+          }
+
+        lb_blend_store (in, blended, out);
+
+        in  += LB_BLEND_BLOCK * 4;
+        aux += LB_BLEND_BLOCK * 4;
+        out += LB_BLEND_BLOCK * 4;
+      }
+
+  for (; i < n_pixels; i++)
     {
       gfloat a_r = aux[0];  /* Source (aux) red */
       gfloat a_g = aux[1];  /* Source green */
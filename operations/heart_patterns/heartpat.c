@@ -21,6 +21,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -84,17 +86,43 @@ property_color(bg_color, _("Background Color"), "#76ebff")
 property_boolean(transparent_bg, _("Transparent Background"), FALSE)
     description(_("Enable to make the background transparent"))
 
+property_boolean(antialias, _("Antialiasing"), FALSE)
+    description(_("Smooth the heart edges using their distance to each pixel"))
+
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     heartpat
 #define GEGL_OP_C_SOURCE heartpat.c
 
 #include "gegl-op.h"
 
-// Function to check if a point (px, py) is inside a heart centered at (cx, cy)
-static gboolean
-point_in_heart(gdouble px, gdouble py, gdouble cx, gdouble cy, gdouble size,
+// Distance to the implicit heart (x^2 + y^2 - 1)^3 - x^2 * y^3 <= 0 in
+// normalized heart units, estimated from the value and its gradient.
+// Modified to account for pointiness and lobe_roundness
+static gdouble
+heart_implicit_distance(gdouble px, gdouble py,
+                        gdouble pointiness, gdouble lobe_roundness)
+{
+  gdouble k = 1.0 + lobe_roundness * 0.5;  // Adjust y for lobe roundness
+  gdouble m = 1.0 - pointiness * 0.5;      // Adjust for pointiness
+  gdouble x2 = px * px;
+  gdouble y2 = py * py;
+  gdouble term1 = (x2 + y2 - 1.0);
+  gdouble y_adjusted = py * k;
+  gdouble y_adjusted3 = y_adjusted * y_adjusted * y_adjusted;
+  gdouble value = term1 * term1 * term1 - x2 * y_adjusted3 * m;
+
+  gdouble grad_x = 6.0 * px * term1 * term1 - 2.0 * px * y_adjusted3 * m;
+  gdouble grad_y = 6.0 * py * term1 * term1 - 3.0 * x2 * y_adjusted * y_adjusted * k * m;
+
+  return lb_sd_implicit(value, grad_x, grad_y);
+}
+
+// Signed distance in pixels from a point (px, py) to the heart centered at
+// (cx, cy), negative inside the heart
+static gfloat
+heart_distance(gdouble px, gdouble py, gdouble cx, gdouble cy, gdouble size,
                gdouble outline_style_ratio, gdouble rotation,
                gdouble pointiness, gdouble lobe_roundness)
 {
@@ -121,52 +149,34 @@ point_in_heart(gdouble px, gdouble py, gdouble cx, gdouble cy, gdouble size,
   // Center the heart vertically
   py += 0.5;
 
-  // Implicit heart equation: (x^2 + y^2 - 1)^3 - x^2 * y^3 <= 0
-  // Modified to account for pointiness and lobe_roundness
-  gdouble x2 = px * px;
-  gdouble y2 = py * py;
-  gdouble term1 = (x2 + y2 - 1.0);
-  gdouble term1_cubed = term1 * term1 * term1;
-  gdouble y_adjusted = py * (1.0 + lobe_roundness * 0.5);  // Adjust y for lobe roundness
-  gdouble term2 = x2 * pow(y_adjusted, 3.0) * (1.0 - pointiness * 0.5);  // Adjust for pointiness
-  gdouble value = term1_cubed - term2;
-
-  // Check if the point is inside the heart
-  gboolean is_inside = (value <= 0);
+  // One normalized unit spans size / 2 pixels
+  gdouble to_pixels = size / 2.0;
+  gdouble sd = heart_implicit_distance(px, py, pointiness, lobe_roundness);
 
   // Apply outline_style for outline styles
-  if (outline_style_ratio < 1.0 && is_inside)
+  if (outline_style_ratio < 1.0)
   {
     // outline_style ratio 1.0 = filled, 0.0 = thick outline
     gdouble scale = outline_style_ratio;  // Scale down the shape to create an inner boundary
-    gdouble px_inner = px / scale;
-    gdouble py_inner = py / scale;
-    gdouble x2_inner = px_inner * px_inner;
-    gdouble y2_inner = py_inner * py_inner;
-    gdouble term1_inner = (x2_inner + y2_inner - 1.0);
-    gdouble term1_cubed_inner = term1_inner * term1_inner * term1_inner;
-    gdouble y_adjusted_inner = py_inner * (1.0 + lobe_roundness * 0.5);
-    gdouble term2_inner = x2_inner * pow(y_adjusted_inner, 3.0) * (1.0 - pointiness * 0.5);
-    gdouble inner_value = term1_cubed_inner - term2_inner;
+    gdouble inner_sd = heart_implicit_distance(px / scale, py / scale, pointiness, lobe_roundness) * scale;
 
     // For outline mode, point is inside the outline if it's inside the outer shape
     // but outside the inner shape
-    is_inside = (inner_value > 0);
+    sd = lb_sd_subtract(sd, inner_sd);
   }
 
-  return is_inside;
+  return sd * to_pixels;
 }
 
 static void
 prepare(GeglOperation *operation)
 {
   const Babl *space = gegl_operation_get_source_space(operation, "input");
-  gegl_operation_set_format(operation, "input", babl_format_with_space("RGBA float", space));
-  gegl_operation_set_format(operation, "output", babl_format_with_space("RGBA float", space));
+  lb_generator_set_format(operation, babl_format_with_space("RGBA float", space));
 }
 
 static gboolean
-process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
+render(GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   gfloat heart_rgb[3], bg_rgb[3];
@@ -196,8 +206,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
     {
       // Calculate the index into out_buf
       gint idx = ((y - roi->y) * roi->width + (x - roi->x)) * 4;
-      gfloat min_distance = G_MAXFLOAT;
-      gboolean is_inside = FALSE;
+      gfloat sd = G_MAXFLOAT;
 
       // Apply panning
       gfloat px = x - o->pan_x;
@@ -215,14 +224,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
             {
               gfloat center_x = grid_x + c * visual_spacing + o->pan_x;
               gfloat center_y = grid_y + r * visual_spacing + o->pan_y;
-              gfloat dx = x - center_x;
-              gfloat dy = y - center_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, center_x, center_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, center_x, center_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
@@ -239,14 +241,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_y = (row + r) * row_height + visual_spacing / 2 + o->pan_y;
               gfloat grid_x = (col + c) * visual_spacing + visual_spacing / 2 + o->pan_x;
               if ((gint)(row + r) % 2 == 1) grid_x += visual_spacing / 2;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
@@ -263,14 +258,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_y = (row + r) * row_height + visual_spacing / 2 + o->pan_y;
               gfloat grid_x = (col + c) * visual_spacing + visual_spacing / 2 + o->pan_x;
               if ((gint)(row + r) % 2 == 1) grid_x += visual_spacing / 2;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
@@ -290,14 +278,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_diag_y = (row + r) * diag_spacing;
               gfloat grid_x = (grid_diag_x + grid_diag_y) / 2 + o->pan_x;
               gfloat grid_y = (grid_diag_x - grid_diag_y) / 2 + o->pan_y;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, grid_x, grid_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
@@ -312,14 +293,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
             {
               gfloat center_x = grid_x + c * visual_spacing + sin((grid_y + r * visual_spacing) * 0.05f) * visual_spacing / 2 + o->pan_x;
               gfloat center_y = grid_y + r * visual_spacing + sin((grid_x + c * visual_spacing) * 0.05f) * visual_spacing / 2 + o->pan_y;
-              gfloat dx = x - center_x;
-              gfloat dy = y - center_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, center_x, center_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, center_x, center_y, base_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
@@ -337,58 +311,57 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_x = (col + c) * visual_spacing + visual_spacing / 2 + o->pan_x;
               gfloat heart_size = (gint)(col + c) % 2 == 0 ? base_size : base_size * 0.5f;
               if ((gint)(row + r) % 2 == 1) heart_size = base_size * 0.75f;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_heart(x, y, grid_x, grid_y, heart_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness))
-              {
-                min_distance = distance;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, heart_distance(x, y, grid_x, grid_y, heart_size, outline_style_ratio, o->rotation, o->pointiness, o->lobe_roundness));
             }
           }
           break;
         }
       }
 
-      if (is_inside)
+      gfloat *pixel = out_data + idx;
+
+      if (o->transparent_bg)
       {
-        out_data[idx + 0] = heart_rgb[0];
-        out_data[idx + 1] = heart_rgb[1];
-        out_data[idx + 2] = heart_rgb[2];
-        out_data[idx + 3] = 1.0f;
+        pixel[0] = 0.0f;
+        pixel[1] = 0.0f;
+        pixel[2] = 0.0f;
+        pixel[3] = 0.0f;  // Fully transparent background
       }
       else
       {
-        if (o->transparent_bg)
-        {
-          out_data[idx + 0] = 0.0f;
-          out_data[idx + 1] = 0.0f;
-          out_data[idx + 2] = 0.0f;
-          out_data[idx + 3] = 0.0f;  // Fully transparent background
-        }
-        else
-        {
-          out_data[idx + 0] = bg_rgb[0];
-          out_data[idx + 1] = bg_rgb[1];
-          out_data[idx + 2] = bg_rgb[2];
-          out_data[idx + 3] = 1.0f;  // Opaque background color
-        }
+        pixel[0] = bg_rgb[0];
+        pixel[1] = bg_rgb[1];
+        pixel[2] = bg_rgb[2];
+        pixel[3] = 1.0f;  // Opaque background color
       }
+
+      lb_coverage_over(pixel, heart_rgb, lb_coverage(sd, o->antialias));
     }
   }
 
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
       "name",        "ai/lb:heart-patterns",
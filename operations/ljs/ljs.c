@@ -22,6 +22,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-segment-grid.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -91,71 +93,80 @@ property_int(quality, _("Quality of Lines"), 1900)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     ljslines
 #define GEGL_OP_C_SOURCE ljs.c
 
 #include <gegl-op.h>
 
-static void
-prepare(GeglOperation *operation)
-{
-  const Babl *space = gegl_operation_get_source_space(operation, "input");
-  gegl_operation_set_format(operation, "input", babl_format_with_space("RGBA float", space));
-  gegl_operation_set_format(operation, "output", babl_format_with_space("RGBA float", space));
-}
+/* Cells per side of the grid the curve segments are bucketed into */
+#define LJC_GRID_SIZE 128
+
+/* Steps used for previews, whatever the quality */
+#define LJC_PREVIEW_STEPS 300
+
+/* Curve segments of every pass, indexed in curve units. Built by prepare()
+ * for one step count and line reach, and only read by process(), which
+ * may run on several threads at once */
+typedef struct {
+  gint           steps;
+  gfloat         half_thickness;
+  GeglLjcType    ljc_type;
+  gint           a;
+  gint           b;
+  gdouble        delta;
+  gdouble        rotation;
+  gint           n_passes;
+  LbSegmentGrid *passes[2];
+} LjcCurve;
+
+/* Previews and final renders use different step counts, so keep both */
+typedef struct {
+  LjcCurve *preview;
+  LjcCurve *full;
+} LjcGeometry;
 
 static void
-render_ljc(GeglOperation *operation, gfloat *out, gint width, gint height, const GeglRectangle *roi, gint level)
+ljc_curve_free(LjcCurve *curve)
 {
-  GeglProperties *o = GEGL_PROPERTIES(operation);
-  GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
-  gfloat canvas_width = canvas ? canvas->width : roi->width;
-  gfloat canvas_height = canvas ? canvas->height : roi->height;
-
-  gfloat bg_rgb[4], line_rgb[4];
-  gegl_color_get_pixel(o->background_color, babl_format("RGBA float"), bg_rgb);
-  gegl_color_get_pixel(o->line_color, babl_format("RGBA float"), line_rgb);
-  bg_rgb[3] = 1.0f;
+  if (!curve)
+    return;
 
-  for (glong i = 0; i < width * height; i++)
-  {
-    if (o->transparent_background)
-    {
-      /* Transparent background: set alpha to 0 */
-      out[i * 4 + 0] = 0.0f;
-      out[i * 4 + 1] = 0.0f;
-      out[i * 4 + 2] = 0.0f;
-      out[i * 4 + 3] = 0.0f;
-    }
-    else
-    {
-      /* Use background color */
-      out[i * 4 + 0] = bg_rgb[0];
-      out[i * 4 + 1] = bg_rgb[1];
-      out[i * 4 + 2] = bg_rgb[2];
-      out[i * 4 + 3] = bg_rgb[3];
-    }
-  }
-
-  gfloat base_scale = MIN(canvas_width, canvas_height) * 0.48f;
-  gfloat scale_x = base_scale * o->scale_factor;
-  gfloat scale_y = base_scale * o->scale_factor;
-
-  /* Apply the X and Y offsets to the center of the curve */
-  gfloat center_x = (canvas_width / 2.0f) + (o->offset_x * canvas_width / 2.0f);
-  gfloat center_y = (canvas_height / 2.0f) + (o->offset_y * canvas_height / 2.0f);
+  for (gint pass = 0; pass < curve->n_passes; pass++)
+    lb_segment_grid_free(curve->passes[pass]);
+  g_free(curve);
+}
 
-  gfloat effective_half_thickness = MAX(o->line_thickness * 0.5f, 1.5f) * 1.1f;
-  gfloat effective_half_thickness_squared = effective_half_thickness * effective_half_thickness;
+static gboolean
+ljc_curve_matches(const LjcCurve *curve,
+                  GeglProperties *o,
+                  gint            steps,
+                  gfloat          half_thickness)
+{
+  return curve &&
+         curve->steps == steps &&
+         curve->half_thickness == half_thickness &&
+         curve->ljc_type == o->ljc_type &&
+         curve->a == o->a &&
+         curve->b == o->b &&
+         curve->delta == o->delta &&
+         curve->rotation == o->rotation;
+}
 
-  /* Adjust parameters based on level (preview mode) */
-  const gint steps = (level > 0) ? 300 : o->quality; /* Use quality slider for final renders */
-  const gint sub_steps = (level > 0) ? 0 : 2;  /* No sub-steps in preview mode */
-  const gint checkerboard_skip = (level > 0) ? 4 : 2; /* Skip more pixels in preview mode */
+static LjcCurve *
+ljc_curve_new(GeglProperties *o,
+              gint            steps,
+              gfloat          half_thickness)
+{
+  LjcCurve *curve = g_new0(LjcCurve, 1);
 
-  gfloat core_half_thickness = effective_half_thickness * 0.8f;
-  gfloat fade_range = effective_half_thickness - core_half_thickness;
+  curve->steps = steps;
+  curve->half_thickness = half_thickness;
+  curve->ljc_type = o->ljc_type;
+  curve->a = o->a;
+  curve->b = o->b;
+  curve->delta = o->delta;
+  curve->rotation = o->rotation;
 
   /* Convert rotation from degrees to radians */
   gfloat theta = o->rotation * G_PI / 180.0f;
@@ -163,32 +174,21 @@ render_ljc(GeglOperation *operation, gfloat *out, gint width, gint height, const
   gfloat sin_theta = sin(theta);
 
   gfloat *curve_points = g_new(gfloat, steps * 2);
+  gfloat *segments = g_new(gfloat, steps * 4);
 
   /* Determine the number of passes (only Offset LJC needs multiple passes) */
-  gint num_passes = (o->ljc_type == GEGL_LJC_OFFSET) ? 2 : 1;
+  curve->n_passes = (o->ljc_type == GEGL_LJC_OFFSET) ? 2 : 1;
 
-  for (gint pass = 0; pass < num_passes; pass++)
+  for (gint pass = 0; pass < curve->n_passes; pass++)
   {
     gfloat pass_offset_x = 0.0f;
     gfloat pass_offset_y = 0.0f;
-    gfloat pass_alpha = 1.0f;
 
-    if (o->ljc_type == GEGL_LJC_OFFSET)
+    /* First pass of Offset LJC is the shadow, shifted down and right */
+    if (o->ljc_type == GEGL_LJC_OFFSET && pass == 0)
     {
-      if (pass == 0)
-      {
-        /* First pass: Render the shadow (offset, semi-transparent) */
-        pass_offset_x = 0.02f;
-        pass_offset_y = 0.02f;
-        pass_alpha = 0.5f;
-      }
-      else
-      {
-        /* Second pass: Render the main curve */
-        pass_offset_x = 0.0f;
-        pass_offset_y = 0.0f;
-        pass_alpha = 1.0f;
-      }
+      pass_offset_x = 0.02f;
+      pass_offset_y = 0.02f;
     }
 
     /* Compute curve points for this pass */
@@ -242,98 +242,191 @@ render_ljc(GeglOperation *operation, gfloat *out, gint width, gint height, const
       curve_points[i * 2 + 1] = ny_rotated;
     }
 
-    /* Adjust bounding box to account for rotation, offsets, and user-defined X/Y offsets */
-    gfloat extent = sqrt(scale_x * scale_x + scale_y * scale_y) + effective_half_thickness + (num_passes > 1 ? 0.02f * scale_x : 0.0f);
-    gfloat min_x = center_x - extent;
-    gfloat max_x = center_x + extent;
-    gfloat min_y = center_y - extent;
-    gfloat max_y = center_y + extent;
-
-    /* First pass: Compute distances for a checkerboard pattern */
-    gfloat *distances = g_new(gfloat, width * height);
-    for (gint y = 0; y < height; y++)
+    /* Index the curve segments so each pixel only measures the nearby ones */
+    gint n_segments = 0;
+    for (gint i = 0; i < steps; i++)
     {
-      for (gint x = 0; x < width; x++)
+      /* For dashed LJC, skip segments to create dashes */
+      if (o->ljc_type == GEGL_LJC_DASHED)
       {
-        if ((x + y) % checkerboard_skip != 0) /* Skip pixels based on checkerboard pattern */
-        {
-          distances[y * width + x] = G_MAXFLOAT;
+        gint segment = (i % 30); /* Dash pattern: 20 steps on, 10 steps off */
+        if (segment >= 20) /* Skip rendering this segment */
           continue;
-        }
+      }
 
-        gfloat px = x + roi->x;
-        gfloat py = y + roi->y;
-        if (px < min_x || px > max_x || py < min_y || py > max_y)
-        {
-          distances[y * width + x] = G_MAXFLOAT;
-          continue;
-        }
+      segments[n_segments * 4 + 0] = curve_points[i * 2 + 0];
+      segments[n_segments * 4 + 1] = curve_points[i * 2 + 1];
+      segments[n_segments * 4 + 2] = curve_points[(i + 1) % steps * 2 + 0];
+      segments[n_segments * 4 + 3] = curve_points[(i + 1) % steps * 2 + 1];
+      n_segments++;
+    }
 
-        gfloat nx = (px - center_x) / scale_x;
-        gfloat ny = (py - center_y) / scale_y;
+    curve->passes[pass] = lb_segment_grid_new(segments, n_segments, half_thickness, LJC_GRID_SIZE);
+  }
 
-        /* Apply rotation to the pixel coordinates (inverse rotation) */
-        gfloat nx_rotated = nx * cos_theta + ny * sin_theta;
-        gfloat ny_rotated = -nx * sin_theta + ny * cos_theta;
+  g_free(curve_points);
+  g_free(segments);
+  return curve;
+}
 
-        gfloat min_dist_squared = G_MAXFLOAT;
+static void
+ljc_geometry_free(LjcGeometry *geometry)
+{
+  ljc_curve_free(geometry->preview);
+  ljc_curve_free(geometry->full);
+  g_free(geometry);
+}
 
-        for (gint i = 0; i < steps; i++)
-        {
-          /* For dashed LJC, skip segments to create dashes */
-          if (o->ljc_type == GEGL_LJC_DASHED)
-          {
-            gint segment = (i % 30); /* Dash pattern: 20 steps on, 10 steps off */
-            if (segment >= 20) /* Skip rendering this segment */
-              continue;
-          }
+/* Line reach in pixels; the fade runs over its outer fifth */
+static gfloat
+ljc_half_thickness(GeglProperties *o)
+{
+  return MAX(o->line_thickness * 0.5f, 1.5f) * 1.1f;
+}
 
-          gfloat cx1 = curve_points[i * 2 + 0];
-          gfloat cy1 = curve_points[i * 2 + 1];
-          gfloat cx2 = curve_points[(i + 1) % steps * 2 + 0];
-          gfloat cy2 = curve_points[(i + 1) % steps * 2 + 1];
+static void
+prepare(GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  const Babl *space = gegl_operation_get_source_space(operation, "input");
+  lb_generator_set_format(operation, babl_format_with_space("RGBA float", space));
 
-          for (gint s = 0; s <= sub_steps; s++)
-          {
-            gfloat t = (gfloat) s / sub_steps;
-            gfloat cx = cx1 + t * (cx2 - cx1);
-            gfloat cy = cy1 + t * (cy2 - cy1);
-            gfloat dx = nx_rotated - cx;
-            gfloat dy = ny_rotated - cy;
-            gfloat dist_squared = dx * dx + dy * dy;
-            min_dist_squared = MIN(min_dist_squared, dist_squared);
-          }
-        }
+  GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
+  if (!canvas || canvas->width <= 0 || canvas->height <= 0)
+    return;
 
-        distances[y * width + x] = min_dist_squared * (scale_x * scale_x);
-      }
+  /* Line reach in curve units, the space the segments are indexed in */
+  gfloat base_scale = MIN(canvas->width, canvas->height) * 0.48f;
+  gfloat half_thickness = ljc_half_thickness(o) / (base_scale * o->scale_factor);
+
+  if (!o->user_data)
+    o->user_data = g_new0(LjcGeometry, 1);
+
+  /* Rebuild a curve only when its step count, reach or shape changed */
+  LjcGeometry *geometry = o->user_data;
+  if (!ljc_curve_matches(geometry->preview, o, LJC_PREVIEW_STEPS, half_thickness))
+  {
+    ljc_curve_free(geometry->preview);
+    geometry->preview = ljc_curve_new(o, LJC_PREVIEW_STEPS, half_thickness);
+  }
+  if (!ljc_curve_matches(geometry->full, o, o->quality, half_thickness))
+  {
+    ljc_curve_free(geometry->full);
+    geometry->full = ljc_curve_new(o, o->quality, half_thickness);
+  }
+}
+
+static void
+finalize(GObject *object)
+{
+  GeglOperation *operation = (void *)object;
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+
+  if (o->user_data)
+    {
+      ljc_geometry_free(o->user_data);
+      o->user_data = NULL;
     }
 
-    /* Second pass: Interpolate missing pixels and render */
+  G_OBJECT_CLASS(gegl_op_parent_class)->finalize(object);
+}
+
+static void
+render_ljc(GeglOperation *operation, gfloat *out, gint width, gint height, const GeglRectangle *roi, gint level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  const LjcGeometry *geometry = o->user_data;
+  GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
+
+  gfloat bg_rgb[4], line_rgb[4];
+  gegl_color_get_pixel(o->background_color, babl_format("RGBA float"), bg_rgb);
+  gegl_color_get_pixel(o->line_color, babl_format("RGBA float"), line_rgb);
+  bg_rgb[3] = 1.0f;
+
+  for (glong i = 0; i < width * height; i++)
+  {
+    if (o->transparent_background)
+    {
+      /* Transparent background: set alpha to 0 */
+      out[i * 4 + 0] = 0.0f;
+      out[i * 4 + 1] = 0.0f;
+      out[i * 4 + 2] = 0.0f;
+      out[i * 4 + 3] = 0.0f;
+    }
+    else
+    {
+      /* Use background color */
+      out[i * 4 + 0] = bg_rgb[0];
+      out[i * 4 + 1] = bg_rgb[1];
+      out[i * 4 + 2] = bg_rgb[2];
+      out[i * 4 + 3] = bg_rgb[3];
+    }
+  }
+
+  /* Without a canvas there is nothing to size the curve from */
+  if (!geometry || !canvas)
+    return;
+
+  gfloat canvas_width = canvas->width;
+  gfloat canvas_height = canvas->height;
+
+  gfloat base_scale = MIN(canvas_width, canvas_height) * 0.48f;
+  gfloat scale_x = base_scale * o->scale_factor;
+  gfloat scale_y = base_scale * o->scale_factor;
+
+  /* Apply the X and Y offsets to the center of the curve */
+  gfloat center_x = (canvas_width / 2.0f) + (o->offset_x * canvas_width / 2.0f);
+  gfloat center_y = (canvas_height / 2.0f) + (o->offset_y * canvas_height / 2.0f);
+
+  gfloat effective_half_thickness = ljc_half_thickness(o);
+  gfloat effective_half_thickness_squared = effective_half_thickness * effective_half_thickness;
+
+  /* Adjust parameters based on level (preview mode) */
+  const LjcCurve *curve = (level > 0) ? geometry->preview : geometry->full;
+
+  gfloat core_half_thickness = effective_half_thickness * 0.8f;
+  gfloat fade_range = effective_half_thickness - core_half_thickness;
+
+  /* Convert rotation from degrees to radians */
+  gfloat theta = o->rotation * G_PI / 180.0f;
+  gfloat cos_theta = cos(theta);
+  gfloat sin_theta = sin(theta);
+
+  for (gint pass = 0; pass < curve->n_passes; pass++)
+  {
+    const LbSegmentGrid *grid = curve->passes[pass];
+
+    /* The Offset LJC shadow pass is half transparent */
+    gfloat pass_alpha = (o->ljc_type == GEGL_LJC_OFFSET && pass == 0) ? 0.5f : 1.0f;
+
+    /* Exact distance to the curve for every pixel */
     for (gint y = 0; y < height; y++)
     {
       for (gint x = 0; x < width; x++)
       {
-        gfloat dist_squared_pixels;
-        if ((x + y) % checkerboard_skip == 0)
-        {
-          dist_squared_pixels = distances[y * width + x];
-        }
-        else
+        gfloat px = x + roi->x;
+        gfloat py = y + roi->y;
+
+        gfloat nx = (px - center_x) / scale_x;
+        gfloat ny = (py - center_y) / scale_y;
+
+        /* Apply rotation to the pixel coordinates (inverse rotation) */
+        gfloat nx_rotated = nx * cos_theta + ny * sin_theta;
+        gfloat ny_rotated = -nx * sin_theta + ny * cos_theta;
+
+        guint first, last;
+        if (!lb_segment_grid_lookup(grid, nx_rotated, ny_rotated, &first, &last))
+          continue;
+
+        gfloat min_dist_squared = G_MAXFLOAT;
+        for (guint n = first; n < last; n++)
         {
-          /* Interpolate from neighbors */
-          gfloat d0 = (x > 0) ? distances[y * width + (x - 1)] : G_MAXFLOAT;
-          gfloat d1 = (x < width - 1) ? distances[y * width + (x + 1)] : G_MAXFLOAT;
-          gfloat d2 = (y > 0) ? distances[(y - 1) * width + x] : G_MAXFLOAT;
-          gfloat d3 = (y < height - 1) ? distances[(y + 1) * width + x] : G_MAXFLOAT;
-          gfloat min_dist = G_MAXFLOAT;
-          if (d0 != G_MAXFLOAT) min_dist = MIN(min_dist, d0);
-          if (d1 != G_MAXFLOAT) min_dist = MIN(min_dist, d1);
-          if (d2 != G_MAXFLOAT) min_dist = MIN(min_dist, d2);
-          if (d3 != G_MAXFLOAT) min_dist = MIN(min_dist, d3);
-          dist_squared_pixels = min_dist;
+          gfloat dist_squared = lb_segment_grid_distance_squared(grid, grid->cell_segments[n], nx_rotated, ny_rotated);
+          min_dist_squared = MIN(min_dist_squared, dist_squared);
         }
 
+        gfloat dist_squared_pixels = min_dist_squared * (scale_x * scale_x);
+
         if (dist_squared_pixels <= effective_half_thickness_squared)
         {
           glong idx = (y * width + x) * 4;
@@ -364,34 +457,42 @@ render_ljc(GeglOperation *operation, gfloat *out, gint width, gint height, const
         }
       }
     }
-
-    g_free(distances);
   }
-
-  g_free(curve_points);
 }
 
 static gboolean
-process(GeglOperation *operation,
-        void          *in_buf,
-        void          *out_buf,
-        glong          n_pixels,
-        const GeglRectangle *roi,
-        gint           level)
+render(GeglOperation *operation,
+       void          *out_buf,
+       glong          n_pixels,
+       const GeglRectangle *roi,
+       gint           level)
 {
   gfloat *out = (gfloat *) out_buf;
   render_ljc(operation, out, roi->width, roi->height, roi, level);
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
+  G_OBJECT_CLASS(klass)->finalize = finalize;
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
     "name",        "ai/lb:lissajous-curve",
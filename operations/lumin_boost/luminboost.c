@@ -37,6 +37,7 @@ property_double (opacity, _("Opacity"), 1.0)
 #define GEGL_OP_C_SOURCE luminboost.c
 
 #include "gegl-op.h"
+#include "lb-blend.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -123,8 +124,37 @@ process (GeglOperation       *op,
 
   /* Access the property */
   gdouble opacity = GEGL_PROPERTIES (op)->opacity;
+  gfloat  opacity_f = opacity;
 
-  for (i = 0; i < n_pixels; i++)
+  i = 0;
+  if (components == 4)
+    for (; i + LB_BLEND_BLOCK <= n_pixels; i += LB_BLEND_BLOCK)
+      {
+        gfloat weight[LB_BLEND_BLOCK];
+        gfloat blended[LB_BLEND_BLOCK * 4];
+
+        /* Opacity where the aux luma is higher, zero elsewhere */
+        for (gint j = 0; j < LB_BLEND_BLOCK; j++)
+          {
+            const gfloat *a = aux + j * 4;
+            const gfloat *b = in + j * 4;
+            gfloat luma_b = 0.299f * b[0] + 0.587f * b[1] + 0.114f * b[2];
+            gfloat luma_a = 0.299f * a[0] + 0.587f * a[1] + 0.114f * a[2];
+
+            weight[j] = luma_a > luma_b ? opacity_f : 0.0f;
+          }
+
+        for (gint j = 0; j < LB_BLEND_BLOCK * 4; j++)
+          blended[j] = lb_blend_mix (in[j], MAX (in[j], aux[j]), weight[j / 4]);
+
+        lb_blend_store (in, blended, out);
+
+        in  += LB_BLEND_BLOCK * 4;
+        aux += LB_BLEND_BLOCK * 4;
+        out += LB_BLEND_BLOCK * 4;
+      }
+
+  for (; i < n_pixels; i++)
     {
       gfloat a_r = aux[0];  /* Source (aux) red */
       gfloat a_g = aux[1];  /* Source green */
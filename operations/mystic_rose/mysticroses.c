@@ -22,6 +22,8 @@
 #include <math.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
+#include "lb-segment-grid.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -101,9 +103,13 @@ property_double(tuning, _("Tuning"), 0.0)
     value_range(0.0, 100.0)
     ui_range(0.0, 100.0)
 
+property_seed(seed, _("Random Seed"), rand)
+    description(_("Seed for the connections of the Random Links variation"))
+    ui_meta("visible", "variation {random}")
+
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     mystic_roses
 #define GEGL_OP_C_SOURCE mysticroses.c
 
@@ -115,33 +121,30 @@ typedef struct {
   gfloat y;
 } Point;
 
+/* Cells per side of the grid the chords are bucketed into */
+#define MYSTIC_ROSE_GRID_SIZE 64
+
+/* Rose geometry, rebuilt by prepare() whenever the properties change and
+ * only read by process(), which may run on several threads at once */
+typedef struct {
+  gfloat         tile_size;
+  gfloat         half_thickness;
+  LbSegmentGrid *chords; /* Connected chords, indexed by position */
+} MysticRoseGeometry;
+
 static void
-prepare(GeglOperation *operation)
+mystic_rose_geometry_free(MysticRoseGeometry *geometry)
 {
-  gegl_operation_set_format(operation, "input", babl_format("RGBA float"));
-  gegl_operation_set_format(operation, "output", babl_format("RGBA float"));
+  lb_segment_grid_free(geometry->chords);
+  g_free(geometry);
 }
 
-static gboolean
-process(GeglOperation *operation,
-        void *in_buf,
-        void *out_buf,
-        glong n_pixels,
-        const GeglRectangle *roi,
-        gint level)
+static MysticRoseGeometry *
+mystic_rose_geometry_new(GeglProperties *o,
+                         gfloat          canvas_width,
+                         gfloat          canvas_height)
 {
-  GeglProperties *o = GEGL_PROPERTIES(operation);
-  gfloat *out_pixel = (gfloat *)out_buf;
-
-  /* Get colors */
-  gfloat rose[4], bg[4];
-  gegl_color_get_pixel(o->rose_color, babl_format("RGBA float"), rose);
-  gegl_color_get_pixel(o->bg_color, babl_format("RGBA float"), bg);
-
-  /* Get canvas dimensions */
-  GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
-  gfloat canvas_width = canvas ? canvas->width : roi->width;
-  gfloat canvas_height = canvas ? canvas->height : roi->height;
+  MysticRoseGeometry *geometry = g_new(MysticRoseGeometry, 1);
 
   /* Center and radius for a single tile */
   gfloat cx = canvas_width / 2.0 + o->x_offset;
@@ -228,7 +231,8 @@ process(GeglOperation *operation,
                   should_connect = ((k - j) % 2 == 0);
                   break;
                 case GEGL_MYSTIC_ROSE_RANDOM:
-                  should_connect = (g_random_double() < 0.3);
+                  /* Keyed on the vertex pair, so the same seed always links the same chords */
+                  should_connect = (gegl_random_float(o->rand, j, k, 0, 0) < 0.3);
                   break;
                 case GEGL_MYSTIC_ROSE_KNOT:
                   should_connect = ((k - j) % 3 == 0);
@@ -244,8 +248,89 @@ process(GeglOperation *operation,
         }
     }
 
-  /* Half thickness for distance comparison */
-  gfloat half_thickness = o->line_thickness / 2.0;
+  /* Pack the connected pairs as segments for the chord grid */
+  gfloat *segments = g_new(gfloat, 4 * MAX(o->points * (o->points - 1) / 2, 1));
+  gint n_segments = 0;
+  for (gint j = 0; j < o->points; j++)
+    {
+      for (gint k = j + 1; k < o->points; k++)
+        {
+          if (!connect[j * o->points + k]) continue;
+
+          segments[n_segments * 4 + 0] = vertices[j].x;
+          segments[n_segments * 4 + 1] = vertices[j].y;
+          segments[n_segments * 4 + 2] = vertices[k].x;
+          segments[n_segments * 4 + 3] = vertices[k].y;
+          n_segments++;
+        }
+    }
+
+  geometry->tile_size = tile_size;
+  geometry->half_thickness = o->line_thickness / 2.0;
+  geometry->chords = lb_segment_grid_new(segments, n_segments,
+                                         geometry->half_thickness,
+                                         MYSTIC_ROSE_GRID_SIZE);
+
+  g_free(segments);
+  g_free(vertices);
+  g_free(connect);
+  return geometry;
+}
+
+static void
+prepare(GeglOperation *operation)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+
+  lb_generator_set_format(operation, babl_format("RGBA float"));
+
+  /* Get canvas dimensions */
+  GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
+  gfloat canvas_width = canvas ? canvas->width : 0.0;
+  gfloat canvas_height = canvas ? canvas->height : 0.0;
+
+  if (o->user_data)
+    mystic_rose_geometry_free(o->user_data);
+  o->user_data = mystic_rose_geometry_new(o, canvas_width, canvas_height);
+}
+
+static void
+finalize(GObject *object)
+{
+  GeglOperation *operation = (void *)object;
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+
+  if (o->user_data)
+    {
+      mystic_rose_geometry_free(o->user_data);
+      o->user_data = NULL;
+    }
+
+  G_OBJECT_CLASS(gegl_op_parent_class)->finalize(object);
+}
+
+static gboolean
+render(GeglOperation *operation,
+       void *out_buf,
+       glong n_pixels,
+       const GeglRectangle *roi,
+       gint level)
+{
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+  const MysticRoseGeometry *geometry = o->user_data;
+  gfloat tile_size = geometry->tile_size;
+  const LbSegmentGrid *chords = geometry->chords;
+  gfloat half_thickness_sq = geometry->half_thickness * geometry->half_thickness;
+  gfloat *out_pixel = (gfloat *)out_buf;
+
+  /* Get colors */
+  gfloat rose[4], bg[4];
+  gegl_color_get_pixel(o->rose_color, babl_format("RGBA float"), rose);
+  gegl_color_get_pixel(o->bg_color, babl_format("RGBA float"), bg);
+
+  /* Check neighboring tiles for tiling */
+  gint tile_min = o->tileable ? -1 : 0;
+  gint tile_max = o->tileable ? 1 : 0;
 
   for (glong i = 0; i < n_pixels; i++)
     {
@@ -255,56 +340,23 @@ process(GeglOperation *operation,
 
       gboolean on_line = FALSE;
 
-      /* Check neighboring tiles for tiling */
-      gint tile_x_min = o->tileable ? -1 : 0;
-      gint tile_x_max = o->tileable ? 1 : 0;
-      gint tile_y_min = o->tileable ? -1 : 0;
-      gint tile_y_max = o->tileable ? 1 : 0;
-
-      for (gint tx = tile_x_min; tx <= tile_x_max && !on_line; tx++)
+      for (gint tx = tile_min; tx <= tile_max && !on_line; tx++)
         {
-          for (gint ty = tile_y_min; ty <= tile_y_max && !on_line; ty++)
+          for (gint ty = tile_min; ty <= tile_max && !on_line; ty++)
             {
-              /* Offset center for this tile */
-              gfloat tile_cx = cx + tx * tile_size;
-              gfloat tile_cy = cy + ty * tile_size;
+              /* Move the pixel into the untiled rose instead of moving the chords */
+              gfloat rx = x - tx * tile_size;
+              gfloat ry = y - ty * tile_size;
+              guint first, last;
+
+              /* Only the chords listed for this pixel's cell can reach it */
+              if (!lb_segment_grid_lookup(chords, rx, ry, &first, &last))
+                continue;
 
-              /* Check distance to each line segment in this tile */
-              for (gint j = 0; j < o->points && !on_line; j++)
+              for (guint n = first; n < last && !on_line; n++)
                 {
-                  for (gint k = j + 1; k < o->points && !on_line; k++)
-                    {
-                      if (!connect[j * o->points + k]) continue;
-
-                      gfloat x1 = vertices[j].x + tx * tile_size;
-                      gfloat y1 = vertices[j].y + ty * tile_size;
-                      gfloat x2 = vertices[k].x + tx * tile_size;
-                      gfloat y2 = vertices[k].y + ty * tile_size;
-
-                      gfloat dx = x2 - x1;
-                      gfloat dy = y2 - y1;
-                      gfloat length_sq = dx * dx + dy * dy;
-
-                      if (length_sq < 1e-6) continue; /* Skip degenerate lines */
-
-                      /* Project point (x, y) onto line segment */
-                      gfloat t = ((x - x1) * dx + (y - y1) * dy) / length_sq;
-                      t = CLAMP(t, 0.0, 1.0);
-
-                      /* Closest point on segment */
-                      gfloat closest_x = x1 + t * dx;
-                      gfloat closest_y = y1 + t * dy;
-
-                      /* Distance from pixel to closest point */
-                      gfloat dist_x = x - closest_x;
-                      gfloat dist_y = y - closest_y;
-                      gfloat dist = sqrt(dist_x * dist_x + dist_y * dist_y);
-
-                      if (dist <= half_thickness)
-                        {
-                          on_line = TRUE;
-                        }
-                    }
+                  if (lb_segment_grid_distance_squared(chords, chords->cell_segments[n], rx, ry) <= half_thickness_sq)
+                    on_line = TRUE;
                 }
             }
         }
@@ -327,19 +379,30 @@ process(GeglOperation *operation,
       out_pixel += 4;
     }
 
-  g_free(vertices);
-  g_free(connect);
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
+  G_OBJECT_CLASS(klass)->finalize = finalize;
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
     "name",        "ai/lb:mystic-rose",
@@ -22,6 +22,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -120,6 +122,9 @@ property_color(background_color, _("Background Color"), "#70D0FF")
 property_boolean(transparent_background, _("Transparent Background"), FALSE)
     description(_("Make the background transparent instead of using the background color"))
 
+property_boolean(antialias, _("Antialiasing"), FALSE)
+    description(_("Smooth the pattern edges using their distance to each pixel"))
+
 #else
 
 #define GEGL_OP_POINT_FILTER
@@ -130,7 +135,7 @@ property_boolean(transparent_background, _("Transparent Background"), FALSE)
 
 static void prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static GeglRectangle get_bounding_box (GeglOperation *operation)
@@ -138,6 +143,1641 @@ static GeglRectangle get_bounding_box (GeglOperation *operation)
   return gegl_rectangle_infinite_plane ();
 }
 
+typedef struct
+{
+  gfloat   tx, ty;           /* tile space position of the row's first pixel */
+  gfloat   step_x, step_y;   /* tile space step per output pixel */
+  gfloat   tile_size;
+  gfloat   line_width_scale;
+  gboolean antialias;
+  gint     width;
+} PatternRow;
+
+typedef void (* PatternRowFunc) (const PatternRow *row,
+                                 gfloat           *coverage);
+
+/* Wrap a tile space coordinate back into [0, tile_size) */
+static inline gfloat
+pattern_wrap (gfloat t,
+              gfloat tile_size)
+{
+  t -= tile_size * floorf (t / tile_size);
+  t  = t < 0.0f ? t + tile_size : t;
+
+  return t < tile_size ? t : t - tile_size;
+}
+
+/* fmodf () as a truncated division; libm's exact fmodf () loops over the
+ * exponent difference and cannot be inlined into the row loops */
+static inline gfloat
+pattern_fmod (gfloat a,
+              gfloat b)
+{
+  return a - b * truncf (a / b);
+}
+
+static inline gfloat
+pattern_lattice_1 (gfloat   tx,
+                   gfloat   ty,
+                   gfloat   tile_size,
+                   gfloat   line_width_scale,
+                   gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cy), line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_ripple_effect (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat ripple_spacing = cell_size / 8.0f;
+  gfloat ripple_dist = pattern_fmod(dist, ripple_spacing);
+  gfloat base_line_width = ripple_spacing * 0.2f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_band (ripple_dist, line_width, ripple_spacing, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_petal_swirls (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat petal_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 60.0f);
+  gfloat petal_dist = dist + sinf(angle * 6.0f) * (cell_size / 8.0f);
+  gfloat base_petal_width = cell_size / 10.0f;
+  gfloat petal_width = base_petal_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (petal_angle, petal_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (petal_dist, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_checkerboard_waves (gfloat   tx,
+                            gfloat   ty,
+                            gfloat   tile_size,
+                            gfloat   line_width_scale,
+                            gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gint cell_x = (gint)(tx / cell_size);
+  gint cell_y = (gint)(ty / cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  if ((cell_x + cell_y) % 2 == 0)
+  {
+    coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave)), line_width, aa);
+  }
+  else
+  {
+    wave = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+    coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave)), line_width, aa);
+  }
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_mosaic_tiles (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave_x)), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave_y)), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_interlocking_gears (gfloat   tx,
+                            gfloat   ty,
+                            gfloat   tile_size,
+                            gfloat   line_width_scale,
+                            gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat gear_teeth = sinf(angle * 8.0f) * (cell_size / 8.0f);
+  gfloat gear_dist = dist + gear_teeth;
+  gfloat base_gear_width = cell_size / 10.0f;
+  gfloat gear_width = base_gear_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 4.0f - gear_width, gear_dist, aa),
+                  lb_coverage_less (gear_dist, cell_size / 4.0f + gear_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_interference (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat wave1 = sinf((tx / tile_size) * 4.0f * (gfloat) G_PI) * (tile_size / 10.0f);
+  gfloat wave2 = sinf((ty / tile_size) * 4.0f * (gfloat) G_PI) * (tile_size / 10.0f);
+  gfloat interference = wave1 + wave2;
+  gfloat base_line_width = tile_size / 20.0f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(interference), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_crystal_shards (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat angle = atan2f(dy, dx);
+  gfloat angle_mod = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 60.0f);
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (angle_mod, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, center_x, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_prism_shards (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat angle = atan2f(dy, dx);
+  gfloat angle_mod = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 45.0f);
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (angle_mod, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, center_x, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_echo_waves (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat wave_spacing = cell_size / 6.0f;
+  gfloat wave_mod = pattern_fmod(dist, wave_spacing);
+  gfloat echo = sinf(dist * 0.2f) * (cell_size / 10.0f);
+  gfloat base_line_width = wave_spacing * 0.2f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (wave_mod + echo, line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_interlocked_rings (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat ring_spacing = cell_size / 4.0f;
+  gfloat ring_mod = pattern_fmod(dist, ring_spacing);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_band (ring_mod, line_width, ring_spacing, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_pulse_waves (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat pulse = sinf(dist * 0.1f) * (cell_size / 8.0f);
+  gfloat wave_spacing = cell_size / 6.0f;
+  gfloat wave_mod = pattern_fmod(dist + pulse, wave_spacing);
+  gfloat base_line_width = wave_spacing * 0.2f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (wave_mod, line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_woven_threads (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave1 = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat wave2 = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat over_under = sinf((tx / tile_size) * 2.0f * (gfloat) G_PI) * sinf((ty / tile_size) * 2.0f * (gfloat) G_PI);
+  coverage = MIN (lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave1)), line_width, aa),
+                  lb_coverage_less (0.0f, over_under, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave2)), line_width, aa),
+                                 lb_coverage (over_under, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_fractal_waves (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat wave = sinf((tx / tile_size) * 4.0f * (gfloat) G_PI) * (tile_size / 10.0f);
+  gfloat sub_wave = sinf((tx / (tile_size / 2.0f)) * 8.0f * (gfloat) G_PI) * (tile_size / 20.0f);
+  gfloat wave_y = sinf((ty / tile_size) * 4.0f * (gfloat) G_PI) * (tile_size / 10.0f);
+  gfloat interference = wave + sub_wave + wave_y;
+  gfloat base_line_width = tile_size / 20.0f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(interference), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_star_weave (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat star_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 45.0f);
+  gfloat star_dist = dist + sinf(angle * 8.0f) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (star_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (star_dist, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_grid_waves_1 (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cx + wave)), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_zigzag_weave_1 (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat zigzag = fabsf(pattern_fmod(cx, cell_size / 2.0f) - cell_size / 4.0f);
+  coverage = lb_coverage_less (fabsf(cy - zigzag), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_diamond_grid_1 (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_tribal_bands_1 (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat band = pattern_fmod(cy, cell_size / 2.0f);
+  coverage = lb_coverage_less (band, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(band - cell_size / 4.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_asanoha_stars_1 (gfloat   tx,
+                         gfloat   ty,
+                         gfloat   tile_size,
+                         gfloat   line_width_scale,
+                         gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cy), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_interlocked_squares_1 (gfloat   tx,
+                               gfloat   ty,
+                               gfloat   tile_size,
+                               gfloat   line_width_scale,
+                               gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 4.0f - line_width, cx, aa),
+                                 MIN (lb_coverage_less (cx, cell_size / 4.0f + line_width, aa),
+                                      MIN (lb_coverage_less (cell_size / 4.0f - line_width, cy, aa),
+                                           lb_coverage_less (cy, cell_size / 4.0f + line_width, aa)))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_spiral_maze_1 (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat spiral = dist - (angle * cell_size / (4.0f * (gfloat) G_PI));
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(spiral, cell_size / 4.0f), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_crests_1 (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave)), line_width, aa),
+                  lb_coverage_less (cy, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_floral_lattice_1 (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa),
+                                 lb_coverage_less (fabsf(cy - cell_size / 2.0f), line_width, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_chevron_stripes_1 (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat chevron = fabsf(pattern_fmod(tx, cell_size) - cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - chevron), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_cherry_blossoms_1 (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat petal_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 72.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (petal_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, cell_size / 4.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_sunburst_motif_1 (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat angle = atan2f(dy, dx);
+  gfloat angle_mod = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 30.0f);
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (angle_mod, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_meander_1 (gfloat   tx,
+                   gfloat   ty,
+                   gfloat   tile_size,
+                   gfloat   line_width_scale,
+                   gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cy, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cx, cell_size / 2.0f, aa),
+                                 MIN (lb_coverage_less (cell_size / 2.0f - line_width, cy, aa),
+                                      lb_coverage_less (cy, cell_size / 2.0f + line_width, aa))));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 2.0f - line_width, cx, aa),
+                                 MIN (lb_coverage_less (cx, cell_size / 2.0f + line_width, aa),
+                                      lb_coverage_less (cy, cell_size / 2.0f, aa))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_double_chevron_bands (gfloat   tx,
+                              gfloat   ty,
+                              gfloat   tile_size,
+                              gfloat   line_width_scale,
+                              gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat chevron1 = fabsf(pattern_fmod(tx, cell_size) - cell_size / 2.0f);
+  gfloat chevron2 = fabsf(pattern_fmod(tx + cell_size / 4.0f, cell_size) - cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - chevron1), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - chevron2), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_overlapping_circle_waves (gfloat   tx,
+                                  gfloat   ty,
+                                  gfloat   tile_size,
+                                  gfloat   line_width_scale,
+                                  gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat wave = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat dx = cx - center_x + wave;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 4.0f - line_width, dist, aa),
+                  lb_coverage_less (dist, cell_size / 4.0f + line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_hexagon_wave_tiles (gfloat   tx,
+                            gfloat   ty,
+                            gfloat   tile_size,
+                            gfloat   line_width_scale,
+                            gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat hex_x = cx / (cell_size * 0.866f);
+  gfloat hex_y = cy / cell_size;
+  gfloat hex_center_x = floorf(hex_x) + 0.5f;
+  gfloat hex_center_y = floorf(hex_y) + 0.5f;
+  if ((gint)floorf(hex_y) % 2 == 1) hex_center_x += 0.5f;
+  gfloat dx = (hex_x - hex_center_x) * cell_size * 0.866f;
+  gfloat dy = (hex_y - hex_center_y) * cell_size;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 2.5f - line_width, dist, aa),
+                  lb_coverage_less (dist, cell_size / 2.5f + line_width, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (dist, cell_size / 2.5f, aa),
+                                 lb_coverage_less (fabsf(dy - wave), line_width, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_frieze_1 (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave)), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_chevron_grid_overlay (gfloat   tx,
+                              gfloat   ty,
+                              gfloat   tile_size,
+                              gfloat   line_width_scale,
+                              gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat chevron = fabsf(pattern_fmod(cx, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - chevron), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cx, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_interlocked_squares_2 (gfloat   tx,
+                               gfloat   ty,
+                               gfloat   tile_size,
+                               gfloat   line_width_scale,
+                               gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 4.0f - line_width, cx, aa),
+                                 MIN (lb_coverage_less (cx, cell_size / 4.0f + line_width, aa),
+                                      lb_coverage_less (cy, cell_size / 2.0f, aa))));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 4.0f - line_width, cy, aa),
+                                 MIN (lb_coverage_less (cy, cell_size / 4.0f + line_width, aa),
+                                      lb_coverage_less (cell_size / 2.0f, cx, aa))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_chevron_ripple_effect (gfloat   tx,
+                               gfloat   ty,
+                               gfloat   tile_size,
+                               gfloat   line_width_scale,
+                               gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat ripple = sinf((tx / tile_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat chevron = fabsf(pattern_fmod(cx, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (chevron + ripple)), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_circle_lattice_flow (gfloat   tx,
+                             gfloat   ty,
+                             gfloat   tile_size,
+                             gfloat   line_width_scale,
+                             gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat flow = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y + flow;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 4.0f - line_width, dist, aa),
+                  lb_coverage_less (dist, cell_size / 4.0f + line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_palmette_waves_1 (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat angle = atan2f(dy, dx);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat palmette_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 90.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (palmette_angle, line_width, hypot (dx, dy) * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dy + wave, cell_size / 4.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_spiral_maze_2 (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat spiral = dist - (angle * cell_size / (3.0f * (gfloat) G_PI));
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(spiral, cell_size / 3.0f), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_key_wave_1 (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 6.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cy, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 2.0f - line_width, cx, aa),
+                                 MIN (lb_coverage_less (cx, cell_size / 2.0f + line_width, aa),
+                                      lb_coverage_less (cy + wave, cell_size / 2.0f, aa))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_anthemion_motif_1 (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat anthemion_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 45.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (anthemion_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, cell_size / 3.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_chevron_maze_1 (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat chevron = fabsf(pattern_fmod(cx, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cy, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (fabsf(cx - chevron), line_width, aa),
+                                 lb_coverage_less (cy, cell_size / 2.0f, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_star_frieze_1 (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat star_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 45.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (star_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  MIN (lb_coverage_less (cell_size / 4.0f, dist, aa),
+                       lb_coverage_less (dist, cell_size / 2.0f, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_lotus_wave_1 (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat lotus_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 60.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (lotus_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist + wave, cell_size / 3.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_star_lattice_1 (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat star_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 45.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (star_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  MIN (lb_coverage_less (cell_size / 3.0f, dist, aa),
+                       lb_coverage_less (dist, cell_size / 2.0f, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_rosette_pattern_1 (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat rosette_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 36.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (rosette_angle, line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  MIN (lb_coverage_less (cell_size / 4.0f, dist, aa),
+                       lb_coverage_less (dist, cell_size / 2.0f, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_concentric_rings (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat ring_spacing = cell_size / 8.0f;
+  gfloat ring_mod = pattern_fmod(dist, ring_spacing);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = MIN (lb_coverage_band (ring_mod, base_line_width, ring_spacing, aa),
+                  lb_coverage_less (dist, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wavy_stripes (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat wave = sinf((tx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat stripe = pattern_fmod(ty + wave, cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.2f * line_width_scale;
+  coverage = lb_coverage_less (stripe, base_line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_zigzag_stripes (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat diag_x = (tx + ty) / sqrtf(2.0f);
+  gfloat diag_y = (ty - tx) / sqrtf(2.0f);
+  gfloat cd = pattern_fmod(diag_x, cell_size);
+  gfloat zigzag = fabsf(pattern_fmod(cd, cell_size / 2.0f) - cell_size / 4.0f) * 2.0f - cell_size / 4.0f;
+  gfloat stripe = pattern_fmod(diag_y + zigzag, cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.2f * line_width_scale;
+  coverage = lb_coverage_less (stripe, base_line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_twisted_ribbons (gfloat   tx,
+                         gfloat   ty,
+                         gfloat   tile_size,
+                         gfloat   line_width_scale,
+                         gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat amplitude = (cell_size / 4.0f) * sinf(ty * (gfloat) G_PI / cell_size);
+  gfloat wave = sinf((ty / cell_size) * 2.0f * (gfloat) G_PI) * amplitude;
+  gfloat stripe = pattern_fmod(tx + wave, cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.2f * line_width_scale;
+  coverage = lb_coverage_less (stripe, base_line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_interfering_waves (gfloat   tx,
+                           gfloat   ty,
+                           gfloat   tile_size,
+                           gfloat   line_width_scale,
+                           gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave_h = sinf((tx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat stripe_h = pattern_fmod(ty + wave_h, cell_size / 2.0f);
+  gfloat wave_v = sinf((ty / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat stripe_v = pattern_fmod(tx + wave_v, cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.2f * line_width_scale;
+  coverage = lb_coverage_less (stripe_h, base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (stripe_v, base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_curved_bands (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat curve = sinf((tx / cell_size) * 1.5f * (gfloat) G_PI) * (cell_size / 3.0f);
+  gfloat band = pattern_fmod(cy + curve, cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.15f * line_width_scale;
+  coverage = lb_coverage_less (band, base_line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_cross (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 5.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 5.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave_x)), base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave_y)), base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_ripple_grid (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat ripple = sinf(dist * 0.2f) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + ripple, cell_size / 4.0f), base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + ripple, cell_size / 4.0f), base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_petal_grid (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat petal_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 40.0f);
+  gfloat base_line_width = cell_size * 0.06f * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (petal_angle, base_line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist, cell_size / 3.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_spikes (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat spike_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 30.0f);
+  gfloat wave = sinf(dist * 0.3f) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.06f * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (spike_angle, base_line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (dist + wave, cell_size / 2.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_circle_weave (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 6.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 6.0f);
+  gfloat base_line_width = cell_size * 0.08f * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 3.0f - base_line_width, dist, aa),
+                  MIN (lb_coverage_less (dist, cell_size / 3.0f + base_line_width, aa),
+                       MAX (lb_coverage_less (fabsf(dx - wave_x), base_line_width, aa),
+                            lb_coverage_less (fabsf(dy - wave_y), base_line_width, aa))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_grid_swirls (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat swirl = dist + angle * cell_size / (4.0f * (gfloat) G_PI);
+  gfloat grid_mod = pattern_fmod(cx, cell_size / 3.0f) + pattern_fmod(cy, cell_size / 3.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = MIN (lb_coverage_less (pattern_fmod(swirl, cell_size / 4.0f), base_line_width, aa),
+                  lb_coverage_less (grid_mod, cell_size / 3.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_braided_strips (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave1 = sinf((cx / cell_size) * 1.5f * (gfloat) G_PI) * (cell_size / 4.0f);
+  gfloat wave2 = sinf((cx / cell_size) * 1.5f * (gfloat) G_PI + (gfloat) G_PI / 2.0f) * (cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave1)), base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave2)), base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_lattice (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx + cy) / cell_size * 2.0f * (gfloat) G_PI) * (cell_size / 5.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + wave, cell_size / 4.0f), base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + wave, cell_size / 4.0f), base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_loop_motif (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat loop_angle = pattern_fmod(angle * 180.0f / (gfloat) G_PI, 90.0f);
+  gfloat loop_dist = dist + sinf(angle * 4.0f) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.06f * line_width_scale;
+  coverage = MIN (lb_coverage_less_scaled (loop_angle, base_line_width, dist * (gfloat) G_PI / 180.0f, aa),
+                  lb_coverage_less (loop_dist, cell_size / 3.0f, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_curve_maze (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat curve = sinf((cx / cell_size) * 1.5f * (gfloat) G_PI) * (cell_size / 3.0f);
+  gfloat maze = pattern_fmod(cy + curve, cell_size / 3.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = lb_coverage_less (maze, base_line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cx, cell_size / 3.0f), base_line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_pulse_grid (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat pulse = sinf((cx + cy) / cell_size * 2.0f * (gfloat) G_PI) * (cell_size / 6.0f);
+  gfloat base_line_width = cell_size * 0.1f * line_width_scale;
+  coverage = MIN (lb_coverage_less (pattern_fmod(cx + pulse, cell_size / 4.0f), base_line_width, aa),
+                  lb_coverage_less (pattern_fmod(cy + pulse, cell_size / 4.0f), base_line_width, aa));
+
+  return coverage;
+}
+
+/* PATTERN_ROW (pattern) defines pattern_row (), the coverage of one row
+ * of pixels with the pattern inlined into its own loop. Antialiasing is
+ * fixed on either side of the loop, so the loop body carries no branch on
+ * the pattern or the antialias flag. */
+#define PATTERN_ROW_LOOP(pattern, antialias)                              \
+  for (i = 0; i < r.width; i++)                                           \
+    coverage[i] = pattern (pattern_wrap (r.tx + i * r.step_x, r.tile_size), \
+                           pattern_wrap (r.ty + i * r.step_y, r.tile_size), \
+                           r.tile_size, r.line_width_scale, antialias)
+
+#define PATTERN_ROW(pattern)                                              \
+static void                                                               \
+pattern##_row (const PatternRow *row,                                     \
+               gfloat           *coverage)                                \
+{                                                                         \
+  const PatternRow r = *row;                                              \
+  gint             i;                                                     \
+                                                                          \
+  if (r.antialias)                                                        \
+    PATTERN_ROW_LOOP (pattern, TRUE);                                     \
+  else                                                                    \
+    PATTERN_ROW_LOOP (pattern, FALSE);                                    \
+}
+
+PATTERN_ROW (pattern_lattice_1)
+PATTERN_ROW (pattern_ripple_effect)
+PATTERN_ROW (pattern_petal_swirls)
+PATTERN_ROW (pattern_checkerboard_waves)
+PATTERN_ROW (pattern_mosaic_tiles)
+PATTERN_ROW (pattern_interlocking_gears)
+PATTERN_ROW (pattern_wave_interference)
+PATTERN_ROW (pattern_crystal_shards)
+PATTERN_ROW (pattern_prism_shards)
+PATTERN_ROW (pattern_echo_waves)
+PATTERN_ROW (pattern_interlocked_rings)
+PATTERN_ROW (pattern_pulse_waves)
+PATTERN_ROW (pattern_woven_threads)
+PATTERN_ROW (pattern_fractal_waves)
+PATTERN_ROW (pattern_star_weave)
+PATTERN_ROW (pattern_grid_waves_1)
+PATTERN_ROW (pattern_zigzag_weave_1)
+PATTERN_ROW (pattern_diamond_grid_1)
+PATTERN_ROW (pattern_tribal_bands_1)
+PATTERN_ROW (pattern_asanoha_stars_1)
+PATTERN_ROW (pattern_interlocked_squares_1)
+PATTERN_ROW (pattern_spiral_maze_1)
+PATTERN_ROW (pattern_wave_crests_1)
+PATTERN_ROW (pattern_floral_lattice_1)
+PATTERN_ROW (pattern_chevron_stripes_1)
+PATTERN_ROW (pattern_cherry_blossoms_1)
+PATTERN_ROW (pattern_sunburst_motif_1)
+PATTERN_ROW (pattern_meander_1)
+PATTERN_ROW (pattern_double_chevron_bands)
+PATTERN_ROW (pattern_overlapping_circle_waves)
+PATTERN_ROW (pattern_hexagon_wave_tiles)
+PATTERN_ROW (pattern_wave_frieze_1)
+PATTERN_ROW (pattern_chevron_grid_overlay)
+PATTERN_ROW (pattern_interlocked_squares_2)
+PATTERN_ROW (pattern_chevron_ripple_effect)
+PATTERN_ROW (pattern_circle_lattice_flow)
+PATTERN_ROW (pattern_palmette_waves_1)
+PATTERN_ROW (pattern_spiral_maze_2)
+PATTERN_ROW (pattern_key_wave_1)
+PATTERN_ROW (pattern_anthemion_motif_1)
+PATTERN_ROW (pattern_chevron_maze_1)
+PATTERN_ROW (pattern_star_frieze_1)
+PATTERN_ROW (pattern_lotus_wave_1)
+PATTERN_ROW (pattern_star_lattice_1)
+PATTERN_ROW (pattern_rosette_pattern_1)
+PATTERN_ROW (pattern_concentric_rings)
+PATTERN_ROW (pattern_wavy_stripes)
+PATTERN_ROW (pattern_zigzag_stripes)
+PATTERN_ROW (pattern_twisted_ribbons)
+PATTERN_ROW (pattern_interfering_waves)
+PATTERN_ROW (pattern_curved_bands)
+PATTERN_ROW (pattern_wave_cross)
+PATTERN_ROW (pattern_ripple_grid)
+PATTERN_ROW (pattern_petal_grid)
+PATTERN_ROW (pattern_wave_spikes)
+PATTERN_ROW (pattern_circle_weave)
+PATTERN_ROW (pattern_grid_swirls)
+PATTERN_ROW (pattern_braided_strips)
+PATTERN_ROW (pattern_wave_lattice)
+PATTERN_ROW (pattern_loop_motif)
+PATTERN_ROW (pattern_curve_maze)
+PATTERN_ROW (pattern_pulse_grid)
+
+static const PatternRowFunc pattern_rows[] =
+{
+  [LATTICE_1]                = pattern_lattice_1_row,
+  [RIPPLE_EFFECT]            = pattern_ripple_effect_row,
+  [PETAL_SWIRLS]             = pattern_petal_swirls_row,
+  [CHECKERBOARD_WAVES]       = pattern_checkerboard_waves_row,
+  [MOSAIC_TILES]             = pattern_mosaic_tiles_row,
+  [INTERLOCKING_GEARS]       = pattern_interlocking_gears_row,
+  [WAVE_INTERFERENCE]        = pattern_wave_interference_row,
+  [CRYSTAL_SHARDS]           = pattern_crystal_shards_row,
+  [PRISM_SHARDS]             = pattern_prism_shards_row,
+  [ECHO_WAVES]               = pattern_echo_waves_row,
+  [INTERLOCKED_RINGS]        = pattern_interlocked_rings_row,
+  [PULSE_WAVES]              = pattern_pulse_waves_row,
+  [WOVEN_THREADS]            = pattern_woven_threads_row,
+  [FRACTAL_WAVES]            = pattern_fractal_waves_row,
+  [STAR_WEAVE]               = pattern_star_weave_row,
+  [GRID_WAVES_1]             = pattern_grid_waves_1_row,
+  [ZIGZAG_WEAVE_1]           = pattern_zigzag_weave_1_row,
+  [DIAMOND_GRID_1]           = pattern_diamond_grid_1_row,
+  [TRIBAL_BANDS_1]           = pattern_tribal_bands_1_row,
+  [ASANOHA_STARS_1]          = pattern_asanoha_stars_1_row,
+  [INTERLOCKED_SQUARES_1]    = pattern_interlocked_squares_1_row,
+  [SPIRAL_MAZE_1]            = pattern_spiral_maze_1_row,
+  [WAVE_CRESTS_1]            = pattern_wave_crests_1_row,
+  [FLORAL_LATTICE_1]         = pattern_floral_lattice_1_row,
+  [CHEVRON_STRIPES_1]        = pattern_chevron_stripes_1_row,
+  [CHERRY_BLOSSOMS_1]        = pattern_cherry_blossoms_1_row,
+  [SUNBURST_MOTIF_1]         = pattern_sunburst_motif_1_row,
+  [MEANDER_1]                = pattern_meander_1_row,
+  [DOUBLE_CHEVRON_BANDS]     = pattern_double_chevron_bands_row,
+  [OVERLAPPING_CIRCLE_WAVES] = pattern_overlapping_circle_waves_row,
+  [HEXAGON_WAVE_TILES]       = pattern_hexagon_wave_tiles_row,
+  [WAVE_FRIEZE_1]            = pattern_wave_frieze_1_row,
+  [CHEVRON_GRID_OVERLAY]     = pattern_chevron_grid_overlay_row,
+  [INTERLOCKED_SQUARES_2]    = pattern_interlocked_squares_2_row,
+  [CHEVRON_RIPPLE_EFFECT]    = pattern_chevron_ripple_effect_row,
+  [CIRCLE_LATTICE_FLOW]      = pattern_circle_lattice_flow_row,
+  [PALMETTE_WAVES_1]         = pattern_palmette_waves_1_row,
+  [SPIRAL_MAZE_2]            = pattern_spiral_maze_2_row,
+  [KEY_WAVE_1]               = pattern_key_wave_1_row,
+  [ANTHEMION_MOTIF_1]        = pattern_anthemion_motif_1_row,
+  [CHEVRON_MAZE_1]           = pattern_chevron_maze_1_row,
+  [STAR_FRIEZE_1]            = pattern_star_frieze_1_row,
+  [LOTUS_WAVE_1]             = pattern_lotus_wave_1_row,
+  [STAR_LATTICE_1]           = pattern_star_lattice_1_row,
+  [ROSETTE_PATTERN_1]        = pattern_rosette_pattern_1_row,
+  [CONCENTRIC_RINGS]         = pattern_concentric_rings_row,
+  [WAVY_STRIPES]             = pattern_wavy_stripes_row,
+  [ZIGZAG_STRIPES]           = pattern_zigzag_stripes_row,
+  [TWISTED_RIBBONS]          = pattern_twisted_ribbons_row,
+  [INTERFERING_WAVES]        = pattern_interfering_waves_row,
+  [CURVED_BANDS]             = pattern_curved_bands_row,
+  [WAVE_CROSS]               = pattern_wave_cross_row,
+  [RIPPLE_GRID]              = pattern_ripple_grid_row,
+  [PETAL_GRID]               = pattern_petal_grid_row,
+  [WAVE_SPIKES]              = pattern_wave_spikes_row,
+  [CIRCLE_WEAVE]             = pattern_circle_weave_row,
+  [GRID_SWIRLS]              = pattern_grid_swirls_row,
+  [BRAIDED_STRIPS]           = pattern_braided_strips_row,
+  [WAVE_LATTICE]             = pattern_wave_lattice_row,
+  [LOOP_MOTIF]               = pattern_loop_motif_row,
+  [CURVE_MAZE]               = pattern_curve_maze_row,
+  [PULSE_GRID]               = pattern_pulse_grid_row,
+};
+
 static gboolean
 process (GeglOperation        *operation,
          GeglOperationContext *context,
@@ -150,1192 +1790,83 @@ process (GeglOperation        *operation,
   gdouble fg_color[4], bg_color[4];
   gdouble tile_size = o->tile_size;
   GeglRectangle rect = *result;
+  PatternRowFunc pattern_row = pattern_rows[o->pattern];
+  PatternRow row;
+  gfloat background[4];
+  gfloat *coverage;
+  gfloat *pixels;
   gint x, y;
 
   // Get color values
   gegl_color_get_rgba (o->foreground_color, &fg_color[0], &fg_color[1], &fg_color[2], &fg_color[3]);
   gegl_color_get_rgba (o->background_color, &bg_color[0], &bg_color[1], &bg_color[2], &bg_color[3]);
+  gfloat fg_rgb[3] = { fg_color[0], fg_color[1], fg_color[2] };
+
+  if (o->transparent_background)
+  {
+    background[0] = 0.0;
+    background[1] = 0.0;
+    background[2] = 0.0;
+    background[3] = 0.0;
+  }
+  else
+  {
+    background[0] = bg_color[0];
+    background[1] = bg_color[1];
+    background[2] = bg_color[2];
+    background[3] = 1.0;
+  }
+
+  row.tile_size = tile_size;
+  row.line_width_scale = o->line_width;
+  row.antialias = o->antialias;
+  row.width = rect.width;
 
   // Convert rotation to radians
   gdouble rotation_rad = o->rotation * G_PI / 180.0;
   gdouble cos_rot = cos(rotation_rad);
   gdouble sin_rot = sin(rotation_rad);
 
+  // Rotated coordinates move by a fixed step along a row
+  row.step_x = cos_rot;
+  row.step_y = sin_rot;
+
+  coverage = g_new (gfloat, rect.width);
+  pixels = g_new (gfloat, rect.width * 4);
+
   for (y = rect.y; y < rect.y + rect.height; y++)
   {
-    for (x = rect.x; x < rect.x + rect.width; x++)
+    gdouble px = (gdouble)rect.x;
+    gdouble py = (gdouble)y;
+
+    // Apply rotation to the original pixel coordinates around (0, 0)
+    gdouble px_rot = px * cos_rot - py * sin_rot;
+    gdouble py_rot = px * sin_rot + py * cos_rot;
+
+    // Map the row's first pixel to tile space
+    gdouble tx = fmod(px_rot, tile_size);
+    gdouble ty = fmod(py_rot, tile_size);
+    if (tx < 0) tx += tile_size;
+    if (ty < 0) ty += tile_size;
+
+    row.tx = tx;
+    row.ty = ty;
+    pattern_row (&row, coverage);
+
+    for (x = 0; x < rect.width; x++)
     {
-      gdouble px = (gdouble)x;
-      gdouble py = (gdouble)y;
-
-      // Apply rotation to the original pixel coordinates around (0, 0)
-      gdouble px_rot = px * cos_rot - py * sin_rot;
-      gdouble py_rot = px * sin_rot + py * cos_rot;
-
-      // Map rotated coordinates to tile space
-      gdouble tx = fmod(px_rot, tile_size);
-      gdouble ty = fmod(py_rot, tile_size);
-      if (tx < 0) tx += tile_size;
-      if (ty < 0) ty += tile_size;
-
-      gfloat out[4];
-      gboolean in_shape = FALSE;
-
-      switch (o->pattern)
-      {
-        case LATTICE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cx - cy) < line_width || fabs(cx + cy - cell_size) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case RIPPLE_EFFECT:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble ripple_spacing = cell_size / 8.0;
-          gdouble ripple_dist = fmod(dist, ripple_spacing);
-          gdouble base_line_width = ripple_spacing * 0.2;
-          gdouble line_width = base_line_width * o->line_width;
-          if (ripple_dist < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PETAL_SWIRLS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble petal_angle = fmod(angle * 180.0 / G_PI, 60.0);
-          gdouble petal_dist = dist + sin(angle * 6.0) * (cell_size / 8.0);
-          gdouble base_petal_width = cell_size / 10.0;
-          gdouble petal_width = base_petal_width * o->line_width;
-          if (petal_angle < petal_width && petal_dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHECKERBOARD_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gint cell_x = (gint)(tx / cell_size);
-          gint cell_y = (gint)(ty / cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if ((cell_x + cell_y) % 2 == 0)
-          {
-            if (fabs(cy - (cell_size / 2.0 + wave)) < line_width)
-            {
-              in_shape = TRUE;
-            }
-          }
-          else
-          {
-            wave = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-            if (fabs(cx - (cell_size / 2.0 + wave)) < line_width)
-            {
-              in_shape = TRUE;
-            }
-          }
-          break;
-        }
-        case MOSAIC_TILES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          if (fabs(cx - (cell_size / 2.0 + wave_x)) < line_width ||
-              fabs(cy - (cell_size / 2.0 + wave_y)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case INTERLOCKING_GEARS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble gear_teeth = sin(angle * 8.0) * (cell_size / 8.0);
-          gdouble gear_dist = dist + gear_teeth;
-          gdouble base_gear_width = cell_size / 10.0;
-          gdouble gear_width = base_gear_width * o->line_width;
-          if (gear_dist > cell_size / 4.0 - gear_width && gear_dist < cell_size / 4.0 + gear_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_INTERFERENCE:
-        {
-          gdouble wave1 = sin((tx / tile_size) * 4.0 * G_PI) * (tile_size / 10.0);
-          gdouble wave2 = sin((ty / tile_size) * 4.0 * G_PI) * (tile_size / 10.0);
-          gdouble interference = wave1 + wave2;
-          gdouble base_line_width = tile_size / 20.0;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(interference) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CRYSTAL_SHARDS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble angle = atan2(dy, dx);
-          gdouble angle_mod = fmod(angle * 180.0 / G_PI, 60.0);
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (angle_mod < line_width && dist < center_x)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PRISM_SHARDS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble angle = atan2(dy, dx);
-          gdouble angle_mod = fmod(angle * 180.0 / G_PI, 45.0);
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (angle_mod < line_width && dist < center_x)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ECHO_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble wave_spacing = cell_size / 6.0;
-          gdouble wave_mod = fmod(dist, wave_spacing);
-          gdouble echo = sin(dist * 0.2) * (cell_size / 10.0);
-          gdouble base_line_width = wave_spacing * 0.2;
-          gdouble line_width = base_line_width * o->line_width;
-          if (wave_mod + echo < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case INTERLOCKED_RINGS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble ring_spacing = cell_size / 4.0;
-          gdouble ring_mod = fmod(dist, ring_spacing);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (ring_mod < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PULSE_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble pulse = sin(dist * 0.1) * (cell_size / 8.0);
-          gdouble wave_spacing = cell_size / 6.0;
-          gdouble wave_mod = fmod(dist + pulse, wave_spacing);
-          gdouble base_line_width = wave_spacing * 0.2;
-          gdouble line_width = base_line_width * o->line_width;
-          if (wave_mod < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WOVEN_THREADS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave1 = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble wave2 = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble over_under = sin((tx / tile_size) * 2.0 * G_PI) * sin((ty / tile_size) * 2.0 * G_PI);
-          if (fabs(cx - (cell_size / 2.0 + wave1)) < line_width && over_under > 0)
-          {
-            in_shape = TRUE;
-          }
-          if (fabs(cy - (cell_size / 2.0 + wave2)) < line_width && over_under <= 0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case FRACTAL_WAVES:
-        {
-          gdouble wave = sin((tx / tile_size) * 4.0 * G_PI) * (tile_size / 10.0);
-          gdouble sub_wave = sin((tx / (tile_size / 2.0)) * 8.0 * G_PI) * (tile_size / 20.0);
-          gdouble wave_y = sin((ty / tile_size) * 4.0 * G_PI) * (tile_size / 10.0);
-          gdouble interference = wave + sub_wave + wave_y;
-          gdouble base_line_width = tile_size / 20.0;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(interference) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case STAR_WEAVE:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble star_angle = fmod(angle * 180.0 / G_PI, 45.0);
-          gdouble star_dist = dist + sin(angle * 8.0) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (star_angle < line_width && star_dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case GRID_WAVES_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cy - (cx + wave)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ZIGZAG_WEAVE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble zigzag = fabs(fmod(cx, cell_size / 2.0) - cell_size / 4.0);
-          if (fabs(cy - zigzag) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DIAMOND_GRID_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width &&
-              fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TRIBAL_BANDS_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble band = fmod(cy, cell_size / 2.0);
-          if (band < line_width || fabs(band - cell_size / 4.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ASANOHA_STARS_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width &&
-              fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cx - cy) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case INTERLOCKED_SQUARES_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx > cell_size / 4.0 - line_width && cx < cell_size / 4.0 + line_width &&
-                   cy > cell_size / 4.0 - line_width && cy < cell_size / 4.0 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SPIRAL_MAZE_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble spiral = dist - (angle * cell_size / (4.0 * G_PI));
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(spiral, cell_size / 4.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_CRESTS_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + wave)) < line_width && cy < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case FLORAL_LATTICE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cx - cell_size / 2.0) < line_width && fabs(cy - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHEVRON_STRIPES_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cy = fmod(ty, cell_size);
-          gdouble chevron = fabs(fmod(tx, cell_size) - cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - chevron) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHERRY_BLOSSOMS_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble petal_angle = fmod(angle * 180.0 / G_PI, 72.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (petal_angle < line_width && dist < cell_size / 4.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SUNBURST_MOTIF_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble angle = atan2(dy, dx);
-          gdouble angle_mod = fmod(angle * 180.0 / G_PI, 30.0);
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (angle_mod < line_width && dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case MEANDER_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx < cell_size / 2.0 && cy > cell_size / 2.0 - line_width && cy < cell_size / 2.0 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx > cell_size / 2.0 - line_width && cx < cell_size / 2.0 + line_width && cy < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DOUBLE_CHEVRON_BANDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cy = fmod(ty, cell_size);
-          gdouble chevron1 = fabs(fmod(tx, cell_size) - cell_size / 2.0);
-          gdouble chevron2 = fabs(fmod(tx + cell_size / 4.0, cell_size) - cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - chevron1) < line_width || fabs(cy - chevron2) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case OVERLAPPING_CIRCLE_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble wave = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble dx = cx - center_x + wave;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 4.0 - line_width && dist < cell_size / 4.0 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case HEXAGON_WAVE_TILES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble hex_x = cx / (cell_size * 0.866);
-          gdouble hex_y = cy / cell_size;
-          gdouble hex_center_x = floor(hex_x) + 0.5;
-          gdouble hex_center_y = floor(hex_y) + 0.5;
-          if ((gint)floor(hex_y) % 2 == 1) hex_center_x += 0.5;
-          gdouble dx = (hex_x - hex_center_x) * cell_size * 0.866;
-          gdouble dy = (hex_y - hex_center_y) * cell_size;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 2.5 - line_width && dist < cell_size / 2.5 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (dist < cell_size / 2.5 && fabs(dy - wave) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_FRIEZE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + wave)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHEVRON_GRID_OVERLAY:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble chevron = fabs(fmod(cx, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - chevron) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx < line_width || cx > cell_size - line_width ||
-                   cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case INTERLOCKED_SQUARES_2:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx > cell_size / 4.0 - line_width && cx < cell_size / 4.0 + line_width &&
-                   cy < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          else if (cy > cell_size / 4.0 - line_width && cy < cell_size / 4.0 + line_width &&
-                   cx > cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHEVRON_RIPPLE_EFFECT:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble ripple = sin((tx / tile_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble chevron = fabs(fmod(cx, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (chevron + ripple)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CIRCLE_LATTICE_FLOW:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble flow = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y + flow;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 4.0 - line_width && dist < cell_size / 4.0 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PALMETTE_WAVES_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble angle = atan2(dy, dx);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble palmette_angle = fmod(angle * 180.0 / G_PI, 90.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (palmette_angle < line_width && dy + wave < cell_size / 4.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SPIRAL_MAZE_2:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble spiral = dist - (angle * cell_size / (3.0 * G_PI));
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(spiral, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case KEY_WAVE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 6.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx > cell_size / 2.0 - line_width && cx < cell_size / 2.0 + line_width && cy + wave < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ANTHEMION_MOTIF_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble anthemion_angle = fmod(angle * 180.0 / G_PI, 45.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (anthemion_angle < line_width && dist < cell_size / 3.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CHEVRON_MAZE_1:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble chevron = fabs(fmod(cx, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cx - chevron) < line_width && cy < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case STAR_FRIEZE_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble star_angle = fmod(angle * 180.0 / G_PI, 45.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (star_angle < line_width && dist > cell_size / 4.0 && dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case LOTUS_WAVE_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble lotus_angle = fmod(angle * 180.0 / G_PI, 60.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (lotus_angle < line_width && dist + wave < cell_size / 3.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case STAR_LATTICE_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble star_angle = fmod(angle * 180.0 / G_PI, 45.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (star_angle < line_width && dist > cell_size / 3.0 && dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ROSETTE_PATTERN_1:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble rosette_angle = fmod(angle * 180.0 / G_PI, 36.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (rosette_angle < line_width && dist > cell_size / 4.0 && dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CONCENTRIC_RINGS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble ring_spacing = cell_size / 8.0;
-          gdouble ring_mod = fmod(dist, ring_spacing);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (ring_mod < base_line_width && dist < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVY_STRIPES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble wave = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble stripe = fmod(ty + wave, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.2 * o->line_width;
-          if (stripe < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ZIGZAG_STRIPES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble diag_x = (tx + ty) / sqrt(2.0);
-          gdouble diag_y = (ty - tx) / sqrt(2.0);
-          gdouble cd = fmod(diag_x, cell_size);
-          gdouble zigzag = fabs(fmod(cd, cell_size / 2.0) - cell_size / 4.0) * 2.0 - cell_size / 4.0;
-          gdouble stripe = fmod(diag_y + zigzag, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.2 * o->line_width;
-          if (stripe < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TWISTED_RIBBONS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble amplitude = (cell_size / 4.0) * sin(ty * G_PI / cell_size);
-          gdouble wave = sin((ty / cell_size) * 2.0 * G_PI) * amplitude;
-          gdouble stripe = fmod(tx + wave, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.2 * o->line_width;
-          if (stripe < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case INTERFERING_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave_h = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble stripe_h = fmod(ty + wave_h, cell_size / 2.0);
-          gdouble wave_v = sin((ty / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble stripe_v = fmod(tx + wave_v, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.2 * o->line_width;
-          if (stripe_h < base_line_width || stripe_v < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CURVED_BANDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cy = fmod(ty, cell_size);
-          gdouble curve = sin((tx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
-          gdouble band = fmod(cy + curve, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (band < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_CROSS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 5.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 5.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(cx - (cell_size / 2.0 + wave_x)) < base_line_width ||
-              fabs(cy - (cell_size / 2.0 + wave_y)) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case RIPPLE_GRID:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble ripple = sin(dist * 0.2) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fmod(cx + ripple, cell_size / 4.0) < base_line_width ||
-              fmod(cy + ripple, cell_size / 4.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PETAL_GRID:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble petal_angle = fmod(angle * 180.0 / G_PI, 40.0);
-          gdouble base_line_width = cell_size * 0.06 * o->line_width;
-          if (petal_angle < base_line_width && dist < cell_size / 3.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_SPIKES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble spike_angle = fmod(angle * 180.0 / G_PI, 30.0);
-          gdouble wave = sin(dist * 0.3) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.06 * o->line_width;
-          if (spike_angle < base_line_width && dist + wave < cell_size / 2.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CIRCLE_WEAVE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 6.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 6.0);
-          gdouble base_line_width = cell_size * 0.08 * o->line_width;
-          if (dist > cell_size / 3.0 - base_line_width && dist < cell_size / 3.0 + base_line_width &&
-              (fabs(dx - wave_x) < base_line_width || fabs(dy - wave_y) < base_line_width))
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case GRID_SWIRLS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble swirl = dist + angle * cell_size / (4.0 * G_PI);
-          gdouble grid_mod = fmod(cx, cell_size / 3.0) + fmod(cy, cell_size / 3.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fmod(swirl, cell_size / 4.0) < base_line_width && grid_mod < cell_size / 3.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case BRAIDED_STRIPS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave1 = sin((cx / cell_size) * 1.5 * G_PI) * (cell_size / 4.0);
-          gdouble wave2 = sin((cx / cell_size) * 1.5 * G_PI + G_PI / 2.0) * (cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + wave1)) < base_line_width ||
-              fabs(cy - (cell_size / 2.0 + wave2)) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_LATTICE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx + cy) / cell_size * 2.0 * G_PI) * (cell_size / 5.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fmod(cx + wave, cell_size / 4.0) < base_line_width ||
-              fmod(cy + wave, cell_size / 4.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case LOOP_MOTIF:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble loop_angle = fmod(angle * 180.0 / G_PI, 90.0);
-          gdouble loop_dist = dist + sin(angle * 4.0) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.06 * o->line_width;
-          if (loop_angle < base_line_width && loop_dist < cell_size / 3.0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CURVE_MAZE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble curve = sin((cx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
-          gdouble maze = fmod(cy + curve, cell_size / 3.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (maze < base_line_width || fmod(cx, cell_size / 3.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case PULSE_GRID:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble pulse = sin((cx + cy) / cell_size * 2.0 * G_PI) * (cell_size / 6.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fmod(cx + pulse, cell_size / 4.0) < base_line_width &&
-              fmod(cy + pulse, cell_size / 4.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-      }
-
-      if (in_shape)
-      {
-        out[0] = fg_color[0];
-        out[1] = fg_color[1];
-        out[2] = fg_color[2];
-        out[3] = 1.0;
-      }
-      else
-      {
-        if (o->transparent_background)
-        {
-          out[0] = 0.0;
-          out[1] = 0.0;
-          out[2] = 0.0;
-          out[3] = 0.0;
-        }
-        else
-        {
-          out[0] = bg_color[0];
-          out[1] = bg_color[1];
-          out[2] = bg_color[2];
-          out[3] = 1.0;
-        }
-      }
-
-      gegl_buffer_set (output, GEGL_RECTANGLE (x, y, 1, 1), 0, babl_format ("RGBA float"), out, GEGL_AUTO_ROWSTRIDE);
+      gfloat *out = pixels + x * 4;
+
+      memcpy (out, background, sizeof (background));
+      lb_coverage_over (out, fg_rgb, coverage[x]);
     }
+
+    gegl_buffer_set (output, GEGL_RECTANGLE (rect.x, y, rect.width, 1), 0, babl_format ("RGBA float"), pixels, GEGL_AUTO_ROWSTRIDE);
   }
 
+  g_free (coverage);
+  g_free (pixels);
+
   return TRUE;
 }
 
@@ -1345,6 +1876,7 @@ gegl_op_class_init (GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   operation_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
@@ -18,6 +18,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -99,6 +101,9 @@ property_color(background_color, _("Background Color"), "#A3CFFF")
 property_boolean(transparent_background, _("Transparent Background"), FALSE)
     description(_("Make the background transparent instead of using the background color"))
 
+property_boolean(antialias, _("Antialiasing"), FALSE)
+    description(_("Smooth the pattern edges using their distance to each pixel"))
+
 #else
 
 #define GEGL_OP_POINT_FILTER
@@ -109,7 +114,7 @@ property_boolean(transparent_background, _("Transparent Background"), FALSE)
 
 static void prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static GeglRectangle get_bounding_box (GeglOperation *operation)
@@ -117,6 +122,909 @@ static GeglRectangle get_bounding_box (GeglOperation *operation)
   return gegl_rectangle_infinite_plane ();
 }
 
+typedef struct
+{
+  gfloat   tx, ty;           /* tile space position of the row's first pixel */
+  gfloat   step_x, step_y;   /* tile space step per output pixel */
+  gfloat   tile_size;
+  gfloat   line_width_scale;
+  gboolean antialias;
+  gint     width;
+} PatternRow;
+
+typedef void (* PatternRowFunc) (const PatternRow *row,
+                                 gfloat           *coverage);
+
+/* Wrap a tile space coordinate back into [0, tile_size) */
+static inline gfloat
+pattern_wrap (gfloat t,
+              gfloat tile_size)
+{
+  t -= tile_size * floorf (t / tile_size);
+  t  = t < 0.0f ? t + tile_size : t;
+
+  return t < tile_size ? t : t - tile_size;
+}
+
+/* fmodf () as a truncated division; libm's exact fmodf () loops over the
+ * exponent difference and cannot be inlined into the row loops */
+static inline gfloat
+pattern_fmod (gfloat a,
+              gfloat b)
+{
+  return a - b * truncf (a / b);
+}
+
+static inline gfloat
+pattern_micro_grid (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat wave = sinf((cx + cy) / cell_size * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  coverage = lb_coverage_less (pattern_fmod(cx + wave, cell_size / 3.0f), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + wave, cell_size / 3.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_curved_lattice (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave_x)), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave_y)), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_mini_waves (gfloat   tx,
+                    gfloat   ty,
+                    gfloat   tile_size,
+                    gfloat   line_width_scale,
+                    gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 3.0f * (gfloat) G_PI) * (cell_size / 6.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave)), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_arc_weave (gfloat   tx,
+                   gfloat   ty,
+                   gfloat   tile_size,
+                   gfloat   line_width_scale,
+                   gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat arc = sinf(angle * 3.0f) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 3.0f - line_width, dist, aa),
+                  MIN (lb_coverage_less (dist, cell_size / 3.0f + line_width, aa),
+                       lb_coverage_less (fabsf(arc), line_width, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_triangle_tiles (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_woven_strips (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave1 = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat wave2 = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  gfloat over_under = sinf((tx / tile_size) * 2.0f * (gfloat) G_PI) * sinf((ty / tile_size) * 2.0f * (gfloat) G_PI);
+  coverage = MIN (lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave1)), line_width, aa),
+                  lb_coverage_less (0.0f, over_under, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave2)), line_width, aa),
+                                 lb_coverage (over_under, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_offset_squares (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 4.0f - line_width, cx, aa),
+                                 MIN (lb_coverage_less (cx, cell_size / 4.0f + line_width, aa),
+                                      MIN (lb_coverage_less (cell_size / 4.0f - line_width, cy, aa),
+                                           lb_coverage_less (cy, cell_size / 4.0f + line_width, aa)))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_grid_diamonds (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - cell_size / 2.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wave_triangles (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy + wave), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size + wave), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_shifted_grid (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat shift = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + shift, cell_size / 3.0f), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy, cell_size / 3.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_zigzag_tiles (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat zigzag_x = fabsf(pattern_fmod(cx, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat zigzag_y = fabsf(pattern_fmod(cy, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - zigzag_y), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - zigzag_x), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_double_wave_grid (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave1 = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat wave2 = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + wave1 + wave2, cell_size / 3.0f), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + wave1 + wave2, cell_size / 3.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_circle_arcs (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat arc = sinf(angle * 4.0f) * (cell_size / 12.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 4.0f - line_width, dist, aa),
+                  MIN (lb_coverage_less (dist, cell_size / 4.0f + line_width, aa),
+                       lb_coverage_less (fabsf(arc), line_width, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_double_triangles (gfloat   tx,
+                          gfloat   ty,
+                          gfloat   tile_size,
+                          gfloat   line_width_scale,
+                          gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size), line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_diamond_cross (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_net (gfloat   tx,
+             gfloat   ty,
+             gfloat   tile_size,
+             gfloat   line_width_scale,
+             gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy + wave), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size + wave), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_crossed_squares (gfloat   tx,
+                         gfloat   ty,
+                         gfloat   tile_size,
+                         gfloat   line_width_scale,
+                         gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy, aa));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_tilted_zigzag (gfloat   tx,
+                       gfloat   ty,
+                       gfloat   tile_size,
+                       gfloat   line_width_scale,
+                       gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat diag = cx + cy;
+  gfloat zigzag = fabsf(pattern_fmod(diag, cell_size / 2.0f) - cell_size / 4.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy - zigzag), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_diamond_layers (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx + cy) / cell_size * (gfloat) G_PI) * (cell_size / 12.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width + wave, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width + wave, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 3.0f + line_width + wave, aa),
+                                 lb_coverage_less (cell_size / 3.0f - line_width + wave, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa)));
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx - cell_size / 2.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_layered_squares (gfloat   tx,
+                         gfloat   ty,
+                         gfloat   tile_size,
+                         gfloat   line_width_scale,
+                         gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx + cy) / cell_size * 2.0f * (gfloat) G_PI) * (cell_size / 12.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (cx + wave, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cx + wave, aa));
+  coverage = MAX (coverage, lb_coverage_less (cy + wave, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cell_size - line_width, cy + wave, aa));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 4.0f - line_width, cx + wave, aa),
+                                 MIN (lb_coverage_less (cx + wave, cell_size / 4.0f + line_width, aa),
+                                      MIN (lb_coverage_less (cell_size / 4.0f - line_width, cy + wave, aa),
+                                           lb_coverage_less (cy + wave, cell_size / 4.0f + line_width, aa)))));
+  coverage = MAX (coverage, MIN (lb_coverage_less (cell_size / 3.0f - line_width, cx + wave, aa),
+                                 MIN (lb_coverage_less (cx + wave, cell_size / 3.0f + line_width, aa),
+                                      MIN (lb_coverage_less (cell_size / 3.0f - line_width, cy + wave, aa),
+                                           lb_coverage_less (cy + wave, cell_size / 3.0f + line_width, aa)))));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_triangle_weave (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat diag1 = fabsf(cx - cy + wave);
+  gfloat diag2 = fabsf(cx + cy - cell_size + wave);
+  gfloat cross = fabsf(cx - cell_size / 2.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (diag1, line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (diag2, line_width, aa));
+  coverage = MAX (coverage, lb_coverage_less (cross, line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_flowing_curves (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI + (cy / cell_size) * (gfloat) G_PI) * (cell_size / 8.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave)), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_wavy_grid (gfloat   tx,
+                   gfloat   ty,
+                   gfloat   tile_size,
+                   gfloat   line_width_scale,
+                   gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + wave_x, cell_size / 3.0f), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + wave_y, cell_size / 3.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_arc_fans (gfloat   tx,
+                  gfloat   ty,
+                  gfloat   tile_size,
+                  gfloat   line_width_scale,
+                  gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat angle = atan2f(dy, dx);
+  gfloat arc = sinf(angle * 3.0f + (dist / cell_size) * (gfloat) G_PI) * (cell_size / 12.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (cell_size / 3.0f - line_width, dist, aa),
+                  MIN (lb_coverage_less (dist, cell_size / 3.0f + line_width, aa),
+                       lb_coverage_less (fabsf(arc), line_width, aa)));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_curved_cross (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave_x = sinf((cy / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat wave_y = sinf((cx / cell_size) * 2.0f * (gfloat) G_PI) * (cell_size / 10.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + wave_x)), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + wave_y)), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_curved_diamonds (gfloat   tx,
+                         gfloat   ty,
+                         gfloat   tile_size,
+                         gfloat   line_width_scale,
+                         gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat wave = sinf((cx + cy) / cell_size * (gfloat) G_PI) * (cell_size / 12.0f);
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = MIN (lb_coverage_less (fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), cell_size / 4.0f + line_width + wave, aa),
+                  lb_coverage_less (cell_size / 4.0f - line_width + wave, fabsf(cx - cell_size / 2.0f) + fabsf(cy - cell_size / 2.0f), aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_angled_bands (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat shift = pattern_fmod(cx + cy, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + cy + shift, cell_size / 3.0f), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_folded_grid (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat fold_x = pattern_fmod(cx, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat fold_y = pattern_fmod(cy, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (pattern_fmod(cx + fold_x, cell_size / 3.0f), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (pattern_fmod(cy + fold_y, cell_size / 3.0f), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_jagged_lines (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat jag = pattern_fmod(cx, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cy - (cell_size / 2.0f + jag)), line_width, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_triangle_bands (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat shift = pattern_fmod(cx, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - cy + shift), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cx + cy - cell_size + shift), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_skewed_cross (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat shift = pattern_fmod(cx + cy, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat base_line_width = cell_size * 0.05f;
+  gfloat line_width = base_line_width * line_width_scale;
+  coverage = lb_coverage_less (fabsf(cx - (cell_size / 2.0f + shift)), line_width, aa);
+  coverage = MAX (coverage, lb_coverage_less (fabsf(cy - (cell_size / 2.0f + shift)), line_width, aa));
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_dot_grid (gfloat   tx,
+                  gfloat   ty,
+                  gfloat   tile_size,
+                  gfloat   line_width_scale,
+                  gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_dot_size = cell_size * 0.1f;
+  gfloat dot_size = base_dot_size * line_width_scale;
+  coverage = lb_coverage_less (dist, dot_size, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_offset_dots (gfloat   tx,
+                     gfloat   ty,
+                     gfloat   tile_size,
+                     gfloat   line_width_scale,
+                     gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat shift = pattern_fmod(cx + cy, cell_size / 2.0f) < cell_size / 4.0f ? cell_size / 8.0f : -cell_size / 8.0f;
+  gfloat center_x = cell_size / 2.0f + shift;
+  gfloat center_y = cell_size / 2.0f + shift;
+  gfloat dx = cx - center_x;
+  gfloat dy = cy - center_y;
+  gfloat dist = sqrtf(dx * dx + dy * dy);
+  gfloat base_dot_size = cell_size * 0.1f;
+  gfloat dot_size = base_dot_size * line_width_scale;
+  coverage = lb_coverage_less (dist, dot_size, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_diamond_dots (gfloat   tx,
+                      gfloat   ty,
+                      gfloat   tile_size,
+                      gfloat   line_width_scale,
+                      gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 4.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat center_x = cell_size / 2.0f;
+  gfloat center_y = cell_size / 2.0f;
+  gfloat dx = fabsf(cx - center_x);
+  gfloat dy = fabsf(cy - center_y);
+  gfloat dist = dx + dy; // Manhattan distance for diamond shape
+  gfloat base_dot_size = cell_size * 0.1f;
+  gfloat dot_size = base_dot_size * line_width_scale;
+  coverage = lb_coverage_less (dist, dot_size, aa);
+
+  return coverage;
+}
+
+static inline gfloat
+pattern_clustered_dots (gfloat   tx,
+                        gfloat   ty,
+                        gfloat   tile_size,
+                        gfloat   line_width_scale,
+                        gboolean aa)
+{
+  gfloat coverage = 0.0f;
+  gfloat cell_size = tile_size / 5.0f;
+  gfloat cx = pattern_fmod(tx, cell_size);
+  gfloat cy = pattern_fmod(ty, cell_size);
+  gfloat base_dot_size = cell_size * 0.08f;
+  gfloat dot_size = base_dot_size * line_width_scale;
+  gfloat centers[4][2] = {
+    {cell_size / 4.0f, cell_size / 4.0f},
+    {3.0f * cell_size / 4.0f, cell_size / 4.0f},
+    {cell_size / 4.0f, 3.0f * cell_size / 4.0f},
+    {3.0f * cell_size / 4.0f, 3.0f * cell_size / 4.0f}
+  };
+  for (int i = 0; i < 4; i++)
+  {
+    gfloat dx = cx - centers[i][0];
+    gfloat dy = cy - centers[i][1];
+    gfloat dist = sqrtf(dx * dx + dy * dy);
+    coverage = MAX (coverage, lb_coverage_less (dist, dot_size, aa));
+  }
+
+  return coverage;
+}
+
+/* PATTERN_ROW (pattern) defines pattern_row (), the coverage of one row
+ * of pixels with the pattern inlined into its own loop. Antialiasing is
+ * fixed on either side of the loop, so the loop body carries no branch on
+ * the pattern or the antialias flag. */
+#define PATTERN_ROW_LOOP(pattern, antialias)                              \
+  for (i = 0; i < r.width; i++)                                           \
+    coverage[i] = pattern (pattern_wrap (r.tx + i * r.step_x, r.tile_size), \
+                           pattern_wrap (r.ty + i * r.step_y, r.tile_size), \
+                           r.tile_size, r.line_width_scale, antialias)
+
+#define PATTERN_ROW(pattern)                                              \
+static void                                                               \
+pattern##_row (const PatternRow *row,                                     \
+               gfloat           *coverage)                                \
+{                                                                         \
+  const PatternRow r = *row;                                              \
+  gint             i;                                                     \
+                                                                          \
+  if (r.antialias)                                                        \
+    PATTERN_ROW_LOOP (pattern, TRUE);                                     \
+  else                                                                    \
+    PATTERN_ROW_LOOP (pattern, FALSE);                                    \
+}
+
+PATTERN_ROW (pattern_micro_grid)
+PATTERN_ROW (pattern_curved_lattice)
+PATTERN_ROW (pattern_mini_waves)
+PATTERN_ROW (pattern_arc_weave)
+PATTERN_ROW (pattern_triangle_tiles)
+PATTERN_ROW (pattern_woven_strips)
+PATTERN_ROW (pattern_offset_squares)
+PATTERN_ROW (pattern_grid_diamonds)
+PATTERN_ROW (pattern_wave_triangles)
+PATTERN_ROW (pattern_shifted_grid)
+PATTERN_ROW (pattern_zigzag_tiles)
+PATTERN_ROW (pattern_double_wave_grid)
+PATTERN_ROW (pattern_circle_arcs)
+PATTERN_ROW (pattern_double_triangles)
+PATTERN_ROW (pattern_diamond_cross)
+PATTERN_ROW (pattern_net)
+PATTERN_ROW (pattern_crossed_squares)
+PATTERN_ROW (pattern_tilted_zigzag)
+PATTERN_ROW (pattern_diamond_layers)
+PATTERN_ROW (pattern_layered_squares)
+PATTERN_ROW (pattern_triangle_weave)
+PATTERN_ROW (pattern_flowing_curves)
+PATTERN_ROW (pattern_wavy_grid)
+PATTERN_ROW (pattern_arc_fans)
+PATTERN_ROW (pattern_curved_cross)
+PATTERN_ROW (pattern_curved_diamonds)
+PATTERN_ROW (pattern_angled_bands)
+PATTERN_ROW (pattern_folded_grid)
+PATTERN_ROW (pattern_jagged_lines)
+PATTERN_ROW (pattern_triangle_bands)
+PATTERN_ROW (pattern_skewed_cross)
+PATTERN_ROW (pattern_dot_grid)
+PATTERN_ROW (pattern_offset_dots)
+PATTERN_ROW (pattern_diamond_dots)
+PATTERN_ROW (pattern_clustered_dots)
+
+static const PatternRowFunc pattern_rows[] =
+{
+  [MICRO_GRID]       = pattern_micro_grid_row,
+  [CURVED_LATTICE]   = pattern_curved_lattice_row,
+  [MINI_WAVES]       = pattern_mini_waves_row,
+  [ARC_WEAVE]        = pattern_arc_weave_row,
+  [TRIANGLE_TILES]   = pattern_triangle_tiles_row,
+  [WOVEN_STRIPS]     = pattern_woven_strips_row,
+  [OFFSET_SQUARES]   = pattern_offset_squares_row,
+  [GRID_DIAMONDS]    = pattern_grid_diamonds_row,
+  [WAVE_TRIANGLES]   = pattern_wave_triangles_row,
+  [SHIFTED_GRID]     = pattern_shifted_grid_row,
+  [ZIGZAG_TILES]     = pattern_zigzag_tiles_row,
+  [DOUBLE_WAVE_GRID] = pattern_double_wave_grid_row,
+  [CIRCLE_ARCS]      = pattern_circle_arcs_row,
+  [DOUBLE_TRIANGLES] = pattern_double_triangles_row,
+  [DIAMOND_CROSS]    = pattern_diamond_cross_row,
+  [NET]              = pattern_net_row,
+  [CROSSED_SQUARES]  = pattern_crossed_squares_row,
+  [TILTED_ZIGZAG]    = pattern_tilted_zigzag_row,
+  [DIAMOND_LAYERS]   = pattern_diamond_layers_row,
+  [LAYERED_SQUARES]  = pattern_layered_squares_row,
+  [TRIANGLE_WEAVE]   = pattern_triangle_weave_row,
+  [FLOWING_CURVES]   = pattern_flowing_curves_row,
+  [WAVY_GRID]        = pattern_wavy_grid_row,
+  [ARC_FANS]         = pattern_arc_fans_row,
+  [CURVED_CROSS]     = pattern_curved_cross_row,
+  [CURVED_DIAMONDS]  = pattern_curved_diamonds_row,
+  [ANGLED_BANDS]     = pattern_angled_bands_row,
+  [FOLDED_GRID]      = pattern_folded_grid_row,
+  [JAGGED_LINES]     = pattern_jagged_lines_row,
+  [TRIANGLE_BANDS]   = pattern_triangle_bands_row,
+  [SKEWED_CROSS]     = pattern_skewed_cross_row,
+  [DOT_GRID]         = pattern_dot_grid_row,
+  [OFFSET_DOTS]      = pattern_offset_dots_row,
+  [DIAMOND_DOTS]     = pattern_diamond_dots_row,
+  [CLUSTERED_DOTS]   = pattern_clustered_dots_row,
+};
+
 static gboolean
 process (GeglOperation        *operation,
          GeglOperationContext *context,
@@ -129,11 +1037,37 @@ process (GeglOperation        *operation,
   gdouble fg_color[4], bg_color[4];
   gdouble tile_size = o->tile_size;
   GeglRectangle rect = *result;
+  PatternRowFunc pattern_row = pattern_rows[o->pattern];
+  PatternRow row;
+  gfloat background[4];
+  gfloat *coverage;
+  gfloat *pixels;
   gint x, y;
 
   // Get color values
   gegl_color_get_rgba (o->foreground_color, &fg_color[0], &fg_color[1], &fg_color[2], &fg_color[3]);
   gegl_color_get_rgba (o->background_color, &bg_color[0], &bg_color[1], &bg_color[2], &bg_color[3]);
+  gfloat fg_rgb[3] = { fg_color[0], fg_color[1], fg_color[2] };
+
+  if (o->transparent_background)
+  {
+    background[0] = 0.0;
+    background[1] = 0.0;
+    background[2] = 0.0;
+    background[3] = 0.0;
+  }
+  else
+  {
+    background[0] = bg_color[0];
+    background[1] = bg_color[1];
+    background[2] = bg_color[2];
+    background[3] = 1.0;
+  }
+
+  row.tile_size = tile_size;
+  row.line_width_scale = o->line_width;
+  row.antialias = o->antialias;
+  row.width = rect.width;
 
   // Convert rotation and skew to radians
   gdouble rotation_rad = o->rotation * G_PI / 180.0;
@@ -144,644 +1078,50 @@ process (GeglOperation        *operation,
   gdouble tan_skew_x = tan(skew_x_rad);
   gdouble tan_skew_y = tan(skew_y_rad);
 
+  // Sheared and rotated coordinates move by a fixed step along a row
+  row.step_x = cos_rot + tan_skew_y * sin_rot;
+  row.step_y = sin_rot - tan_skew_y * cos_rot;
+
+  coverage = g_new (gfloat, rect.width);
+  pixels = g_new (gfloat, rect.width * 4);
+
   for (y = rect.y; y < rect.y + rect.height; y++)
   {
-    for (x = rect.x; x < rect.x + rect.width; x++)
+    gdouble px = (gdouble)rect.x;
+    gdouble py = (gdouble)y;
+
+    // Apply inverse skew transformation (shear)
+    gdouble px_sheared = px - tan_skew_x * py;
+    gdouble py_sheared = py - tan_skew_y * px;
+
+    // Apply rotation to the sheared coordinates around (0, 0)
+    gdouble px_rot = px_sheared * cos_rot - py_sheared * sin_rot;
+    gdouble py_rot = px_sheared * sin_rot + py_sheared * cos_rot;
+
+    // Map the row's first pixel to tile space
+    gdouble tx = fmod(px_rot, tile_size);
+    gdouble ty = fmod(py_rot, tile_size);
+    if (tx < 0) tx += tile_size;
+    if (ty < 0) ty += tile_size;
+
+    row.tx = tx;
+    row.ty = ty;
+    pattern_row (&row, coverage);
+
+    for (x = 0; x < rect.width; x++)
     {
-      gdouble px = (gdouble)x;
-      gdouble py = (gdouble)y;
-
-      // Apply inverse skew transformation (shear)
-      gdouble px_sheared = px - tan_skew_x * py;
-      gdouble py_sheared = py - tan_skew_y * px;
-
-      // Apply rotation to the sheared coordinates around (0, 0)
-      gdouble px_rot = px_sheared * cos_rot - py_sheared * sin_rot;
-      gdouble py_rot = px_sheared * sin_rot + py_sheared * cos_rot;
-
-      // Map rotated and sheared coordinates to tile space
-      gdouble tx = fmod(px_rot, tile_size);
-      gdouble ty = fmod(py_rot, tile_size);
-      if (tx < 0) tx += tile_size;
-      if (ty < 0) ty += tile_size;
-
-      gfloat out[4];
-      gboolean in_shape = FALSE;
-
-      switch (o->pattern)
-      {
-        case MICRO_GRID:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble wave = sin((cx + cy) / cell_size * 2.0 * G_PI) * (cell_size / 10.0);
-          if (fmod(cx + wave, cell_size / 3.0) < line_width ||
-              fmod(cy + wave, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CURVED_LATTICE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - (cell_size / 2.0 + wave_x)) < line_width ||
-              fabs(cy - (cell_size / 2.0 + wave_y)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case MINI_WAVES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 3.0 * G_PI) * (cell_size / 6.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + wave)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ARC_WEAVE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble arc = sin(angle * 3.0) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 3.0 - line_width && dist < cell_size / 3.0 + line_width &&
-              fabs(arc) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TRIANGLE_TILES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy) < line_width || fabs(cx + cy - cell_size) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WOVEN_STRIPS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave1 = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble wave2 = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          gdouble over_under = sin((tx / tile_size) * 2.0 * G_PI) * sin((ty / tile_size) * 2.0 * G_PI);
-          if (fabs(cx - (cell_size / 2.0 + wave1)) < line_width && over_under > 0)
-          {
-            in_shape = TRUE;
-          }
-          if (fabs(cy - (cell_size / 2.0 + wave2)) < line_width && over_under <= 0)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case OFFSET_SQUARES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (cx > cell_size / 4.0 - line_width && cx < cell_size / 4.0 + line_width &&
-                   cy > cell_size / 4.0 - line_width && cy < cell_size / 4.0 + line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case GRID_DIAMONDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width &&
-              fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width)
-          {
-            in_shape = TRUE;
-          }
-          else if (fabs(cx - cell_size / 2.0) < line_width ||
-                   fabs(cy - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVE_TRIANGLES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy + wave) < line_width || fabs(cx + cy - cell_size + wave) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SHIFTED_GRID:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble shift = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(cx + shift, cell_size / 3.0) < line_width ||
-              fmod(cy, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ZIGZAG_TILES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble zigzag_x = fabs(fmod(cx, cell_size / 2.0) - cell_size / 4.0);
-          gdouble zigzag_y = fabs(fmod(cy, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - zigzag_y) < line_width || fabs(cy - zigzag_x) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DOUBLE_WAVE_GRID:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave1 = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble wave2 = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(cx + wave1 + wave2, cell_size / 3.0) < line_width ||
-              fmod(cy + wave1 + wave2, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CIRCLE_ARCS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble arc = sin(angle * 4.0) * (cell_size / 12.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 4.0 - line_width && dist < cell_size / 4.0 + line_width &&
-              fabs(arc) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DOUBLE_TRIANGLES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy) < line_width || fabs(cx + cy - cell_size) < line_width ||
-              fabs(cx - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DIAMOND_CROSS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width &&
-              fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width ||
-              fabs(cx - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case NET:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy + wave) < line_width || fabs(cx + cy - cell_size + wave) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CROSSED_SQUARES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx < line_width || cx > cell_size - line_width ||
-              cy < line_width || cy > cell_size - line_width ||
-              fabs(cx - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TILTED_ZIGZAG:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble diag = cx + cy;
-          gdouble zigzag = fabs(fmod(diag, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy - zigzag) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DIAMOND_LAYERS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx + cy) / cell_size * G_PI) * (cell_size / 12.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if ((fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width + wave &&
-               fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width + wave) ||
-              (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 3.0 + line_width + wave &&
-               fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 3.0 - line_width + wave) ||
-              fabs(cx - cell_size / 2.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case LAYERED_SQUARES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx + cy) / cell_size * 2.0 * G_PI) * (cell_size / 12.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (cx + wave < line_width || cx + wave > cell_size - line_width ||
-              cy + wave < line_width || cy + wave > cell_size - line_width ||
-              (cx + wave > cell_size / 4.0 - line_width && cx + wave < cell_size / 4.0 + line_width &&
-               cy + wave > cell_size / 4.0 - line_width && cy + wave < cell_size / 4.0 + line_width) ||
-              (cx + wave > cell_size / 3.0 - line_width && cx + wave < cell_size / 3.0 + line_width &&
-               cy + wave > cell_size / 3.0 - line_width && cy + wave < cell_size / 3.0 + line_width))
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TRIANGLE_WEAVE:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble diag1 = fabs(cx - cy + wave);
-          gdouble diag2 = fabs(cx + cy - cell_size + wave);
-          gdouble cross = fabs(cx - cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (diag1 < line_width || diag2 < line_width || cross < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case FLOWING_CURVES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx / cell_size) * 2.0 * G_PI + (cy / cell_size) * G_PI) * (cell_size / 8.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + wave)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case WAVY_GRID:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(cx + wave_x, cell_size / 3.0) < line_width ||
-              fmod(cy + wave_y, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ARC_FANS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble angle = atan2(dy, dx);
-          gdouble arc = sin(angle * 3.0 + (dist / cell_size) * G_PI) * (cell_size / 12.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (dist > cell_size / 3.0 - line_width && dist < cell_size / 3.0 + line_width &&
-              fabs(arc) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CURVED_CROSS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave_x = sin((cy / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble wave_y = sin((cx / cell_size) * 2.0 * G_PI) * (cell_size / 10.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - (cell_size / 2.0 + wave_x)) < line_width ||
-              fabs(cy - (cell_size / 2.0 + wave_y)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CURVED_DIAMONDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble wave = sin((cx + cy) / cell_size * G_PI) * (cell_size / 12.0);
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) < cell_size / 4.0 + line_width + wave &&
-              fabs(cx - cell_size / 2.0) + fabs(cy - cell_size / 2.0) > cell_size / 4.0 - line_width + wave)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case ANGLED_BANDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble shift = fmod(cx + cy, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(cx + cy + shift, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case FOLDED_GRID:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble fold_x = fmod(cx, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble fold_y = fmod(cy, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fmod(cx + fold_x, cell_size / 3.0) < line_width ||
-              fmod(cy + fold_y, cell_size / 3.0) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case JAGGED_LINES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble jag = fmod(cx, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cy - (cell_size / 2.0 + jag)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case TRIANGLE_BANDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble shift = fmod(cx, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - cy + shift) < line_width || fabs(cx + cy - cell_size + shift) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SKEWED_CROSS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble shift = fmod(cx + cy, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble base_line_width = cell_size * 0.05;
-          gdouble line_width = base_line_width * o->line_width;
-          if (fabs(cx - (cell_size / 2.0 + shift)) < line_width ||
-              fabs(cy - (cell_size / 2.0 + shift)) < line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DOT_GRID:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_dot_size = cell_size * 0.1;
-          gdouble dot_size = base_dot_size * o->line_width;
-          if (dist < dot_size)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case OFFSET_DOTS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble shift = fmod(cx + cy, cell_size / 2.0) < cell_size / 4.0 ? cell_size / 8.0 : -cell_size / 8.0;
-          gdouble center_x = cell_size / 2.0 + shift;
-          gdouble center_y = cell_size / 2.0 + shift;
-          gdouble dx = cx - center_x;
-          gdouble dy = cy - center_y;
-          gdouble dist = sqrt(dx * dx + dy * dy);
-          gdouble base_dot_size = cell_size * 0.1;
-          gdouble dot_size = base_dot_size * o->line_width;
-          if (dist < dot_size)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case DIAMOND_DOTS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble center_x = cell_size / 2.0;
-          gdouble center_y = cell_size / 2.0;
-          gdouble dx = fabs(cx - center_x);
-          gdouble dy = fabs(cy - center_y);
-          gdouble dist = dx + dy; // Manhattan distance for diamond shape
-          gdouble base_dot_size = cell_size * 0.1;
-          gdouble dot_size = base_dot_size * o->line_width;
-          if (dist < dot_size)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case CLUSTERED_DOTS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble cx = fmod(tx, cell_size);
-          gdouble cy = fmod(ty, cell_size);
-          gdouble base_dot_size = cell_size * 0.08;
-          gdouble dot_size = base_dot_size * o->line_width;
-          gdouble centers[4][2] = {
-            {cell_size / 4.0, cell_size / 4.0},
-            {3.0 * cell_size / 4.0, cell_size / 4.0},
-            {cell_size / 4.0, 3.0 * cell_size / 4.0},
-            {3.0 * cell_size / 4.0, 3.0 * cell_size / 4.0}
-          };
-          for (int i = 0; i < 4; i++)
-          {
-            gdouble dx = cx - centers[i][0];
-            gdouble dy = cy - centers[i][1];
-            gdouble dist = sqrt(dx * dx + dy * dy);
-            if (dist < dot_size)
-            {
-              in_shape = TRUE;
-              break;
-            }
-          }
-          break;
-        }
-      }
-
-      if (in_shape)
-      {
-        out[0] = fg_color[0];
-        out[1] = fg_color[1];
-        out[2] = fg_color[2];
-        out[3] = 1.0;
-      }
-      else
-      {
-        if (o->transparent_background)
-        {
-          out[0] = 0.0;
-          out[1] = 0.0;
-          out[2] = 0.0;
-          out[3] = 0.0;
-        }
-        else
-        {
-          out[0] = bg_color[0];
-          out[1] = bg_color[1];
-          out[2] = bg_color[2];
-          out[3] = 1.0;
-        }
-      }
-
-      gegl_buffer_set (output, GEGL_RECTANGLE (x, y, 1, 1), 0, babl_format ("RGBA float"), out, GEGL_AUTO_ROWSTRIDE);
+      gfloat *out = pixels + x * 4;
+
+      memcpy (out, background, sizeof (background));
+      lb_coverage_over (out, fg_rgb, coverage[x]);
     }
+
+    gegl_buffer_set (output, GEGL_RECTANGLE (rect.x, y, rect.width, 1), 0, babl_format ("RGBA float"), pixels, GEGL_AUTO_ROWSTRIDE);
   }
 
+  g_free (coverage);
+  g_free (pixels);
+
   return TRUE;
 }
 
@@ -791,6 +1131,7 @@ gegl_op_class_init (GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   operation_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
@@ -25,6 +25,7 @@
 enum_start (gradientmaplist)
 enum_value   (SIMPLE_2, "simple", N_("Simple (show 2 colors)"))
 enum_value   (ADVANCE_5, "advance", N_("Advance (show all 5 colors)"))
+enum_value   (CUSTOM_N, "custom", N_("Custom (any number of stops)"))
   enum_end (gradientmaplisting)
 
 property_enum(show, _("Settings"),
@@ -63,6 +64,9 @@ property_double(stop5, _("Stop 5"), 1.0)
   ui_range      (-2.0, 3.5)
   ui_steps      (0.5, 1.0)
 ui_meta ("visible", "show {advance}")
+property_string(gradient, _("Gradient"), "0.0 black; 1.0 white")
+  description (_("Gradient stops as 'position color' pairs separated by semicolons, replacing the colors and stops above"))
+ui_meta ("visible", "show {custom}")
 property_boolean(srgb, _("sRGB"), FALSE)
 #else
 
@@ -73,135 +77,180 @@ property_boolean(srgb, _("sRGB"), FALSE)
 #include "gegl-op.h"
 
 
-// TODO: create a custom GeglGradient type
-// - take this as input
-// - should have a number of GeglColor stops
-// - should be deserializable from a (JSON) array of GeglColor values
-
 #define GRADIENT_STOPS 5
-static const gint gradient_length = 2048;
-static const gint gradient_channels = 4; // RGBA
 
-typedef struct RgbaColor_ {
-    gdouble r;
-    gdouble g;
-    gdouble b;
-    gdouble a;
-} RgbaColor;
+// Intervals of the lookup table; 257 RGBA floats stay within 4 KiB
+#define GRADIENT_LUT_SIZE 256
 
-static void
-rgba_from_gegl_color(RgbaColor *c, GeglColor *color, const Babl *format)
-{
-    gfloat out[4];
-    gegl_color_get_pixel(color, format, out);
-    c->r = out[0];
-    c->g = out[1];
-    c->b = out[2];
-    c->a = out[3];
-}
+typedef struct GradientStop_ {
+    gfloat position;
+    gfloat color[4];
+} GradientStop;
 
 typedef struct GradientMapProperties_ {
-    gdouble *gradient;
+    gint          n_stops;
+    GradientStop *stops;     // Stops the table was built from
+    gfloat        lut[(GRADIENT_LUT_SIZE + 1) * 4];
 } GradientMapProperties;
 
-static inline void
-pixel_interpolate_gradient(gdouble *samples, const gint offset,
-                    const RgbaColor *c1, const RgbaColor *c2, const float weight)
+static gint
+gradient_stop_compare(gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const GradientStop *s1 = a;
+    const GradientStop *s2 = b;
+    return (s1->position > s2->position) - (s1->position < s2->position);
+}
+
+// Parse "position color; position color; ..." into stops, skipping
+// entries without a position
+static gint
+gradient_stops_from_string(const gchar *string, const Babl *format,
+                           GradientStop **stops)
 {
-    samples[offset+0] = c1->r + (weight * (c2->r - c1->r));
-    samples[offset+1] = c1->g + (weight * (c2->g - c1->g));
-    samples[offset+2] = c1->b + (weight * (c2->b - c1->b));
-    samples[offset+3] = c1->a + (weight * (c2->a - c1->a));
+    gchar **entries = g_strsplit(string ? string : "", ";", -1);
+    gint n_stops = 0;
+
+    *stops = g_new(GradientStop, g_strv_length(entries) + 1);
+
+    for (gint i = 0; entries[i]; i++) {
+        gchar *entry = g_strstrip(entries[i]);
+        gchar *end;
+        gdouble position = g_ascii_strtod(entry, &end);
+
+        if (end == entry || !*g_strstrip(end))
+            continue;
+
+        GeglColor *color = gegl_color_new(end);
+        (*stops)[n_stops].position = position;
+        gegl_color_get_pixel(color, format, (*stops)[n_stops].color);
+        g_object_unref(color);
+        n_stops++;
+    }
+
+    g_strfreev(entries);
+    return n_stops;
 }
 
-static inline float
-mapf(float x, float in_min, float in_max, float out_min, float out_max)
+static gint
+gradient_stops_from_properties(GeglProperties *o, const Babl *format,
+                               GradientStop **stops)
 {
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+    GeglColor *colors[GRADIENT_STOPS] = {
+        o->color1,
+        o->color2,
+        o->color3,
+        o->color4,
+        o->color5
+    };
+    gdouble positions[GRADIENT_STOPS] = {
+        o->stop1,
+        o->stop2,
+        o->stop3,
+        o->stop4,
+        o->stop5
+    };
+
+    *stops = g_new(GradientStop, GRADIENT_STOPS);
+    for (gint i = 0; i < GRADIENT_STOPS; i++) {
+        (*stops)[i].position = positions[i];
+        gegl_color_get_pixel(colors[i], format, (*stops)[i].color);
+    }
+    return GRADIENT_STOPS;
 }
 
+// Color of the piecewise linear gradient through the sorted stops,
+// holding the end colors beyond the first and last stop
+static void
+gradient_color_at(const GradientStop *stops, gint n_stops, gfloat pos,
+                  gfloat *out)
+{
+    gint to = 0;
+
+    while (to < n_stops && stops[to].position < pos)
+        to++;
+
+    if (to == 0 || to == n_stops) {
+        const gfloat *c = stops[to == 0 ? 0 : n_stops - 1].color;
+        memcpy(out, c, 4 * sizeof(gfloat));
+        return;
+    }
+
+    {
+    const GradientStop *from_stop = &stops[to - 1];
+    const GradientStop *to_stop = &stops[to];
+    const gfloat weight = (pos - from_stop->position) /
+                          (to_stop->position - from_stop->position);
+
+    for (gint c = 0; c < 4; c++)
+        out[c] = from_stop->color[c] + weight * (to_stop->color[c] - from_stop->color[c]);
+    }
+}
 
-static gdouble *
-create_linear_gradient(GeglColor **colors, gdouble *stops, const gint no_stops,
-                       const gint gradient_len, gint channels, const Babl *format)
+static void
+gradient_lut_build(gfloat *lut, const GradientStop *stops, gint n_stops)
 {
-    gdouble *samples = (gdouble *)g_new(gdouble, gradient_len*channels);
-
-    // XXX: assumes that
-    // - stops are in ascending order
-    // - first stop is at 0.0
-    RgbaColor from, to;
-    gint from_stop = 0;
-    gint to_stop = 1;
-    rgba_from_gegl_color(&from, colors[from_stop], format);
-    rgba_from_gegl_color(&to, colors[to_stop], format);
-
-    for (int px=0; px < gradient_len; px++) {
-        const float pos = ((float)px)/gradient_len;
-        float to_pos = (to_stop >= no_stops) ? 1.0 : stops[to_stop];
-        if (pos > to_pos) {
-            from_stop = (from_stop+1 < no_stops) ? from_stop+1 : from_stop;
-            to_stop = (to_stop+1 < no_stops) ? to_stop+1 : to_stop;
-            to_pos = stops[to_stop];
-            rgba_from_gegl_color(&from, colors[from_stop], format);
-            rgba_from_gegl_color(&to, colors[to_stop], format);
-        }
-        {
-        const float from_pos = (from_stop < 0) ? 0.0 : stops[from_stop];
-        const float weight = ((to_stop-from_stop) == 0) ? 1.0 : mapf(pos, from_pos, to_pos, 0.0, 1.0);
-        const size_t offset = px*channels;
-        pixel_interpolate_gradient(samples, offset, &from, &to, weight);
-        }
+    static const gfloat transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+    for (gint i = 0; i <= GRADIENT_LUT_SIZE; i++) {
+        if (n_stops > 0)
+            gradient_color_at(stops, n_stops, (gfloat) i / GRADIENT_LUT_SIZE, &lut[i * 4]);
+        else
+            memcpy(&lut[i * 4], transparent, sizeof(transparent));
     }
-    return samples;
 }
 
-static void inline
-process_pixel_gradient_map(gfloat *in, gfloat *out, gdouble *gradient,
-                           gint gradient_len, gint gradient_channels)
+static inline void
+process_pixel_gradient_map(const gfloat *in, gfloat *out, const gfloat *lut)
 {
-    const gint index = CLAMP (in[0] * (gradient_len-1), 0, gradient_len-1);
-    gdouble *mapped = &(gradient[index * gradient_channels]);
-    out[0] = mapped[0];
-    out[1] = mapped[1];
-    out[2] = mapped[2];
-    out[3] = mapped[3] * in[1];
+    // Written so NaN maps to 0
+    const gfloat pos = (in[0] > 0.0f ? MIN(in[0], 1.0f) : 0.0f) * GRADIENT_LUT_SIZE;
+    const gint index = MIN((gint) pos, GRADIENT_LUT_SIZE - 1);
+    const gfloat weight = pos - index;
+    const gfloat *a = &lut[index * 4];
+    const gfloat *b = a + 4;
+
+    out[0] = a[0] + weight * (b[0] - a[0]);
+    out[1] = a[1] + weight * (b[1] - a[1]);
+    out[2] = a[2] + weight * (b[2] - a[2]);
+    out[3] = (a[3] + weight * (b[3] - a[3])) * in[1];
 }
 
 static void prepare (GeglOperation *operation)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GradientMapProperties *props = (GradientMapProperties*)o->user_data;
-  GeglColor *colors[GRADIENT_STOPS] = {
-      o->color1,
-      o->color2,
-      o->color3,
-      o->color4,
-      o->color5
-  };
-  gdouble stops[GRADIENT_STOPS] = {
-      o->stop1,
-      o->stop2,
-      o->stop3,
-      o->stop4,
-      o->stop5
-  };
   const Babl *input_format = (o->srgb) ? babl_format ("Y'A float") : babl_format ("YA float");
   const Babl *output_format = (o->srgb) ? babl_format ("R'G'B'A float") : babl_format ("RGBA float");
+  GradientStop *stops;
+  gint n_stops;
 
   gegl_operation_set_format (operation, "input", input_format);
   gegl_operation_set_format (operation, "output", output_format);
 
+  if (o->show == CUSTOM_N)
+    n_stops = gradient_stops_from_string (o->gradient, output_format, &stops);
+  else
+    n_stops = gradient_stops_from_properties (o, output_format, &stops);
+
+  g_qsort_with_data (stops, n_stops, sizeof (GradientStop), gradient_stop_compare, NULL);
+
   if (!props)
     {
-      props = g_new(GradientMapProperties, 1);
-      props->gradient = NULL;
+      props = g_new0(GradientMapProperties, 1);
       o->user_data = props;
     }
+  else if (props->stops && props->n_stops == n_stops &&
+           memcmp (props->stops, stops, n_stops * sizeof (GradientStop)) == 0)
+    {
+      /* Same colors and stops, the table is still valid */
+      g_free (stops);
+      return;
+    }
 
-  g_free(props->gradient);
-  props->gradient = create_linear_gradient(colors, stops, GRADIENT_STOPS,
-                                gradient_length, gradient_channels, output_format);
+  g_free(props->stops);
+  props->stops = stops;
+  props->n_stops = n_stops;
+  gradient_lut_build (props->lut, stops, n_stops);
 }
 
 static void finalize (GObject *object)
@@ -210,7 +259,8 @@ static void finalize (GObject *object)
     GeglProperties *o = GEGL_PROPERTIES (op);
     if (o->user_data) {
       GradientMapProperties *props = (GradientMapProperties *)o->user_data;
-      g_free(props->gradient);
+      g_free(props->stops);
+      g_free(props);
       o->user_data = NULL;
     }
     G_OBJECT_CLASS(gegl_op_parent_class)->finalize (object);
@@ -232,7 +282,7 @@ process (GeglOperation       *op,
 
   for (int i=0; i<n_pixels; i++)
     {
-      process_pixel_gradient_map(in_pixel, out_pixel, props->gradient, gradient_length, gradient_channels);
+      process_pixel_gradient_map(in_pixel, out_pixel, props->lut);
       in_pixel  += 2;
       out_pixel += 4;
     }
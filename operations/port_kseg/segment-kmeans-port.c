@@ -37,6 +37,12 @@ property_int (max_iterations, _("Max. Iterations"), 5)
 
 property_seed (seed, _("Random seed"), rand)
 
+property_boolean (full_resolution, _("Full resolution"), FALSE)
+ description (_("Fit the clusters to random mini-batches of the full resolution image instead of a downsampled copy"))
+
+property_pointer (palette, _("Palette location"),
+                  _("Write the cluster centers to the GeglBuffer pointed to, as a row of n_clusters CIE Lab float pixels"))
+
 #else
 
 #define GEGL_OP_FILTER
@@ -47,15 +53,98 @@ property_seed (seed, _("Random seed"), rand)
 
 #define MAX_PIXELS 100000
 
+/* Side of the square blocks mini-batches are drawn in */
+#define BATCH_BLOCK_SIZE 16
+
+#define MIN_SAMPLES_PER_THREAD 4096
+
 #define POW2(x) ((x)*(x))
 
 typedef struct
 {
-  gfloat center[3];
-  gfloat sum[3];
-  glong  count;
+  gfloat  center[3];
+  gdouble sum[3];
+  glong   count;
+  glong   total_count;   /* samples seen over all mini-batches */
 } Cluster;
 
+/* Pixels the clusters are fitted to, with the assignment of every pixel
+ * and Hamerly's bounds on its distance to the assigned center (upper) and
+ * to every other center (lower) */
+typedef struct
+{
+  gfloat *pixels;
+  glong   n_samples;
+  gint   *assignment;
+  gfloat *upper;
+  gfloat *lower;
+} Samples;
+
+typedef struct
+{
+  Samples       *samples;
+  const Cluster *clusters;
+  gint           n_clusters;
+  const gfloat  *half_separation;
+  const gfloat  *moved;         /* distance each center moved last update */
+  gfloat         max_moved;
+  gboolean       use_bounds;
+  gdouble       *part_sums;     /* n_parts x n_clusters x 3 */
+  glong         *part_counts;   /* n_parts x n_clusters */
+} AssignData;
+
+/* Cells per axis of the Lab lookup grid of a palette */
+#define PALETTE_GRID_SIZE 16
+
+/* Every cell list is padded to a multiple of this many candidates so the
+ * distance pass runs over fixed width blocks the compiler vectorises */
+#define PALETTE_GRID_LANES 8
+
+/* Position of the padding candidates, far outside the Lab range */
+#define PALETTE_GRID_FAR 1.0e10f
+
+/* Nearest center lookup for a fitted palette. Every cell of a grid over
+ * the usual Lab range lists the centers that can be nearest to some color
+ * in it, stored as separate L, a and b arrays padded to whole blocks of
+ * PALETTE_GRID_LANES; colors outside the range fall back to scanning
+ * every center. */
+typedef struct
+{
+  const Cluster *clusters;
+  gint           n_clusters;
+  gfloat        *half_separation;
+  gfloat         grid_min[3];
+  gfloat         inv_cell_size[3];
+  guint         *cell_start;
+  gfloat        *candidate_l;
+  gfloat        *candidate_a;
+  gfloat        *candidate_b;
+  gint          *candidate_index;
+} PaletteGrid;
+
+typedef struct
+{
+  GeglBuffer        *input;
+  GeglBuffer        *output;
+  const PaletteGrid *grid;
+} OutputData;
+
+/* Clusters of the last fit, reused while the input buffer is unwritten and
+ * the properties they depend on are unchanged */
+typedef struct
+{
+  GeglBuffer    *input;            /* weak pointer */
+  gulong         changed_handler;
+  gint           changed;          /* set atomically by the handler */
+  GeglRectangle  extent;
+  gint           n_clusters;
+  gint           max_iterations;
+  gint           seed;
+  gboolean       full_resolution;
+  Cluster       *clusters;
+  PaletteGrid   *grid;
+} KmeansCache;
+
 static void
 downsample_buffer (GeglBuffer  *input,
                    GeglBuffer **downsampled)
@@ -101,8 +190,73 @@ downsample_buffer (GeglBuffer  *input,
     }
 }
 
+static void
+samples_init (Samples *samples,
+              glong    n_samples)
+{
+  samples->pixels     = g_new (gfloat, 3 * MAX (n_samples, 1));
+  samples->n_samples  = n_samples;
+  samples->assignment = g_new0 (gint, MAX (n_samples, 1));
+  samples->upper      = g_new (gfloat, MAX (n_samples, 1));
+  samples->lower      = g_new (gfloat, MAX (n_samples, 1));
+}
+
+static void
+samples_clear (Samples *samples)
+{
+  g_free (samples->pixels);
+  g_free (samples->assignment);
+  g_free (samples->upper);
+  g_free (samples->lower);
+}
+
+/* Read every pixel of the (downsampled) source */
+static void
+read_samples (GeglBuffer *source,
+              Samples    *samples)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (source);
+
+  samples_init (samples, (glong) extent->width * extent->height);
+
+  gegl_buffer_get (source, extent, 1.0, babl_format ("CIE Lab float"),
+                   samples->pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+}
+
+/* Refill samples, allocated for MAX_PIXELS, with a mini-batch of random
+ * blocks of the full resolution input; blocks keep the reads tile sized */
+static void
+read_batch (GeglBuffer *input,
+            Samples    *samples,
+            GRand      *prg)
+{
+  const GeglRectangle *extent = gegl_buffer_get_extent (input);
+  GeglRectangle block;
+  gint  n_blocks;
+  glong offset = 0;
+  gint  i;
+
+  block.width  = MIN (BATCH_BLOCK_SIZE, extent->width);
+  block.height = MIN (BATCH_BLOCK_SIZE, extent->height);
+  n_blocks = MAX_PIXELS / (block.width * block.height);
+
+  for (i = 0; i < n_blocks; i++)
+    {
+      block.x = extent->x + g_rand_int_range (prg, 0, extent->width - block.width + 1);
+      block.y = extent->y + g_rand_int_range (prg, 0, extent->height - block.height + 1);
+
+      gegl_buffer_get (input, &block, 1.0, babl_format ("CIE Lab float"),
+                       samples->pixels + 3 * offset, GEGL_AUTO_ROWSTRIDE,
+                       GEGL_ABYSS_NONE);
+
+      offset += block.width * block.height;
+    }
+
+  samples->n_samples = offset;
+}
+
 static inline gfloat
-get_distance (gfloat *c1, gfloat *c2)
+get_distance (const gfloat *c1, const gfloat *c2)
 {
   return POW2(c2[0] - c1[0]) +
          POW2(c2[1] - c1[1]) +
@@ -110,9 +264,9 @@ get_distance (gfloat *c1, gfloat *c2)
 }
 
 static inline gint
-find_nearest_cluster (gfloat  *pixel,
-                      Cluster *clusters,
-                      gint     n_clusters)
+find_nearest_cluster (const gfloat  *pixel,
+                      const Cluster *clusters,
+                      gint           n_clusters)
 {
   gfloat min_distance = G_MAXFLOAT;
   gint   min_cluster  = 0;
@@ -132,75 +286,236 @@ find_nearest_cluster (gfloat  *pixel,
   return min_cluster;
 }
 
-static Cluster *
-init_clusters (GeglBuffer     *input,
-               GeglProperties *o)
+/* Like find_nearest_cluster(), also returning the squared distances to the
+ * nearest and second nearest centers */
+static inline gint
+find_nearest_clusters (const gfloat  *pixel,
+                       const Cluster *clusters,
+                       gint           n_clusters,
+                       gfloat        *nearest_distance,
+                       gfloat        *second_distance)
 {
-  Cluster *clusters = g_new0 (Cluster, o->n_clusters);
-  GRand   *prg      = g_rand_new_with_seed (o->seed);
-
-  gint width  = gegl_buffer_get_width (input);
-  gint height = gegl_buffer_get_height (input);
-  gint i;
+  gfloat min_distance = G_MAXFLOAT;
+  gfloat second_min   = G_MAXFLOAT;
+  gint   min_cluster  = 0;
+  gint   i;
 
-  for (i = 0; i < o->n_clusters; i++)
+  for (i = 0; i < n_clusters; i++)
     {
-      gfloat color[3];
-      GeglRectangle one_pixel = {0, 0, 1, 1};
-      Cluster *c = clusters + i;
+      gfloat distance = get_distance (clusters[i].center, pixel);
 
-      one_pixel.x = g_rand_int_range (prg, 0, width);
-      one_pixel.y = g_rand_int_range (prg, 0, height);
+      if (distance < min_distance)
+        {
+          second_min = min_distance;
+          min_distance = distance;
+          min_cluster  = i;
+        }
+      else if (distance < second_min)
+        {
+          second_min = distance;
+        }
+    }
 
-      gegl_buffer_get (input, &one_pixel, 1.0, babl_format ("CIE Lab float"),
-                       color, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  *nearest_distance = min_distance;
+  *second_distance  = second_min;
 
-      c->center[0] = color[0];
-      c->center[1] = color[1];
-      c->center[2] = color[2];
-      c->sum[0] = 0.0f;
-      c->sum[1] = 0.0f;
-      c->sum[2] = 0.0f;
-      c->count = 0;
-    }
+  return min_cluster;
+}
 
-  g_rand_free (prg);
+/* Half the distance from every center to its closest other center; a pixel
+ * within that distance of a center is nearest to it */
+static void
+compute_half_separation (const Cluster *clusters,
+                         gint           n_clusters,
+                         gfloat        *half_separation)
+{
+  gint i, j;
 
-  return clusters;
+  for (i = 0; i < n_clusters; i++)
+    {
+      gfloat min_distance = G_MAXFLOAT;
+
+      for (j = 0; j < n_clusters; j++)
+        if (j != i)
+          min_distance = MIN (min_distance,
+                              get_distance (clusters[i].center, clusters[j].center));
+
+      half_separation[i] = 0.5f * sqrtf (min_distance);
+    }
 }
 
+/* k-means++ seeding: every new center is a sample picked with probability
+ * proportional to its squared distance from the centers chosen so far */
 static void
-assign_pixels_to_clusters (GeglBuffer *input,
-                           Cluster    *clusters,
-                           gint        n_clusters)
+init_clusters (Cluster       *clusters,
+               gint           n_clusters,
+               const Samples *samples,
+               GRand         *prg)
 {
-  GeglBufferIterator *iter;
+  gfloat *min_distance;
+  glong   n = samples->n_samples;
+  glong   j;
+  gint    i;
 
-  iter = gegl_buffer_iterator_new (input, NULL, 0, babl_format ("CIE Lab float"),
-                                   GEGL_ACCESS_READ, GEGL_ABYSS_NONE, 1);
+  memset (clusters, 0, n_clusters * sizeof (Cluster));
 
-  while (gegl_buffer_iterator_next (iter))
+  if (n == 0)
+    return;
+
+  min_distance = g_new (gfloat, n);
+
+  for (i = 0; i < n_clusters; i++)
     {
-      gfloat *pixel = iter->items[0].data;
-      glong   n_pixels = iter->length;
+      glong   pick = 0;
+      gdouble total = 0.0;
 
-      while (n_pixels--)
+      for (j = 0; i > 0 && j < n; j++)
+        total += min_distance[j];
+
+      if (total > 0.0)
+        {
+          gdouble target = g_rand_double_range (prg, 0.0, total);
+
+          for (pick = 0; pick < n - 1; pick++)
+            {
+              target -= min_distance[pick];
+              if (target < 0.0)
+                break;
+            }
+        }
+      else
+        {
+          pick = g_rand_int_range (prg, 0, n);
+        }
+
+      clusters[i].center[0] = samples->pixels[3 * pick + 0];
+      clusters[i].center[1] = samples->pixels[3 * pick + 1];
+      clusters[i].center[2] = samples->pixels[3 * pick + 2];
+
+      for (j = 0; j < n; j++)
+        {
+          gfloat distance = get_distance (clusters[i].center, samples->pixels + 3 * j);
+
+          min_distance[j] = i > 0 ? MIN (min_distance[j], distance) : distance;
+        }
+    }
+
+  g_free (min_distance);
+}
+
+static void
+assign_samples_part (gint     part,
+                     gint     n_parts,
+                     gpointer user_data)
+{
+  AssignData    *data       = user_data;
+  Samples       *samples    = data->samples;
+  const Cluster *clusters   = data->clusters;
+  gint           n_clusters = data->n_clusters;
+  gdouble       *sums       = data->part_sums + (gsize) part * n_clusters * 3;
+  glong         *counts     = data->part_counts + (gsize) part * n_clusters;
+  glong          first      = samples->n_samples * part / n_parts;
+  glong          last       = samples->n_samples * (part + 1) / n_parts;
+  glong          j;
+
+  for (j = first; j < last; j++)
+    {
+      const gfloat *pixel  = samples->pixels + 3 * j;
+      gint          index  = samples->assignment[j];
+      gboolean      search = TRUE;
+
+      /* Hamerly: widen the bounds by how far the centers moved; the
+       * assignment stands while the distance to its center is below both
+       * the bound on every other center and half the distance to the
+       * closest other center */
+      if (data->use_bounds)
         {
-          gint index = find_nearest_cluster (pixel, clusters, n_clusters);
+          gfloat bound;
+
+          samples->upper[j] += data->moved[index];
+          samples->lower[j] -= data->max_moved;
+
+          bound = MAX (data->half_separation[index], samples->lower[j]);
+
+          if (samples->upper[j] > bound)
+            samples->upper[j] = sqrtf (get_distance (clusters[index].center, pixel));
+
+          search = samples->upper[j] > bound;
+        }
 
-          clusters[index].sum[0] += pixel[0];
-          clusters[index].sum[1] += pixel[1];
-          clusters[index].sum[2] += pixel[2];
-          clusters[index].count++;
+      if (search)
+        {
+          gfloat nearest, second;
 
-          pixel += 3;
+          index = find_nearest_clusters (pixel, clusters, n_clusters, &nearest, &second);
+          samples->assignment[j] = index;
+          samples->upper[j]      = sqrtf (nearest);
+          samples->lower[j]      = sqrtf (second);
         }
+
+      sums[index * 3 + 0] += pixel[0];
+      sums[index * 3 + 1] += pixel[1];
+      sums[index * 3 + 2] += pixel[2];
+      counts[index]++;
     }
 }
 
+/* Assign every sample to its nearest cluster in parallel; each part sums
+ * into its own slot and the slots are merged in order afterwards. With
+ * use_bounds the assignments and bounds of the previous pass are reused,
+ * given how far each center moved since. */
+static void
+assign_pixels_to_clusters (Samples      *samples,
+                           Cluster      *clusters,
+                           gint          n_clusters,
+                           const gfloat *moved,
+                           gboolean      use_bounds)
+{
+  AssignData data;
+  gfloat    *half_separation = g_new (gfloat, n_clusters);
+  gint       max_parts;
+  gint       part, i;
+
+  max_parts = CLAMP (samples->n_samples / MIN_SAMPLES_PER_THREAD, 1, G_MAXINT);
+
+  compute_half_separation (clusters, n_clusters, half_separation);
+
+  data.samples         = samples;
+  data.clusters        = clusters;
+  data.n_clusters      = n_clusters;
+  data.half_separation = half_separation;
+  data.moved           = moved;
+  data.max_moved       = 0.0f;
+  data.use_bounds      = use_bounds;
+  data.part_sums       = g_new0 (gdouble, (gsize) max_parts * n_clusters * 3);
+  data.part_counts     = g_new0 (glong, (gsize) max_parts * n_clusters);
+
+  for (i = 0; use_bounds && i < n_clusters; i++)
+    data.max_moved = MAX (data.max_moved, moved[i]);
+
+  gegl_parallel_distribute (max_parts, assign_samples_part, &data);
+
+  for (part = 0; part < max_parts; part++)
+    for (i = 0; i < n_clusters; i++)
+      {
+        gsize k = (gsize) part * n_clusters + i;
+
+        clusters[i].sum[0] += data.part_sums[k * 3 + 0];
+        clusters[i].sum[1] += data.part_sums[k * 3 + 1];
+        clusters[i].sum[2] += data.part_sums[k * 3 + 2];
+        clusters[i].count  += data.part_counts[k];
+      }
+
+  g_free (data.part_sums);
+  g_free (data.part_counts);
+  g_free (half_separation);
+}
+
+/* Move every center to the mean of its samples, storing how far it moved */
 static gboolean
 update_clusters (Cluster  *clusters,
-                 gint      n_clusters)
+                 gint      n_clusters,
+                 gfloat   *moved)
 {
   gboolean has_changed = FALSE;
   gint i;
@@ -209,6 +524,8 @@ update_clusters (Cluster  *clusters,
     {
       gfloat new_center[3];
 
+      moved[i] = 0.0f;
+
       if (!clusters[i].count)
         continue;
 
@@ -221,30 +538,221 @@ update_clusters (Cluster  *clusters,
           new_center[2] != clusters[i].center[2])
         has_changed = TRUE;
 
+      moved[i] = sqrtf (get_distance (clusters[i].center, new_center));
+
       clusters[i].center[0] = new_center[0];
       clusters[i].center[1] = new_center[1];
       clusters[i].center[2] = new_center[2];
-      clusters[i].sum[0] = 0.0f;
-      clusters[i].sum[1] = 0.0f;
-      clusters[i].sum[2] = 0.0f;
+      clusters[i].sum[0] = 0.0;
+      clusters[i].sum[1] = 0.0;
+      clusters[i].sum[2] = 0.0;
       clusters[i].count  = 0;
     }
 
   return has_changed;
 }
 
+/* Mini-batch step: move every center towards the mean of its batch samples
+ * with a rate of batch count over all samples it has seen, so each center
+ * ends up at the running mean of everything assigned to it */
 static void
-set_output (GeglBuffer *input,
-            GeglBuffer *output,
-            Cluster    *clusters,
-            gint        n_clusters)
+update_clusters_batch (Cluster  *clusters,
+                       gint      n_clusters)
 {
+  gint i;
+
+  for (i = 0; i < n_clusters; i++)
+    {
+      Cluster *c = clusters + i;
+      gint     k;
+
+      if (!c->count)
+        continue;
+
+      c->total_count += c->count;
+
+      for (k = 0; k < 3; k++)
+        {
+          gdouble rate = (gdouble) c->count / c->total_count;
+
+          c->center[k] += rate * (c->sum[k] / c->count - c->center[k]);
+          c->sum[k] = 0.0;
+        }
+
+      c->count = 0;
+    }
+}
+
+static PaletteGrid *
+palette_grid_new (const Cluster *clusters,
+                  gint           n_clusters)
+{
+  static const gfloat lab_min[3] = {   0.0f, -128.0f, -128.0f };
+  static const gfloat lab_max[3] = { 100.0f,  128.0f,  128.0f };
+
+  PaletteGrid *grid    = g_new0 (PaletteGrid, 1);
+  gint         n_cells = PALETTE_GRID_SIZE * PALETTE_GRID_SIZE * PALETTE_GRID_SIZE;
+  gfloat       cell_size[3];
+  gfloat       half_diagonal;
+  gint        *cell_candidates = g_new (gint, (gsize) n_cells * (n_clusters + PALETTE_GRID_LANES));
+  guint        n_candidates = 0;
+  gint         cell, i, k;
+
+  grid->clusters        = clusters;
+  grid->n_clusters      = n_clusters;
+  grid->half_separation = g_new (gfloat, n_clusters);
+  grid->cell_start      = g_new (guint, n_cells + 1);
+
+  compute_half_separation (clusters, n_clusters, grid->half_separation);
+
+  for (k = 0; k < 3; k++)
+    {
+      cell_size[k]           = (lab_max[k] - lab_min[k]) / PALETTE_GRID_SIZE;
+      grid->grid_min[k]      = lab_min[k];
+      grid->inv_cell_size[k] = 1.0f / cell_size[k];
+    }
+
+  half_diagonal = 0.5f * sqrtf (POW2 (cell_size[0]) + POW2 (cell_size[1]) + POW2 (cell_size[2]));
+
+  /* A center can only win inside a cell when its distance to the cell
+   * center is within the nearest center's distance plus the cell diagonal */
+  for (cell = 0; cell < n_cells; cell++)
+    {
+      gfloat centre[3];
+      gfloat nearest = G_MAXFLOAT;
+      gfloat reach;
+
+      centre[0] = lab_min[0] + (cell % PALETTE_GRID_SIZE + 0.5f) * cell_size[0];
+      centre[1] = lab_min[1] + (cell / PALETTE_GRID_SIZE % PALETTE_GRID_SIZE + 0.5f) * cell_size[1];
+      centre[2] = lab_min[2] + (cell / (PALETTE_GRID_SIZE * PALETTE_GRID_SIZE) + 0.5f) * cell_size[2];
+
+      for (i = 0; i < n_clusters; i++)
+        nearest = MIN (nearest, get_distance (clusters[i].center, centre));
+
+      reach = sqrtf (nearest) + 2.0f * half_diagonal;
+
+      grid->cell_start[cell] = n_candidates;
+      for (i = 0; i < n_clusters; i++)
+        if (get_distance (clusters[i].center, centre) <= reach * reach)
+          cell_candidates[n_candidates++] = i;
+
+      while (n_candidates % PALETTE_GRID_LANES)
+        cell_candidates[n_candidates++] = -1;
+    }
+  grid->cell_start[n_cells] = n_candidates;
+
+  grid->candidate_l     = g_new (gfloat, MAX (n_candidates, 1));
+  grid->candidate_a     = g_new (gfloat, MAX (n_candidates, 1));
+  grid->candidate_b     = g_new (gfloat, MAX (n_candidates, 1));
+  grid->candidate_index = g_new (gint, MAX (n_candidates, 1));
+
+  for (i = 0; i < (gint) n_candidates; i++)
+    {
+      const Cluster *c = clusters + MAX (cell_candidates[i], 0);
+
+      /* Padding can never be nearest, so it maps to any valid index */
+      if (cell_candidates[i] < 0)
+        {
+          grid->candidate_l[i]     = PALETTE_GRID_FAR;
+          grid->candidate_a[i]     = PALETTE_GRID_FAR;
+          grid->candidate_b[i]     = PALETTE_GRID_FAR;
+          grid->candidate_index[i] = 0;
+          continue;
+        }
+
+      grid->candidate_l[i]     = c->center[0];
+      grid->candidate_a[i]     = c->center[1];
+      grid->candidate_b[i]     = c->center[2];
+      grid->candidate_index[i] = cell_candidates[i];
+    }
+
+  g_free (cell_candidates);
+
+  return grid;
+}
+
+static void
+palette_grid_free (PaletteGrid *grid)
+{
+  if (! grid)
+    return;
+
+  g_free (grid->half_separation);
+  g_free (grid->cell_start);
+  g_free (grid->candidate_l);
+  g_free (grid->candidate_a);
+  g_free (grid->candidate_b);
+  g_free (grid->candidate_index);
+  g_free (grid);
+}
+
+/* Nearest center to pixel, trying guess first */
+static inline gint
+palette_grid_find (const PaletteGrid *grid,
+                   const gfloat      *pixel,
+                   gint               guess)
+{
+  gfloat reach = grid->half_separation[guess];
+  gfloat min_distance = G_MAXFLOAT;
+  gint   min_candidate = 0;
+  gint   cell[3];
+  guint  first, last, i;
+  gint   k;
+
+  /* Neighbouring pixels mostly share a cluster; keep the guess when the
+   * pixel is provably nearest to it */
+  if (get_distance (grid->clusters[guess].center, pixel) <= reach * reach)
+    return guess;
+
+  for (k = 0; k < 3; k++)
+    {
+      gfloat position = (pixel[k] - grid->grid_min[k]) * grid->inv_cell_size[k];
+
+      if (! (position >= 0.0f && position < PALETTE_GRID_SIZE))
+        return find_nearest_cluster (pixel, grid->clusters, grid->n_clusters);
+
+      cell[k] = (gint) position;
+    }
+
+  k = (cell[2] * PALETTE_GRID_SIZE + cell[1]) * PALETTE_GRID_SIZE + cell[0];
+  first = grid->cell_start[k];
+  last  = grid->cell_start[k + 1];
+
+  for (i = first; i < last; i += PALETTE_GRID_LANES)
+    {
+      gfloat distance[PALETTE_GRID_LANES];
+      gint   lane;
+
+      /* Branch free over a whole block, then pick the first minimum so
+       * ties still go to the lowest cluster index */
+      for (lane = 0; lane < PALETTE_GRID_LANES; lane++)
+        distance[lane] = POW2 (grid->candidate_l[i + lane] - pixel[0]) +
+                         POW2 (grid->candidate_a[i + lane] - pixel[1]) +
+                         POW2 (grid->candidate_b[i + lane] - pixel[2]);
+
+      for (lane = 0; lane < PALETTE_GRID_LANES; lane++)
+        if (distance[lane] < min_distance)
+          {
+            min_distance  = distance[lane];
+            min_candidate = i + lane;
+          }
+    }
+
+  return grid->candidate_index[min_candidate];
+}
+
+static void
+set_output_area (const GeglRectangle *area,
+                 gpointer             user_data)
+{
+  OutputData         *data = user_data;
+  const Cluster      *clusters = data->grid->clusters;
   GeglBufferIterator *iter;
 
-  iter = gegl_buffer_iterator_new (output, NULL, 0, babl_format ("CIE Lab float"),
+  iter = gegl_buffer_iterator_new (data->output, area, 0, babl_format ("CIE Lab float"),
                                    GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 2);
 
-  gegl_buffer_iterator_add (iter, input, NULL, 0, babl_format ("CIE Lab float"),
+  gegl_buffer_iterator_add (iter, data->input, area, 0, babl_format ("CIE Lab float"),
                             GEGL_ACCESS_READ, GEGL_ABYSS_NONE);
 
   while (gegl_buffer_iterator_next (iter))
@@ -252,10 +760,11 @@ set_output (GeglBuffer *input,
       gfloat *out_pixel = iter->items[0].data;
       gfloat *in_pixel  = iter->items[1].data;
       glong   n_pixels = iter->length;
+      gint    index    = 0;
 
       while (n_pixels--)
         {
-          gint index = find_nearest_cluster (in_pixel, clusters, n_clusters);
+          index = palette_grid_find (data->grid, in_pixel, index);
 
           out_pixel[0] = clusters[index].center[0];
           out_pixel[1] = clusters[index].center[1];
@@ -267,6 +776,183 @@ set_output (GeglBuffer *input,
     }
 }
 
+static void
+set_output (GeglOperation     *operation,
+            GeglBuffer        *input,
+            GeglBuffer        *output,
+            const PaletteGrid *grid)
+{
+  OutputData data;
+
+  data.input  = input;
+  data.output = output;
+  data.grid   = grid;
+
+  gegl_parallel_distribute_area (gegl_buffer_get_extent (output),
+                                 gegl_operation_get_pixels_per_thread (operation),
+                                 GEGL_SPLIT_STRATEGY_AUTO,
+                                 set_output_area, &data);
+}
+
+static void
+kmeans_cache_input_changed (GeglBuffer          *buffer,
+                            const GeglRectangle *rect,
+                            KmeansCache         *cache)
+{
+  g_atomic_int_set (&cache->changed, 1);
+}
+
+static void
+kmeans_cache_release (KmeansCache *cache)
+{
+  if (cache->input)
+    {
+      g_signal_handler_disconnect (cache->input, cache->changed_handler);
+      g_object_remove_weak_pointer (G_OBJECT (cache->input),
+                                    (gpointer *) &cache->input);
+      cache->input = NULL;
+    }
+
+  g_clear_pointer (&cache->grid, palette_grid_free);
+  g_clear_pointer (&cache->clusters, g_free);
+}
+
+static const PaletteGrid *
+kmeans_cache_lookup (KmeansCache    *cache,
+                     GeglBuffer     *input,
+                     GeglProperties *o)
+{
+  if (cache->grid                                     &&
+      cache->input == input                           &&
+      ! g_atomic_int_get (&cache->changed)            &&
+      gegl_rectangle_equal (&cache->extent,
+                            gegl_buffer_get_extent (input)) &&
+      cache->n_clusters      == o->n_clusters         &&
+      cache->max_iterations  == o->max_iterations     &&
+      cache->seed            == o->seed               &&
+      cache->full_resolution == o->full_resolution)
+    return cache->grid;
+
+  return NULL;
+}
+
+/* Take ownership of clusters fitted to input */
+static void
+kmeans_cache_store (KmeansCache    *cache,
+                    GeglBuffer     *input,
+                    GeglProperties *o,
+                    Cluster        *clusters)
+{
+  kmeans_cache_release (cache);
+
+  cache->input = input;
+  g_object_add_weak_pointer (G_OBJECT (input), (gpointer *) &cache->input);
+  cache->changed_handler = gegl_buffer_signal_connect (input, "changed",
+                                                       G_CALLBACK (kmeans_cache_input_changed),
+                                                       cache);
+  g_atomic_int_set (&cache->changed, 0);
+
+  cache->extent          = *gegl_buffer_get_extent (input);
+  cache->n_clusters      = o->n_clusters;
+  cache->max_iterations  = o->max_iterations;
+  cache->seed            = o->seed;
+  cache->full_resolution = o->full_resolution;
+  cache->clusters        = clusters;
+  cache->grid            = palette_grid_new (clusters, o->n_clusters);
+}
+
+static Cluster *
+fit_clusters (GeglBuffer     *input,
+              GeglProperties *o)
+{
+  gint        iterations = o->max_iterations;
+  Cluster    *clusters = g_new0 (Cluster, o->n_clusters);
+  gfloat     *moved    = g_new0 (gfloat, o->n_clusters);
+  GRand      *prg      = g_rand_new_with_seed (o->seed);
+  Samples     samples;
+
+  if (o->full_resolution &&
+      (glong) gegl_buffer_get_width (input) * gegl_buffer_get_height (input) > MAX_PIXELS)
+    {
+      /* fit the clusters to a fresh random mini-batch every iteration */
+
+      samples_init (&samples, MAX_PIXELS);
+      read_batch (input, &samples, prg);
+      init_clusters (clusters, o->n_clusters, &samples, prg);
+
+      while (iterations--)
+        {
+          assign_pixels_to_clusters (&samples, clusters, o->n_clusters, moved, FALSE);
+          update_clusters_batch (clusters, o->n_clusters);
+
+          if (iterations)
+            read_batch (input, &samples, prg);
+        }
+    }
+  else
+    {
+      GeglBuffer *source;
+
+      /* if pixels count of input buffer > MAX_PIXELS, compute a smaller buffer */
+
+      downsample_buffer (input, &source);
+      read_samples (source, &samples);
+
+      if (source != input)
+        g_object_unref (source);
+
+      /* clusters initialization */
+
+      init_clusters (clusters, o->n_clusters, &samples, prg);
+
+      /* perform segmentation */
+
+      if (samples.n_samples > 0)
+        {
+          gboolean use_bounds = FALSE;
+
+          while (iterations--)
+            {
+              assign_pixels_to_clusters (&samples, clusters, o->n_clusters, moved, use_bounds);
+              use_bounds = TRUE;
+
+              if (!update_clusters (clusters, o->n_clusters, moved))
+                break;
+            }
+        }
+    }
+
+  samples_clear (&samples);
+  g_rand_free (prg);
+  g_free (moved);
+
+  return clusters;
+}
+
+/* Hand a new row of cluster centers to the caller, like gegl:buffer-sink */
+static void
+write_palette (GeglProperties *o,
+               const Cluster  *clusters)
+{
+  GeglRectangle  row = {0, 0, o->n_clusters, 1};
+  GeglBuffer   **palette = o->palette;
+  gfloat        *centers = g_new (gfloat, 3 * o->n_clusters);
+  gint           i;
+
+  for (i = 0; i < o->n_clusters; i++)
+    {
+      centers[3 * i + 0] = clusters[i].center[0];
+      centers[3 * i + 1] = clusters[i].center[1];
+      centers[3 * i + 2] = clusters[i].center[2];
+    }
+
+  *palette = gegl_buffer_new (&row, babl_format ("CIE Lab float"));
+  gegl_buffer_set (*palette, &row, 0, babl_format ("CIE Lab float"),
+                   centers, GEGL_AUTO_ROWSTRIDE);
+
+  g_free (centers);
+}
+
 static void
 prepare (GeglOperation *operation)
 {
@@ -309,37 +995,29 @@ process (GeglOperation       *operation,
          const GeglRectangle *result,
          gint                 level)
 {
-  GeglProperties *o = GEGL_PROPERTIES (operation);
-  gint            iterations = o->max_iterations;
-  Cluster    *clusters;
-  GeglBuffer *source;
-
-  /* if pixels count of input buffer > MAX_PIXELS, compute a smaller buffer */
-
-  downsample_buffer (input, &source);
+  GeglProperties    *o     = GEGL_PROPERTIES (operation);
+  KmeansCache       *cache = o->user_data;
+  const PaletteGrid *grid;
 
-  /* clusters initialization */
+  if (! cache)
+    cache = o->user_data = g_new0 (KmeansCache, 1);
 
-  clusters = init_clusters (source, o);
+  /* only fit the clusters again when the input or parameters changed */
 
-  /* perform segmentation */
+  grid = kmeans_cache_lookup (cache, input, o);
 
-  while (iterations--)
+  if (! grid)
     {
-      assign_pixels_to_clusters (source, clusters, o->n_clusters);
-
-      if (!update_clusters (clusters, o->n_clusters))
-        break;
+      kmeans_cache_store (cache, input, o, fit_clusters (input, o));
+      grid = cache->grid;
     }
 
   /* apply cluster colors to output */
 
-  set_output (input, output, clusters, o->n_clusters);
-
-  g_free (clusters);
+  set_output (operation, input, output, grid);
 
-  if (source != input)
-    g_object_unref (source);
+  if (o->palette)
+    write_palette (o, grid->clusters);
 
   return TRUE;
 }
@@ -370,6 +1048,20 @@ operation_process (GeglOperation        *operation,
                                    gegl_operation_context_get_level (context));
 }
 
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  if (o->user_data)
+    {
+      kmeans_cache_release (o->user_data);
+      g_clear_pointer (&o->user_data, g_free);
+    }
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
@@ -379,6 +1071,8 @@ gegl_op_class_init (GeglOpClass *klass)
   operation_class = GEGL_OPERATION_CLASS (klass);
   filter_class    = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
+
   filter_class->process                    = process;
   operation_class->prepare                 = prepare;
   operation_class->process                 = operation_process;
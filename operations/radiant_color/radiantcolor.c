@@ -49,6 +49,7 @@ property_double (opacity, _("Opacity"), 1.0)
 #define GEGL_OP_C_SOURCE radiantcolor.c
 
 #include "gegl-op.h"
+#include "lb-blend.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -134,8 +135,40 @@ process (GeglOperation       *op,
   /* Access the properties */
   gdouble intensity_factor = GEGL_PROPERTIES (op)->intensity_factor;
   gdouble opacity = GEGL_PROPERTIES (op)->opacity;
+  gfloat  opacity_f = opacity;
+  gfloat  intensity_f = intensity_factor;
 
-  for (i = 0; i < n_pixels; i++)
+  i = 0;
+  if (components == 4)
+    for (; i + LB_BLEND_BLOCK <= n_pixels; i += LB_BLEND_BLOCK)
+      {
+        gfloat blend_factor[LB_BLEND_BLOCK];
+        gfloat blended[LB_BLEND_BLOCK * 4];
+
+        /* Aux strength from the luminance of each input pixel */
+        for (gint j = 0; j < LB_BLEND_BLOCK; j++)
+          {
+            const gfloat *b = in + j * 4;
+            gfloat luminance = (b[0] + b[1] + b[2]) / 3.0f;
+
+            blend_factor[j] = MIN (luminance * intensity_f, 1.0f);
+          }
+
+        for (gint j = 0; j < LB_BLEND_BLOCK * 4; j++)
+          {
+            gfloat processed = in[j] + blend_factor[j / 4] * (aux[j] - in[j]);
+
+            blended[j] = lb_blend_mix (in[j], processed, opacity_f);
+          }
+
+        lb_blend_store (in, blended, out);
+
+        in  += LB_BLEND_BLOCK * 4;
+        aux += LB_BLEND_BLOCK * 4;
+        out += LB_BLEND_BLOCK * 4;
+      }
+
+  for (; i < n_pixels; i++)
     {
       gfloat a_r = aux[0];  /* Source (aux) red */
       gfloat a_g = aux[1];  /* Source green */
@@ -22,6 +22,7 @@
 #include <math.h>
 #include <gegl.h>
 #include <gegl-plugin.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -141,32 +142,250 @@ property_double (ring_thickness, _("Ring Thickness"), 0.5)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     the_shapes_core
 #define GEGL_OP_C_SOURCE shapedesigncore.c
 
 #include "gegl-op.h"
 
-// Helper function to check if a point (px, py) is on the left side of a line from (x1, y1) to (x2, y2)
-static gfloat point_side(gfloat px, gfloat py, gfloat x1, gfloat y1, gfloat x2, gfloat y2)
+#define SHAPE_MAX_EDGES 20  // 10 star points alternating with 10 inner corners
+
+// Rotation and polygon edges of the selected shape, rebuilt by prepare()
+// and shared read-only by all threads. Convex polygons are stored as
+// half-planes a * x + b * y + c with unit outward normals, so their
+// signed distance is the largest of the edge values. The star is not
+// convex and keeps its edges for the even-odd crossing test instead.
+typedef struct
+{
+  gfloat cos_rot;
+  gfloat sin_rot;
+  gint   n_edges;
+  gfloat a[SHAPE_MAX_EDGES];
+  gfloat b[SHAPE_MAX_EDGES];
+  gfloat c[SHAPE_MAX_EDGES];
+  gfloat x1[SHAPE_MAX_EDGES];
+  gfloat y1[SHAPE_MAX_EDGES];
+  gfloat y2[SHAPE_MAX_EDGES];
+  gfloat dx_over_dy[SHAPE_MAX_EDGES];  // Inverse slope for the crossing test
+} ShapeGeometry;
+
+// Store the edges of a polygon given by n vertices
+static void
+shape_geometry_set_polygon (ShapeGeometry *geometry, const gfloat vertices[][2], gint n)
+{
+  gfloat centroid_x = 0.0, centroid_y = 0.0;
+
+  for (gint j = 0; j < n; j++)
+  {
+    centroid_x += vertices[j][0] / n;
+    centroid_y += vertices[j][1] / n;
+  }
+
+  geometry->n_edges = n;
+  for (gint j = 0; j < n; j++)
+  {
+    gfloat x1 = vertices[j][0];
+    gfloat y1 = vertices[j][1];
+    gfloat x2 = vertices[(j + 1) % n][0];
+    gfloat y2 = vertices[(j + 1) % n][1];
+    gfloat length = sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+    gfloat a = (y2 - y1) / length;
+    gfloat b = (x1 - x2) / length;
+    gfloat c = -(a * x1 + b * y1);
+
+    // Point the normal away from the inside
+    if (a * centroid_x + b * centroid_y + c > 0.0)
+    {
+      a = -a;
+      b = -b;
+      c = -c;
+    }
+
+    geometry->a[j] = a;
+    geometry->b[j] = b;
+    geometry->c[j] = c;
+    geometry->x1[j] = x1;
+    geometry->y1[j] = y1;
+    geometry->y2[j] = y2;
+    geometry->dx_over_dy[j] = y2 != y1 ? (x2 - x1) / (y2 - y1) : 0.0;
+  }
+}
+
+// Regular polygon with its first vertex at the top
+static void
+shape_geometry_set_regular (ShapeGeometry *geometry, gint sides)
+{
+  gfloat vertices[12][2]; // Up to 12 sides
+
+  for (gint j = 0; j < sides; j++)
+  {
+    gfloat angle = j * 2.0 * G_PI / sides - G_PI / 2.0;
+    vertices[j][0] = cos(angle);
+    vertices[j][1] = sin(angle);
+  }
+  shape_geometry_set_polygon (geometry, vertices, sides);
+}
+
+static ShapeGeometry *
+shape_geometry_new (GeglProperties *o)
+{
+  ShapeGeometry *geometry = g_new0 (ShapeGeometry, 1);
+  gfloat rotation = o->rotation * G_PI / 180.0; // Convert degrees to radians
+
+  geometry->cos_rot = cos(rotation);
+  geometry->sin_rot = sin(rotation);
+
+  switch (o->shape)
+  {
+    case GEGL_SHAPE_STAR:
+    {
+      // Star: Polygon-based star using line segments (pentagram style)
+      gfloat outer_radius = 1.0;
+      gfloat inner_radius = 0.4 + o->pointiness; // Adjusted by pointiness
+      gfloat vertices[SHAPE_MAX_EDGES][2]; // Up to 10 points * 2 (outer + inner)
+      for (gint j = 0; j < o->star_points; j++)
+      {
+        gfloat angle_outer = j * 2.0 * G_PI / o->star_points - G_PI / 2.0;
+        gfloat angle_inner = (j + 0.5) * 2.0 * G_PI / o->star_points - G_PI / 2.0;
+        vertices[2 * j][0] = outer_radius * cos(angle_outer);
+        vertices[2 * j][1] = outer_radius * sin(angle_outer);
+        vertices[2 * j + 1][0] = inner_radius * cos(angle_inner);
+        vertices[2 * j + 1][1] = inner_radius * sin(angle_inner);
+      }
+      shape_geometry_set_polygon (geometry, vertices, o->star_points * 2);
+      break;
+    }
+    case GEGL_SHAPE_POLYGON:
+    {
+      // Even Polygons: Hexagon (6 sides) to Duodecagon (12 sides)
+      gint sides;
+      switch (o->polygon_sides)
+      {
+        case 1: sides = 6; break;  // Hexagon
+        case 2: sides = 8; break;  // Octagon
+        case 3: sides = 10; break; // Decagon
+        case 4: sides = 12; break; // Duodecagon
+        default: sides = 6; break;
+      }
+      shape_geometry_set_regular (geometry, sides);
+      break;
+    }
+    case GEGL_SHAPE_UNEVEN_POLYGON:
+    {
+      // Uneven Polygons: Pentagon (5 sides), Heptagon (7 sides), Nonagon (9 sides)
+      gint sides;
+      switch (o->uneven_polygon_sides)
+      {
+        case 1: sides = 5; break;  // Pentagon
+        case 2: sides = 7; break;  // Heptagon
+        case 3: sides = 9; break;  // Nonagon
+        default: sides = 5; break;
+      }
+      shape_geometry_set_regular (geometry, sides);
+      break;
+    }
+    case GEGL_SHAPE_TRAPEZOID:
+    {
+      // Trapezoid: Four sides with parallel top and bottom
+      gfloat top_width;
+      switch (o->trapezoid_top_width)
+      {
+        case 1: top_width = 0.4; break;  // Narrow top
+        case 2: top_width = 0.7; break;  // Medium top
+        case 3: top_width = 1.0; break;  // Wide top (rectangle)
+        default: top_width = 0.4; break;
+      }
+      const gfloat vertices[4][2] = {
+        {-1.0, -1.0},        // Bottom left
+        {1.0, -1.0},         // Bottom right
+        {top_width, 1.0},    // Top right
+        {-top_width, 1.0}    // Top left
+      };
+      shape_geometry_set_polygon (geometry, vertices, 4);
+      break;
+    }
+    case GEGL_SHAPE_PARALLELOGRAM:
+    {
+      // Parallelogram: Four sides with opposite sides equal and parallel
+      const gfloat vertices[4][2] = {
+        {-1.0, -1.0},        // Bottom left
+        {0.5, -1.0},         // Bottom right
+        {1.0, 1.0},          // Top right
+        {-0.5, 1.0}          // Top left
+      };
+      shape_geometry_set_polygon (geometry, vertices, 4);
+      break;
+    }
+    case GEGL_SHAPE_RIGHT_TRIANGLE:
+    {
+      // Right Triangle: Vertices at (-1,-1), (1,-1), (-1,1)
+      const gfloat vertices[3][2] = {
+        {-1.0, -1.0},  // Bottom-left (right angle)
+        {1.0, -1.0},   // Bottom-right
+        {-1.0, 1.0}    // Top-left
+      };
+      shape_geometry_set_polygon (geometry, vertices, 3);
+      break;
+    }
+    default:
+      break;
+  }
+
+  return geometry;
+}
+
+// Signed distance to a convex polygon: the largest half-plane value
+static inline gfloat
+shape_convex_value (const ShapeGeometry *geometry, gfloat nx, gfloat ny)
+{
+  gfloat value = -G_MAXFLOAT;
+
+  for (gint j = 0; j < geometry->n_edges; j++)
+    value = MAX (value, geometry->a[j] * nx + geometry->b[j] * ny + geometry->c[j]);
+
+  return value;
+}
+
+// Even-odd rule: count the edges crossed by a ray towards +x
+static inline gfloat
+shape_crossing_value (const ShapeGeometry *geometry, gfloat nx, gfloat ny)
 {
-  return (x2 - x1) * (py - y1) - (y2 - y1) * (px - x1);
+  gint crossings = 0;
+
+  for (gint j = 0; j < geometry->n_edges; j++)
+    crossings ^= ((geometry->y1[j] > ny) != (geometry->y2[j] > ny)) &
+                 (nx < (ny - geometry->y1[j]) * geometry->dx_over_dy[j] + geometry->x1[j]);
+
+  return crossings ? -1.0 : 1.0;
 }
 
 static void
 prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  GeglProperties *o = GEGL_PROPERTIES (operation);
+
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
+
+  g_free (o->user_data);
+  o->user_data = shape_geometry_new (o);
+}
+
+static void
+finalize (GObject *object)
+{
+  GeglProperties *o = GEGL_PROPERTIES (object);
+
+  g_clear_pointer (&o->user_data, g_free);
+
+  G_OBJECT_CLASS (gegl_op_parent_class)->finalize (object);
 }
 
 static gboolean
-process (GeglOperation       *operation,
-         void               *in_buf,
-         void               *out_buf,
-         glong               n_pixels,
-         const GeglRectangle *roi,
-         gint                level)
+render (GeglOperation       *operation,
+        void               *out_buf,
+        glong               n_pixels,
+        const GeglRectangle *roi,
+        gint                level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out_pixel = (gfloat *) out_buf;
@@ -191,35 +410,38 @@ process (GeglOperation       *operation,
   gfloat roi_offset_x = roi->x;
   gfloat roi_offset_y = roi->y;
 
+  const ShapeGeometry *geometry = o->user_data;
+
   gfloat scale = o->scale / 2.0; // Halve the scale denominator to keep shape twice as large
   gfloat width_scale = o->width_scale;
   gfloat height_scale = o->height_scale;
-  gfloat rotation = o->rotation * G_PI / 180.0; // Convert degrees to radians
   gfloat pointiness = o->pointiness;
   gfloat lobe_roundness = o->lobe_roundness;
   gfloat square_to_rectangle = o->square_to_rectangle;
   gfloat ring_thickness = o->ring_thickness;
   gfloat theta, r, t;
   gint star_points = o->star_points;
-  gint polygon_sides = o->polygon_sides;
-  gint trapezoid_top_width = o->trapezoid_top_width;
-  gint uneven_polygon_sides = o->uneven_polygon_sides;
 
-  for (glong i = 0; i < n_pixels; i++)
+  // Rotated basis: the change of the shape coordinates per pixel step in x
+  // and in y, so each pixel costs two dot products instead of normalizing
+  // and rotating with trigonometry
+  gfloat inv_sx = 1.0 / (canvas_width * scale * width_scale);
+  gfloat inv_sy = 1.0 / (canvas_height * scale * height_scale);
+  gfloat step_x_nx = geometry->cos_rot * inv_sx;
+  gfloat step_x_ny = -geometry->sin_rot * inv_sx;
+  gfloat step_y_nx = geometry->sin_rot * inv_sy;
+  gfloat step_y_ny = geometry->cos_rot * inv_sy;
+
+  for (gint row = 0; row < roi->height; row++)
+  for (gint col = 0; col < roi->width; col++)
   {
-    // Compute global coordinates, adjusted for ROI offset
-    gint x = (i % roi->width) + roi_offset_x;
-    gint y = (i / roi->width) + roi_offset_y;
-
-    // Normalize coordinates relative to center and scale
-    gfloat nx = (x - cx) / (canvas_width * scale * width_scale);
-    gfloat ny = (y - cy) / (canvas_height * scale * height_scale);
+    // Offset from the center in global coordinates, adjusted for ROI offset
+    gfloat dx = col + roi_offset_x - cx;
+    gfloat dy = row + roi_offset_y - cy;
 
-    // Apply rotation
-    gfloat nx_rot = nx * cos(rotation) + ny * sin(rotation);
-    gfloat ny_rot = -nx * sin(rotation) + ny * cos(rotation);
-    nx = nx_rot;
-    ny = ny_rot;
+    // Normalized and rotated coordinates relative to the center
+    gfloat nx = dx * step_x_nx + dy * step_y_nx;
+    gfloat ny = dx * step_x_ny + dy * step_y_ny;
 
     // Shape equations
     gfloat shape_value = 0.0;
@@ -265,31 +487,7 @@ process (GeglOperation       *operation,
       case GEGL_SHAPE_STAR:
       {
         // Star: Polygon-based star using line segments (pentagram style)
-        gint total_points = star_points * 2; // Outer and inner points
-        gfloat outer_radius = 1.0;
-        gfloat inner_radius = 0.4 + pointiness; // Adjusted by pointiness
-        gfloat vertices[20][2]; // Up to 10 points * 2 (outer + inner)
-        for (gint j = 0; j < star_points; j++)
-        {
-          gfloat angle_outer = j * 2.0 * G_PI / star_points - G_PI / 2.0;
-          gfloat angle_inner = (j + 0.5) * 2.0 * G_PI / star_points - G_PI / 2.0;
-          vertices[2 * j][0] = outer_radius * cos(angle_outer);
-          vertices[2 * j][1] = outer_radius * sin(angle_outer);
-          vertices[2 * j + 1][0] = inner_radius * cos(angle_inner);
-          vertices[2 * j + 1][1] = inner_radius * sin(angle_inner);
-        }
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < total_points; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % total_points][0];
-          gfloat y2 = vertices[(j + 1) % total_points][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_crossing_value(geometry, nx, ny);
         break;
       }
       case GEGL_SHAPE_FLOWER:
@@ -310,36 +508,7 @@ process (GeglOperation       *operation,
       case GEGL_SHAPE_POLYGON:
       {
         // Even Polygons: Hexagon (6 sides) to Duodecagon (12 sides)
-        gint sides;
-        switch (polygon_sides)
-        {
-          case 1: sides = 6; break;  // Hexagon
-          case 2: sides = 8; break;  // Octagon
-          case 3: sides = 10; break; // Decagon
-          case 4: sides = 12; break; // Duodecagon
-          default: sides = 6; break;
-        }
-        // Generate vertices for a regular polygon
-        gfloat vertices[12][2]; // Up to 12 sides
-        gfloat radius = 1.0;
-        for (gint j = 0; j < sides; j++)
-        {
-          gfloat angle = j * 2.0 * G_PI / sides - G_PI / 2.0;
-          vertices[j][0] = radius * cos(angle);
-          vertices[j][1] = radius * sin(angle);
-        }
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < sides; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % sides][0];
-          gfloat y2 = vertices[(j + 1) % sides][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_convex_value(geometry, nx, ny);
         break;
       }
       case GEGL_SHAPE_ARROW:
@@ -371,66 +540,13 @@ process (GeglOperation       *operation,
       case GEGL_SHAPE_TRAPEZOID:
       {
         // Trapezoid: Four sides with parallel top and bottom
-        gfloat top_width;
-        switch (trapezoid_top_width)
-        {
-          case 1: top_width = 0.4; break;  // Narrow top
-          case 2: top_width = 0.7; break;  // Medium top
-          case 3: top_width = 1.0; break;  // Wide top (rectangle)
-          default: top_width = 0.4; break;
-        }
-        gfloat vertices[4][2] = {
-          {-1.0, -1.0},        // Bottom left
-          {1.0, -1.0},         // Bottom right
-          {top_width, 1.0},    // Top right
-          {-top_width, 1.0}    // Top left
-        };
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < 4; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % 4][0];
-          gfloat y2 = vertices[(j + 1) % 4][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_convex_value(geometry, nx, ny);
         break;
       }
       case GEGL_SHAPE_UNEVEN_POLYGON:
       {
         // Uneven Polygons: Pentagon (5 sides), Heptagon (7 sides), Nonagon (9 sides)
-        gint sides;
-        switch (uneven_polygon_sides)
-        {
-          case 1: sides = 5; break;  // Pentagon
-          case 2: sides = 7; break;  // Heptagon
-          case 3: sides = 9; break;  // Nonagon
-          default: sides = 5; break;
-        }
-        // Generate vertices for a regular polygon
-        gfloat vertices[9][2]; // Up to 9 sides
-        gfloat radius = 1.0;
-        for (gint j = 0; j < sides; j++)
-        {
-          gfloat angle = j * 2.0 * G_PI / sides - G_PI / 2.0;
-          vertices[j][0] = radius * cos(angle);
-          vertices[j][1] = radius * sin(angle);
-        }
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < sides; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % sides][0];
-          gfloat y2 = vertices[(j + 1) % sides][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_convex_value(geometry, nx, ny);
         break;
       }
       case GEGL_SHAPE_HEXAGRAM:
@@ -455,24 +571,7 @@ process (GeglOperation       *operation,
       case GEGL_SHAPE_PARALLELOGRAM:
       {
         // Parallelogram: Four sides with opposite sides equal and parallel
-        gfloat vertices[4][2] = {
-          {-1.0, -1.0},        // Bottom left
-          {0.5, -1.0},         // Bottom right
-          {1.0, 1.0},          // Top right
-          {-0.5, 1.0}          // Top left
-        };
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < 4; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % 4][0];
-          gfloat y2 = vertices[(j + 1) % 4][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_convex_value(geometry, nx, ny);
         break;
       }
       case GEGL_SHAPE_OVAL:
@@ -502,30 +601,13 @@ process (GeglOperation       *operation,
       case GEGL_SHAPE_QUARTER_CIRCLE:
       {
         // Quarter Circle: First quadrant of an ellipse (x >= 0, y >= 0)
-        theta = atan2(ny, nx);
         shape_value = (nx * nx + ny * ny <= 1.0 && nx >= 0.0 && ny >= 0.0) ? -1.0 : 1.0;
         break;
       }
       case GEGL_SHAPE_RIGHT_TRIANGLE:
       {
         // Right Triangle: Vertices at (-1,-1), (1,-1), (-1,1)
-        gfloat vertices[3][2] = {
-          {-1.0, -1.0},  // Bottom-left (right angle)
-          {1.0, -1.0},   // Bottom-right
-          {-1.0, 1.0}    // Top-left
-        };
-        // Point-in-polygon test using ray casting
-        gint intersections = 0;
-        for (gint j = 0; j < 3; j++)
-        {
-          gfloat x1 = vertices[j][0];
-          gfloat y1 = vertices[j][1];
-          gfloat x2 = vertices[(j + 1) % 3][0];
-          gfloat y2 = vertices[(j + 1) % 3][1];
-          if (((y1 > ny) != (y2 > ny)) && (nx < (x2 - x1) * (ny - y1) / (y2 - y1) + x1))
-            intersections++;
-        }
-        shape_value = (intersections % 2 == 0) ? 1.0 : -1.0;
+        shape_value = shape_convex_value(geometry, nx, ny);
         break;
       }
       default:
@@ -555,14 +637,27 @@ process (GeglOperation       *operation,
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
+  G_OBJECT_CLASS (klass)->finalize = finalize;
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "ai/lb:shapes-core",
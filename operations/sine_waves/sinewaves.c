@@ -22,6 +22,7 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -89,7 +90,7 @@ property_boolean(transparent_background, _("Transparent Background"), FALSE)
 
 static void prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static GeglRectangle get_bounding_box (GeglOperation *operation)
@@ -97,6 +98,161 @@ static GeglRectangle get_bounding_box (GeglOperation *operation)
   return gegl_rectangle_infinite_plane ();
 }
 
+/* Decide whether a point in tile space lies on the pattern */
+static gboolean
+sine_waves_in_shape (GeglProperties *o,
+                     gdouble         tx,
+                     gdouble         ty)
+{
+  gdouble tile_size = o->tile_size;
+  gboolean in_shape = FALSE;
+
+  switch (o->pattern)
+  {
+    case SINE_WAVE_BANDS:
+    {
+      gdouble cell_size = tile_size / 4.0;
+      gdouble wave = sin((tx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
+      gdouble band = fmod(ty + wave, cell_size / 2.0);
+      gdouble base_line_width = cell_size * 0.15 * o->line_width;
+      if (band < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_ZIGZAG:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble wave = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
+      gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
+      gdouble base_line_width = cell_size * 0.1 * o->line_width;
+      if (fabs(zigzag - cell_size / 8.0) < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_SHARP:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble wave = sin((tx / cell_size) * 4.0 * G_PI) * (cell_size / 4.0);
+      gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
+      gdouble base_line_width = cell_size * 0.1 * o->line_width;
+      if (fabs(zigzag - cell_size / 8.0) < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_FOLDS:
+    {
+      gdouble cell_size = tile_size / 4.0;
+      gdouble wave = sin((tx / cell_size) * 1.5 * G_PI + (ty / cell_size) * G_PI) * (cell_size / 3.0);
+      gdouble band = fmod(ty + wave, cell_size / 2.0);
+      gdouble base_line_width = cell_size * 0.15 * o->line_width;
+      if (band < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_KINKS:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble wave_x = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
+      gdouble wave_y = sin((ty / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
+      gdouble zigzag = fabs(fmod(ty + wave_x, cell_size / 2.0) - cell_size / 4.0);
+      gdouble base_line_width = cell_size * 0.1 * o->line_width;
+      if (fabs(zigzag - (cell_size / 8.0 + wave_y / 4.0)) < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_BRAIDS:
+    {
+      gdouble cell_size = tile_size / 4.0;
+      gdouble wave1 = sin((tx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
+      gdouble wave2 = sin((tx / cell_size) * 1.5 * G_PI + G_PI / 2.0) * (cell_size / 3.0);
+      gdouble band1 = fmod(ty + wave1, cell_size / 2.0);
+      gdouble band2 = fmod(ty + wave2, cell_size / 2.0);
+      gdouble base_line_width = cell_size * 0.15 * o->line_width;
+      if (band1 < base_line_width || band2 < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_CRESTS:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble amplitude = (cell_size / 4.0) * (1.0 + 0.5 * sin((ty / cell_size) * G_PI));
+      gdouble wave = sin((tx / cell_size) * 2.0 * G_PI) * amplitude;
+      gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
+      gdouble base_line_width = cell_size * 0.1 * o->line_width;
+      if (fabs(zigzag - cell_size / 8.0) < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_FRINGES:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble wave = sin((tx / cell_size) * 4.0 * G_PI) * sin((ty / cell_size) * 4.0 * G_PI) * (cell_size / 4.0);
+      gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
+      gdouble base_line_width = cell_size * 0.1 * o->line_width;
+      if (fabs(zigzag - cell_size / 8.0) < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_RIPPLES:
+    {
+      gdouble cell_size = tile_size / 4.0;
+      gdouble phase_x = (tx / tile_size) * 2.0 * G_PI;
+      gdouble phase_y = (ty / tile_size) * 2.0 * G_PI;
+      gdouble wave = sin(phase_x + sin(phase_y)) * (cell_size / 3.0);
+      gdouble band = fmod(ty + wave, cell_size / 2.0);
+      gdouble base_line_width = cell_size * 0.15 * o->line_width;
+      if (band < base_line_width)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_VORTICES:
+    {
+      gdouble phase_x = (tx / tile_size) * 2.0 * G_PI;
+      gdouble phase_y = (ty / tile_size) * 2.0 * G_PI;
+      gdouble vortex = sin(phase_x + cos(phase_y)) * cos(phase_y + sin(phase_x));
+      gdouble threshold = 0.2 * o->line_width;
+      if (fabs(vortex) < threshold && vortex > -threshold)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+    case SINE_WAVE_ISOBUBBLES:
+    {
+      gdouble cell_size = tile_size / 5.0;
+      gdouble px = (tx / tile_size) * 2.0 * G_PI;
+      gdouble py = (ty / tile_size) * 2.0 * G_PI;
+      gdouble weave = sin(px * 2.0 + cos(py)) + sin(py * 2.0 + cos(px));
+      gdouble base_line_width = cell_size * 0.15 * o->line_width;
+      if (fabs(weave - 0.5) < base_line_width / cell_size)
+      {
+        in_shape = TRUE;
+      }
+      break;
+    }
+  }
+
+  return in_shape;
+}
+
 static gboolean
 process (GeglOperation        *operation,
          GeglOperationContext *context,
@@ -106,213 +262,79 @@ process (GeglOperation        *operation,
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   GeglBuffer *output = gegl_operation_context_get_target (context, output_prop);
+  const Babl *format = babl_format ("RGBA float");
+  GeglBufferIterator *iter;
   gdouble fg_color[4], bg_color[4];
+  gfloat fg[4], bg[4];
   gdouble tile_size = o->tile_size;
-  GeglRectangle rect = *result;
-  gint x, y;
+  gdouble scale = (gdouble) (1 << level);
 
   // Get color values
   gegl_color_get_rgba (o->foreground_color, &fg_color[0], &fg_color[1], &fg_color[2], &fg_color[3]);
   gegl_color_get_rgba (o->background_color, &bg_color[0], &bg_color[1], &bg_color[2], &bg_color[3]);
 
+  fg[0] = fg_color[0];
+  fg[1] = fg_color[1];
+  fg[2] = fg_color[2];
+  fg[3] = 1.0;
+
+  if (o->transparent_background)
+  {
+    bg[0] = bg[1] = bg[2] = bg[3] = 0.0;
+  }
+  else
+  {
+    bg[0] = bg_color[0];
+    bg[1] = bg_color[1];
+    bg[2] = bg_color[2];
+    bg[3] = 1.0;
+  }
+
   // Convert rotation to radians
   gdouble rotation_rad = o->rotation * G_PI / 180.0;
   gdouble cos_rot = cos(rotation_rad);
   gdouble sin_rot = sin(rotation_rad);
 
-  for (y = rect.y; y < rect.y + rect.height; y++)
+  gdouble offset_x = o->offset_x * tile_size;
+  gdouble offset_y = o->offset_y * tile_size;
+
+  // Write straight into the linear rows of each destination tile; at
+  // mipmap levels every output pixel covers scale x scale source pixels
+  iter = gegl_buffer_iterator_new (output, result, level, format,
+                                   GEGL_ACCESS_WRITE, GEGL_ABYSS_NONE, 1);
+
+  while (gegl_buffer_iterator_next (iter))
   {
-    for (x = rect.x; x < rect.x + rect.width; x++)
-    {
-      gdouble px = (gdouble)x;
-      gdouble py = (gdouble)y;
+    gfloat *out = iter->items[0].data;
+    GeglRectangle roi = iter->items[0].roi;
+    gint x, y;
 
-      // Apply rotation to the original pixel coordinates around (0, 0)
-      gdouble px_rot = px * cos_rot - py * sin_rot;
-      gdouble py_rot = px * sin_rot + py * cos_rot;
+    for (y = roi.y; y < roi.y + roi.height; y++)
+    {
+      gdouble py = y * scale;
 
-      // Apply x and y offsets
-      gdouble offset_x = o->offset_x * tile_size;
-      gdouble offset_y = o->offset_y * tile_size;
+      for (x = roi.x; x < roi.x + roi.width; x++)
+      {
+        gdouble px = x * scale;
 
-      // Map rotated and offset coordinates to tile space
-      gdouble tx = fmod(px_rot + offset_x, tile_size);
-      gdouble ty = fmod(py_rot + offset_y, tile_size);
-      if (tx < 0) tx += tile_size;
-      if (ty < 0) ty += tile_size;
+        // Apply rotation to the original pixel coordinates around (0, 0)
+        gdouble px_rot = px * cos_rot - py * sin_rot;
+        gdouble py_rot = px * sin_rot + py * cos_rot;
 
-      gfloat out[4];
-      gboolean in_shape = FALSE;
+        // Map rotated and offset coordinates to tile space
+        gdouble tx = fmod(px_rot + offset_x, tile_size);
+        gdouble ty = fmod(py_rot + offset_y, tile_size);
+        if (tx < 0) tx += tile_size;
+        if (ty < 0) ty += tile_size;
 
-      switch (o->pattern)
-      {
-        case SINE_WAVE_BANDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble wave = sin((tx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
-          gdouble band = fmod(ty + wave, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (band < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_ZIGZAG:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble wave = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(zigzag - cell_size / 8.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_SHARP:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble wave = sin((tx / cell_size) * 4.0 * G_PI) * (cell_size / 4.0);
-          gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(zigzag - cell_size / 8.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_FOLDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble wave = sin((tx / cell_size) * 1.5 * G_PI + (ty / cell_size) * G_PI) * (cell_size / 3.0);
-          gdouble band = fmod(ty + wave, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (band < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_KINKS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble wave_x = sin((tx / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble wave_y = sin((ty / cell_size) * 2.0 * G_PI) * (cell_size / 4.0);
-          gdouble zigzag = fabs(fmod(ty + wave_x, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(zigzag - (cell_size / 8.0 + wave_y / 4.0)) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_BRAIDS:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble wave1 = sin((tx / cell_size) * 1.5 * G_PI) * (cell_size / 3.0);
-          gdouble wave2 = sin((tx / cell_size) * 1.5 * G_PI + G_PI / 2.0) * (cell_size / 3.0);
-          gdouble band1 = fmod(ty + wave1, cell_size / 2.0);
-          gdouble band2 = fmod(ty + wave2, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (band1 < base_line_width || band2 < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_CRESTS:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble amplitude = (cell_size / 4.0) * (1.0 + 0.5 * sin((ty / cell_size) * G_PI));
-          gdouble wave = sin((tx / cell_size) * 2.0 * G_PI) * amplitude;
-          gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(zigzag - cell_size / 8.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_FRINGES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble wave = sin((tx / cell_size) * 4.0 * G_PI) * sin((ty / cell_size) * 4.0 * G_PI) * (cell_size / 4.0);
-          gdouble zigzag = fabs(fmod(ty + wave, cell_size / 2.0) - cell_size / 4.0);
-          gdouble base_line_width = cell_size * 0.1 * o->line_width;
-          if (fabs(zigzag - cell_size / 8.0) < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_RIPPLES:
-        {
-          gdouble cell_size = tile_size / 4.0;
-          gdouble phase_x = (tx / tile_size) * 2.0 * G_PI;
-          gdouble phase_y = (ty / tile_size) * 2.0 * G_PI;
-          gdouble wave = sin(phase_x + sin(phase_y)) * (cell_size / 3.0);
-          gdouble band = fmod(ty + wave, cell_size / 2.0);
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (band < base_line_width)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_VORTICES:
-        {
-          gdouble phase_x = (tx / tile_size) * 2.0 * G_PI;
-          gdouble phase_y = (ty / tile_size) * 2.0 * G_PI;
-          gdouble vortex = sin(phase_x + cos(phase_y)) * cos(phase_y + sin(phase_x));
-          gdouble threshold = 0.2 * o->line_width;
-          if (fabs(vortex) < threshold && vortex > -threshold)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-        case SINE_WAVE_ISOBUBBLES:
-        {
-          gdouble cell_size = tile_size / 5.0;
-          gdouble px = (tx / tile_size) * 2.0 * G_PI;
-          gdouble py = (ty / tile_size) * 2.0 * G_PI;
-          gdouble weave = sin(px * 2.0 + cos(py)) + sin(py * 2.0 + cos(px));
-          gdouble base_line_width = cell_size * 0.15 * o->line_width;
-          if (fabs(weave - 0.5) < base_line_width / cell_size)
-          {
-            in_shape = TRUE;
-          }
-          break;
-        }
-      }
+        const gfloat *color = sine_waves_in_shape (o, tx, ty) ? fg : bg;
 
-      if (in_shape)
-      {
-        out[0] = fg_color[0];
-        out[1] = fg_color[1];
-        out[2] = fg_color[2];
-        out[3] = 1.0;
-      }
-      else
-      {
-        if (o->transparent_background)
-        {
-          out[0] = 0.0;
-          out[1] = 0.0;
-          out[2] = 0.0;
-          out[3] = 0.0;
-        }
-        else
-        {
-          out[0] = bg_color[0];
-          out[1] = bg_color[1];
-          out[2] = bg_color[2];
-          out[3] = 1.0;
-        }
+        out[0] = color[0];
+        out[1] = color[1];
+        out[2] = color[2];
+        out[3] = color[3];
+        out += 4;
       }
-
-      gegl_buffer_set (output, GEGL_RECTANGLE (x, y, 1, 1), 0, babl_format ("RGBA float"), out, GEGL_AUTO_ROWSTRIDE);
     }
   }
 
@@ -325,6 +347,7 @@ gegl_op_class_init (GeglOpClass *klass)
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
   operation_class->prepare = prepare;
   operation_class->get_bounding_box = get_bounding_box;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
   operation_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
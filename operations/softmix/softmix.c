@@ -49,6 +49,7 @@ property_double (opacity, _("Opacity"), 1.0)
 #define GEGL_OP_C_SOURCE softmix.c
 
 #include "gegl-op.h"
+#include "lb-blend.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -134,8 +135,32 @@ process (GeglOperation       *op,
   /* Access the properties */
   gdouble intensity_factor = GEGL_PROPERTIES (op)->intensity_factor;
   gdouble opacity = GEGL_PROPERTIES (op)->opacity;
+  gfloat  opacity_f = opacity;
 
-  for (i = 0; i < n_pixels; i++)
+  /* Logistic function: 1 / (1 + exp(-k * (x - 1))) for smooth transition */
+  gfloat k = 10.0f * intensity_factor; /* Scale steepness with intensity_factor */
+
+  i = 0;
+  if (components == 4)
+    for (; i + LB_BLEND_BLOCK <= n_pixels; i += LB_BLEND_BLOCK)
+      {
+        gfloat blended[LB_BLEND_BLOCK * 4];
+
+        for (gint j = 0; j < LB_BLEND_BLOCK * 4; j++)
+          {
+            gfloat processed = lb_blend_logistic (k * (aux[j] + in[j] - 1.0f));
+
+            blended[j] = lb_blend_mix (in[j], processed, opacity_f);
+          }
+
+        lb_blend_store (in, blended, out);
+
+        in  += LB_BLEND_BLOCK * 4;
+        aux += LB_BLEND_BLOCK * 4;
+        out += LB_BLEND_BLOCK * 4;
+      }
+
+  for (; i < n_pixels; i++)
     {
       gfloat a_r = aux[0];  /* Source (aux) red */
       gfloat a_g = aux[1];  /* Source green */
@@ -150,8 +175,6 @@ process (GeglOperation       *op,
       gfloat sum_g = a_g + b_g;
       gfloat sum_b = a_b + b_b;
 
-      /* Logistic function: 1 / (1 + exp(-k * (x - 1))) for smooth transition */
-      gfloat k = 10.0f * intensity_factor; /* Scale steepness with intensity_factor */
       gfloat processed_r = 1.0f / (1.0f + expf(-k * (sum_r - 1.0f)));
       gfloat processed_g = 1.0f / (1.0f + expf(-k * (sum_g - 1.0f)));
       gfloat processed_b = 1.0f / (1.0f + expf(-k * (sum_b - 1.0f)));
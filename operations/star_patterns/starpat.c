@@ -21,6 +21,9 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-noise.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -82,91 +85,154 @@ property_color(bg_color, _("Background Color"), "#ac62ff")
 property_boolean(transparent_bg, _("Transparent Background"), FALSE)
     description(_("Enable to make the background transparent"))
 
+property_boolean(antialias, _("Antialiasing"), FALSE)
+    description(_("Smooth the star edges using their distance to each pixel"))
+
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     starpat
 #define GEGL_OP_C_SOURCE starpat.c
 
 #include "gegl-op.h"
 
-// Simple hash function for pseudo-random numbers
-static guint32
-hash_position(gint x, gint y)
-{
-  return (x * 131 + y * 151) ^ (x + y);
-}
-
 // Pseudo-random float between 0 and 1 based on position
 static gfloat
 random_float(gint x, gint y)
 {
-  return (hash_position(x, y) % 1000) / 1000.0f;
+  return lb_noise_hash_float(x, y, 0);
 }
 
-// Function to check if a point (px, py) is inside a star centered at (cx, cy)
-static gboolean
-point_in_star(gdouble px, gdouble py, gdouble cx, gdouble cy, gdouble size,
-              gint num_points, gdouble ratio, gdouble rotation)
+#define STAR_MAX_VERTICES 24  // 12 points alternating with 12 inner corners
+
+// Star outline of unit outer radius with its edges as precomputed line
+// equations, rebuilt by prepare() and shared read-only by all threads
+typedef struct
+{
+  gint   num_vertices;
+  gfloat cos_rot;
+  gfloat sin_rot;
+  gfloat x1[STAR_MAX_VERTICES];
+  gfloat y1[STAR_MAX_VERTICES];
+  gfloat y2[STAR_MAX_VERTICES];
+  gfloat dx[STAR_MAX_VERTICES];
+  gfloat dy[STAR_MAX_VERTICES];
+  gfloat inv_length_sq[STAR_MAX_VERTICES];
+  gfloat dx_over_dy[STAR_MAX_VERTICES];  // Inverse slope for the crossing test
+} StarTemplate;
+
+static StarTemplate *
+star_template_new(GeglProperties *o)
 {
-  // Translate the point relative to the star center
-  px -= cx;
-  py -= cy;
+  StarTemplate *star = g_new0(StarTemplate, 1);
+  gfloat vertices[STAR_MAX_VERTICES * 2];  // Packed x, y coordinates
+
+  // Map thickness (1 to 3) to inner/outer radius ratio
+  gdouble ratio;
+  switch (o->thickness)
+  {
+    case 1: ratio = 0.3; break;  // Thin
+    case 2: ratio = 0.5; break;  // Medium
+    case 3: ratio = 0.7; break;  // Thick
+    default: ratio = 0.5; break;
+  }
 
-  // Apply rotation
-  gdouble rot_rad = rotation * G_PI / 180.0;
-  gdouble temp_x = px * cos(rot_rad) + py * sin(rot_rad);
-  gdouble temp_y = -px * sin(rot_rad) + py * cos(rot_rad);
-  px = temp_x;
-  py = temp_y;
+  gdouble rot_rad = o->rotation * G_PI / 180.0;
+  star->cos_rot = cos(rot_rad);
+  star->sin_rot = sin(rot_rad);
 
   // Define the star as a polygon with alternating outer and inner vertices
-  gdouble outer_r = size;
-  gdouble inner_r = size * ratio;
-  gint num_vertices = 2 * num_points;  // Alternating outer and inner points
-  gdouble vertices[24][2];  // Array to store vertex coordinates (max 12 points = 24 vertices)
+  star->num_vertices = 2 * o->num_points;
+  for (gint i = 0; i < star->num_vertices; i++)
+  {
+    gdouble angle = (i * 2 * G_PI / star->num_vertices) - G_PI / 2;  // Start from top (subtract pi/2)
+    gdouble r = (i % 2 == 0) ? 1.0 : ratio;
+    vertices[i * 2] = r * cos(angle);      // x-coordinate
+    vertices[i * 2 + 1] = r * sin(angle);  // y-coordinate
+  }
 
-  // Compute the vertex positions
-  for (gint i = 0; i < num_vertices; i++)
+  for (gint i = 0, j = star->num_vertices - 1; i < star->num_vertices; j = i++)
   {
-    gdouble angle = (i * 2 * G_PI / num_vertices) - G_PI / 2;  // Start from top (subtract pi/2)
-    gdouble r = (i % 2 == 0) ? outer_r : inner_r;
-    vertices[i][0] = r * cos(angle);  // x-coordinate
-    vertices[i][1] = r * sin(angle);  // y-coordinate
+    gfloat dx = vertices[i * 2] - vertices[j * 2];
+    gfloat dy = vertices[i * 2 + 1] - vertices[j * 2 + 1];
+
+    star->x1[i] = vertices[j * 2];
+    star->y1[i] = vertices[j * 2 + 1];
+    star->y2[i] = vertices[i * 2 + 1];
+    star->dx[i] = dx;
+    star->dy[i] = dy;
+    star->inv_length_sq[i] = 1.0f / (dx * dx + dy * dy);
+    star->dx_over_dy[i] = dy != 0.0f ? dx / dy : 0.0f;
   }
 
-  // Use ray-casting algorithm to determine if the point is inside the polygon
+  return star;
+}
+
+// Signed distance from a point (px, py) to the outline of a star of the
+// given size centered at (cx, cy), negative inside the star
+static gfloat
+star_distance(const StarTemplate *star, gfloat px, gfloat py,
+              gfloat cx, gfloat cy, gfloat size)
+{
+  // Translate and scale the point into the unit star, then apply rotation
+  gfloat inv_size = 1.0f / size;
+  gfloat rel_x = (px - cx) * inv_size;
+  gfloat rel_y = (py - cy) * inv_size;
+  gfloat x = rel_x * star->cos_rot + rel_y * star->sin_rot;
+  gfloat y = -rel_x * star->sin_rot + rel_y * star->cos_rot;
+
+  // The star lies inside the unit circle, so a point more than a pixel
+  // outside it is uncovered and the circle distance is a safe lower bound
+  gfloat radius = sqrtf(x * x + y * y);
+  if (radius > 1.0f + inv_size)
+    return (radius - 1.0f) * size;
+
+  gfloat dist_sq = G_MAXFLOAT;
   gint crossings = 0;
-  for (gint i = 0; i < num_vertices; i++)
+
+  for (gint i = 0; i < star->num_vertices; i++)
   {
-    gint j = (i + 1) % num_vertices;  // Next vertex (wrap around)
-    gdouble x1 = vertices[i][0];
-    gdouble y1 = vertices[i][1];
-    gdouble x2 = vertices[j][0];
-    gdouble y2 = vertices[j][1];
-
-    // Check if the ray (from (px, py) to the right) intersects the edge
-    if (((y1 > py) != (y2 > py)) &&
-        (px < (x2 - x1) * (py - y1) / (y2 - y1) + x1))
-    {
-      crossings++;
-    }
+    gfloat ex = x - star->x1[i];
+    gfloat ey = y - star->y1[i];
+    gfloat t = CLAMP((ex * star->dx[i] + ey * star->dy[i]) * star->inv_length_sq[i], 0.0f, 1.0f);
+    gfloat qx = ex - t * star->dx[i];
+    gfloat qy = ey - t * star->dy[i];
+
+    dist_sq = MIN(dist_sq, qx * qx + qy * qy);
+
+    // Even-odd rule: count the edges crossed by a ray towards +x
+    crossings ^= ((star->y1[i] > y) != (star->y2[i] > y)) &
+                 (x < star->x1[i] + ey * star->dx_over_dy[i]);
   }
 
-  // Point is inside if the number of crossings is odd
-  return (crossings % 2 == 1);
+  gfloat dist = sqrtf(dist_sq) * size;
+  return crossings ? -dist : dist;
 }
 
 static void
 prepare(GeglOperation *operation)
 {
+  GeglProperties *o = GEGL_PROPERTIES(operation);
   const Babl *space = gegl_operation_get_source_space(operation, "input");
-  gegl_operation_set_format(operation, "input", babl_format_with_space("RGBA float", space));
-  gegl_operation_set_format(operation, "output", babl_format_with_space("RGBA float", space));
+  lb_generator_set_format(operation, babl_format_with_space("RGBA float", space));
+
+  g_free(o->user_data);
+  o->user_data = star_template_new(o);
+}
+
+static void
+finalize(GObject *object)
+{
+  GeglOperation *operation = (void *)object;
+  GeglProperties *o = GEGL_PROPERTIES(operation);
+
+  g_clear_pointer(&o->user_data, g_free);
+
+  G_OBJECT_CLASS(gegl_op_parent_class)->finalize(object);
 }
 
 static gboolean
-process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
+render(GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   gfloat star_rgb[3], bg_rgb[3];
@@ -177,15 +243,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
   gfloat base_size = o->size * o->zoom;  // Base size adjusted by zoom
   gfloat spacing = base_size * 3.0;      // Base spacing between stars
 
-  // Map thickness (1 to 3) to inner/outer radius ratio
-  gdouble ratio;
-  switch (o->thickness)
-  {
-    case 1: ratio = 0.3; break;  // Thin
-    case 2: ratio = 0.5; break;  // Medium
-    case 3: ratio = 0.7; break;  // Thick
-    default: ratio = 0.5; break;
-  }
+  const StarTemplate *star = o->user_data;
 
   // Cast out_buf to a float array for direct pixel manipulation
   gfloat *out_data = (gfloat *) out_buf;
@@ -196,9 +254,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
     {
       // Calculate the index into out_buf
       gint idx = ((y - roi->y) * roi->width + (x - roi->x)) * 4;
-      gfloat min_distance = G_MAXFLOAT;
-      gfloat current_size = base_size;
-      gboolean is_inside = FALSE;
+      gfloat sd = G_MAXFLOAT;
 
       // Apply panning
       gfloat px = x - o->pan_x;
@@ -216,15 +272,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
             {
               gfloat center_x = grid_x + c * spacing + o->pan_x;
               gfloat center_y = grid_y + r * spacing + o->pan_y;
-              gfloat dx = x - center_x;
-              gfloat dy = y - center_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, center_x, center_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, center_x, center_y, base_size));
             }
           }
           break;
@@ -241,15 +289,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_y = (row + r) * row_height + spacing / 2 + o->pan_y;
               gfloat grid_x = (col + c) * spacing + spacing / 2 + o->pan_x;
               if ((gint)(row + r) % 2 == 1) grid_x += spacing / 2;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, base_size));
             }
           }
           break;
@@ -266,15 +306,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_y = (row + r) * row_height + spacing / 2 + o->pan_y;
               gfloat grid_x = (col + c) * spacing + spacing / 2 + o->pan_x;
               if ((gint)(row + r) % 2 == 1) grid_x += spacing / 2;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, base_size));
             }
           }
           break;
@@ -294,15 +326,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_diag_y = (row + r) * diag_spacing;
               gfloat grid_x = (grid_diag_x + grid_diag_y) / 2 + o->pan_x;
               gfloat grid_y = (grid_diag_x - grid_diag_y) / 2 + o->pan_y;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, base_size));
             }
           }
           break;
@@ -321,15 +345,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat offset_y = (random_float(base_y, base_x) - 0.5f) * spacing;
               gfloat grid_x = base_x + spacing / 2 + offset_x + o->pan_x;
               gfloat grid_y = base_y + spacing / 2 + offset_y + o->pan_y;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, base_size));
             }
           }
           break;
@@ -344,15 +360,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
             {
               gfloat center_x = grid_x + c * spacing + sin((grid_y + r * spacing) * 0.05f) * spacing / 2 + o->pan_x;
               gfloat center_y = grid_y + r * spacing + sin((grid_x + c * spacing) * 0.05f) * spacing / 2 + o->pan_y;
-              gfloat dx = x - center_x;
-              gfloat dy = y - center_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, center_x, center_y, base_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = base_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, center_x, center_y, base_size));
             }
           }
           break;
@@ -372,15 +380,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_x = base_x + spacing / 2 + offset_x + o->pan_x;
               gfloat grid_y = base_y + spacing / 2 + offset_y + o->pan_y;
               gfloat star_size = random_float(base_x + base_y, base_x) < 0.5f ? base_size : base_size * 0.5f;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, star_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = star_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, star_size));
             }
           }
           break;
@@ -404,15 +404,7 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               if (rand < 0.33f) star_size = base_size;
               else if (rand < 0.66f) star_size = base_size * 0.75f;
               else star_size = base_size * 0.5f;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, star_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = star_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, star_size));
             }
           }
           break;
@@ -430,59 +422,58 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
               gfloat grid_x = (col + c) * spacing + spacing / 2 + o->pan_x;
               gfloat star_size = (gint)(col + c) % 2 == 0 ? base_size : base_size * 0.5f;
               if ((gint)(row + r) % 2 == 1) star_size = base_size * 0.75f;
-              gfloat dx = x - grid_x;
-              gfloat dy = y - grid_y;
-              gfloat distance = sqrt(dx * dx + dy * dy);
-              if (distance < min_distance && point_in_star(x, y, grid_x, grid_y, star_size, o->num_points, ratio, o->rotation))
-              {
-                min_distance = distance;
-                current_size = star_size;
-                is_inside = TRUE;
-              }
+              sd = lb_sd_union(sd, star_distance(star, x, y, grid_x, grid_y, star_size));
             }
           }
           break;
         }
       }
 
-      if (is_inside)
+      gfloat *pixel = out_data + idx;
+
+      if (o->transparent_bg)
       {
-        out_data[idx + 0] = star_rgb[0];
-        out_data[idx + 1] = star_rgb[1];
-        out_data[idx + 2] = star_rgb[2];
-        out_data[idx + 3] = 1.0f;
+        pixel[0] = 0.0f;
+        pixel[1] = 0.0f;
+        pixel[2] = 0.0f;
+        pixel[3] = 0.0f;  // Fully transparent background
       }
       else
       {
-        if (o->transparent_bg)
-        {
-          out_data[idx + 0] = 0.0f;
-          out_data[idx + 1] = 0.0f;
-          out_data[idx + 2] = 0.0f;
-          out_data[idx + 3] = 0.0f;  // Fully transparent background
-        }
-        else
-        {
-          out_data[idx + 0] = bg_rgb[0];
-          out_data[idx + 1] = bg_rgb[1];
-          out_data[idx + 2] = bg_rgb[2];
-          out_data[idx + 3] = 1.0f;  // Opaque background color
-        }
+        pixel[0] = bg_rgb[0];
+        pixel[1] = bg_rgb[1];
+        pixel[2] = bg_rgb[2];
+        pixel[3] = 1.0f;  // Opaque background color
       }
+
+      lb_coverage_over(pixel, star_rgb, lb_coverage(sd, o->antialias));
     }
   }
 
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
+  G_OBJECT_CLASS(klass)->finalize = finalize;
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
       "name",        "ai/lb:star-patterns",
@@ -3,6 +3,7 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -67,11 +68,6 @@ property_double(size_2, _("Shape Size 2"), 1.0)
     description(_("Thickness of the secondary color outline"))
     value_range(1.0, 7.0)
 
-property_double(line_size_3, _("Line Size 3"), 1.0)
-    description(_("Thickness of the tertiary color region"))
-    value_range(0.1, 5.0)
-  ui_meta     ("role", "output-extent")
-
 property_double(rotation, _("Rotation"), 0.0)
     description(_("Rotation angle of the pattern in degrees"))
     value_range(0.0, 360.0)
@@ -86,7 +82,7 @@ property_double(y_offset, _("Y Offset"), 0.0)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     tricolorpattern
 #define GEGL_OP_C_SOURCE tricolorpattern.c
 
@@ -95,305 +91,541 @@ property_double(y_offset, _("Y Offset"), 0.0)
 static void
 prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
+}
+
+typedef struct
+{
+  gfloat nx, ny;           /* pattern space position of the row's first pixel */
+  gfloat step_x, step_y;   /* pattern space step per output pixel */
+  gfloat scale;
+  gint   width;
+} PatternRow;
+
+typedef void (* PatternRowFunc) (const PatternRow *row,
+                                 gfloat           *values);
+
+/* fmodf () as a truncated division, which unlike libm's fmodf () is
+ * inlined into the row loops */
+static inline gfloat
+pattern_fmod (gfloat a,
+              gfloat b)
+{
+  return a - b * truncf (a / b);
+}
+
+static inline gfloat
+pattern_grid (gfloat nx,
+              gfloat ny,
+              gfloat scale)
+{
+  return sinf (nx / (20.0f * scale)) * cosf (ny / (20.0f * scale));
+}
+
+static inline gfloat
+pattern_diamond_grid (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  return sinf (nx / (10.0f * scale)) + sinf (ny / (10.0f * scale));
+}
+
+static inline gfloat
+pattern_spiral (gfloat nx,
+                gfloat ny,
+                gfloat scale)
+{
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+  gfloat theta = atan2f (ny, nx);
+
+  return sinf (r + theta);
+}
+
+static inline gfloat
+pattern_eye_mosaic (gfloat nx,
+                    gfloat ny,
+                    gfloat scale)
+{
+  gfloat px = nx / (30.0f * scale);
+  gfloat py = ny / (30.0f * scale);
+
+  return sinf (px * (gfloat) G_PI) + cosf (py * (gfloat) G_PI * sqrtf (3.0f));
+}
+
+static inline gfloat
+pattern_baroque_curls (gfloat nx,
+                       gfloat ny,
+                       gfloat scale)
+{
+  return sinf (nx / (20.0f * scale) + sinf (ny / (20.0f * scale))) * cosf (ny / (20.0f * scale));
+}
+
+static inline gfloat
+pattern_floral_motifs (gfloat nx,
+                       gfloat ny,
+                       gfloat scale)
+{
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+  gfloat theta = atan2f (ny, nx);
+
+  return sinf (5.0f * theta) * cosf (r);
+}
+
+static inline gfloat
+pattern_marble_veins (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  return sinf (nx / (20.0f * scale) + 2.0f * sinf (ny / (20.0f * scale)));
+}
+
+static inline gfloat
+pattern_circle_grid (gfloat nx,
+                     gfloat ny,
+                     gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (20.0f * scale), 1.0f);
+  gfloat py = pattern_fmod (ny / (20.0f * scale), 1.0f);
+
+  return cosf ((gfloat) G_PI * sqrtf ((px - 0.5f) * (px - 0.5f) + (py - 0.5f) * (py - 0.5f)));
+}
+
+static inline gfloat
+pattern_oval_waves (gfloat nx,
+                    gfloat ny,
+                    gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale) + sinf (nx / (20.0f * scale));
+
+  return cosf ((gfloat) G_PI * sqrtf (px * px + 0.5f * py * py));
+}
+
+static inline gfloat
+pattern_pebble_grid (gfloat nx,
+                     gfloat ny,
+                     gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale) * sqrtf (3.0f) / 2.0f;
+
+  return sinf (px * (gfloat) G_PI) * cosf (py * (gfloat) G_PI);
+}
+
+static inline gfloat
+pattern_concentric_circles (gfloat nx,
+                            gfloat ny,
+                            gfloat scale)
+{
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+
+  return sinf (r * (gfloat) G_PI);
+}
+
+static inline gfloat
+pattern_triangle_spiral (gfloat nx,
+                         gfloat ny,
+                         gfloat scale)
+{
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+  gfloat theta = atan2f (ny, nx);
+
+  return sinf (r + 3.0f * theta);
+}
+
+static inline gfloat
+pattern_arc_waves (gfloat nx,
+                   gfloat ny,
+                   gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale);
+
+  return sinf (px + cosf (py * (gfloat) G_PI));
+}
+
+static inline gfloat
+pattern_square_tiles (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (15.0f * scale), 1.0f);
+  gfloat py = pattern_fmod (ny / (15.0f * scale), 1.0f);
+
+  return cosf ((gfloat) G_PI * (fabsf(px - 0.5f) + fabsf(py - 0.5f)));
+}
+
+static inline gfloat
+pattern_blinds (gfloat nx,
+                gfloat ny,
+                gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = nx / (20.0f * scale);
+
+  return sinf (px + sinf (py * 2.0f));
+}
+
+static inline gfloat
+pattern_stitch_lines (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (15.0f * scale), 1.0f);
+  gfloat py = ny / (15.0f * scale);
+
+  return px < 0.3f ? cosf ((gfloat) G_PI * py) : 0.0f;
 }
 
+static inline gfloat
+pattern_cross_stitches (gfloat nx,
+                        gfloat ny,
+                        gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (15.0f * scale), 1.0f);
+  gfloat py = pattern_fmod (ny / (15.0f * scale), 1.0f);
+
+  return (fabsf(px - py) < 0.2f || fabsf(px + py - 1.0f) < 0.2f) ? cosf ((gfloat) G_PI * px) : 0.0f;
+}
+
+static inline gfloat
+pattern_stitch_weave (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat px = nx / (15.0f * scale);
+  gfloat py = ny / (15.0f * scale);
+
+  return (fabsf(px - floorf(px) - 0.5f) < 0.2f || fabsf(py - floorf(py) - 0.5f) < 0.2f) ? cosf ((gfloat) G_PI * px) : 0.0f;
+}
+
+static inline gfloat
+pattern_stitch_mosaic (gfloat nx,
+                       gfloat ny,
+                       gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (15.0f * scale), 1.0f);
+  gfloat py = pattern_fmod (ny / (15.0f * scale), 1.0f);
+
+  return (px < 0.3f || py < 0.3f) ? cosf ((gfloat) G_PI * (px + py)) : 0.0f;
+}
+
+static inline gfloat
+pattern_three_color_stripes (gfloat nx,
+                             gfloat ny,
+                             gfloat scale)
+{
+  gfloat px = nx / (15.0f * scale);
+  gfloat py = ny / (15.0f * scale);
+
+  return cosf ((gfloat) G_PI * fabsf(pattern_fmod (px - py, 2.0f) - 1.0f));
+}
+
+static inline gfloat
+pattern_long_pebble_grid (gfloat nx,
+                          gfloat ny,
+                          gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale) * sqrtf (3.0f);
+
+  return cosf ((gfloat) G_PI * (px + py)) + cosf ((gfloat) G_PI * (px - py));
+}
+
+static inline gfloat
+pattern_cube_grid (gfloat nx,
+                   gfloat ny,
+                   gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale);
+
+  return cosf ((gfloat) G_PI * (fabsf(px - py) + fabsf(px + py)));
+}
+
+static inline gfloat
+pattern_radial_lines (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat theta = atan2f (ny, nx);
+
+  return cosf (10.0f * theta);
+}
+
+static inline gfloat
+pattern_radial_burst (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat theta = atan2f (ny, nx);
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+
+  return cosf (12.0f * theta + floorf(r));
+}
+
+static inline gfloat
+pattern_organic_grid (gfloat nx,
+                      gfloat ny,
+                      gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale) + 0.2f * cosf (ny / (20.0f * scale));
+  gfloat py = ny / (20.0f * scale) + 0.2f * cosf (nx / (20.0f * scale));
+
+  return cosf ((gfloat) G_PI * (fabsf(px - floorf(px)) + fabsf(py - floorf(py))));
+}
+
+static inline gfloat
+pattern_psychedelic_swirls (gfloat nx,
+                            gfloat ny,
+                            gfloat scale)
+{
+  gfloat r = sqrtf (nx * nx + ny * ny) / (20.0f * scale);
+  gfloat theta = atan2f (ny, nx);
+
+  return cosf ((gfloat) G_PI * (r + 2.0f * theta));
+}
+
+static inline gfloat
+pattern_ornamental_lattice (gfloat nx,
+                            gfloat ny,
+                            gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale);
+
+  return cosf ((gfloat) G_PI * (cosf(px) + cosf(py)));
+}
+
+static inline gfloat
+pattern_circuit_traces (gfloat nx,
+                        gfloat ny,
+                        gfloat scale)
+{
+  gfloat px = nx / (15.0f * scale);
+  gfloat py = ny / (15.0f * scale);
+
+  return cosf ((gfloat) G_PI * (fabsf(px - floorf(px)) + fabsf(py - floorf(py + 0.5f))));
+}
+
+static inline gfloat
+pattern_crystal_facets (gfloat nx,
+                        gfloat ny,
+                        gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale);
+
+  return cosf ((gfloat) G_PI * (fabsf(px - py) * fabsf(px + py)));
+}
+
+static inline gfloat
+pattern_organic_shards (gfloat nx,
+                        gfloat ny,
+                        gfloat scale)
+{
+  gfloat px = nx / (25.0f * scale);
+  gfloat py = ny / (25.0f * scale);
+
+  return cosf ((gfloat) G_PI * (px + 0.5f * cosf(py * 1.5f)) + cosf (py + 0.5f * cosf(px * 1.5f)));
+}
+
+static inline gfloat
+pattern_chaos_webs (gfloat nx,
+                    gfloat ny,
+                    gfloat scale)
+{
+  gfloat px = nx / (20.0f * scale);
+  gfloat py = ny / (20.0f * scale);
+
+  return cosf ((gfloat) G_PI * (cosf(px + 0.3f * cosf(py)) + cosf(py + 0.3f * cosf(px))));
+}
+
+static inline gfloat
+pattern_nebula_clouds (gfloat nx,
+                       gfloat ny,
+                       gfloat scale)
+{
+  gfloat px = nx / (25.0f * scale);
+  gfloat py = ny / (25.0f * scale);
+
+  return cosf ((gfloat) G_PI * (px * cosf(py * 0.5f) + py * cosf(px * 0.5f)));
+}
+
+static inline gfloat
+pattern_oval_grid (gfloat nx,
+                   gfloat ny,
+                   gfloat scale)
+{
+  gfloat px = pattern_fmod (nx / (20.0f * scale), 1.0f);
+  gfloat py = pattern_fmod (ny / (20.0f * scale), 1.0f);
+
+  return cosf ((gfloat) G_PI * sqrtf((px - 0.5f) * (px - 0.5f) + (py - 0.5f) * (py - 0.5f) + 0.2f * cosf(2.0f * (gfloat) G_PI * px)));
+}
+
+/* PATTERN_ROW (pattern) defines pattern_row (), the pattern values of one
+ * row of pixels with the pattern inlined into its own loop */
+#define PATTERN_ROW(pattern)                                              \
+static void                                                               \
+pattern##_row (const PatternRow *row,                                     \
+               gfloat           *values)                                  \
+{                                                                         \
+  const PatternRow r = *row;                                              \
+  gint             i;                                                     \
+                                                                          \
+  for (i = 0; i < r.width; i++)                                           \
+    values[i] = pattern (r.nx + i * r.step_x, r.ny + i * r.step_y, r.scale); \
+}
+
+PATTERN_ROW (pattern_grid)
+PATTERN_ROW (pattern_diamond_grid)
+PATTERN_ROW (pattern_spiral)
+PATTERN_ROW (pattern_eye_mosaic)
+PATTERN_ROW (pattern_baroque_curls)
+PATTERN_ROW (pattern_floral_motifs)
+PATTERN_ROW (pattern_marble_veins)
+PATTERN_ROW (pattern_circle_grid)
+PATTERN_ROW (pattern_oval_waves)
+PATTERN_ROW (pattern_pebble_grid)
+PATTERN_ROW (pattern_concentric_circles)
+PATTERN_ROW (pattern_triangle_spiral)
+PATTERN_ROW (pattern_arc_waves)
+PATTERN_ROW (pattern_square_tiles)
+PATTERN_ROW (pattern_blinds)
+PATTERN_ROW (pattern_stitch_lines)
+PATTERN_ROW (pattern_cross_stitches)
+PATTERN_ROW (pattern_stitch_weave)
+PATTERN_ROW (pattern_stitch_mosaic)
+PATTERN_ROW (pattern_three_color_stripes)
+PATTERN_ROW (pattern_long_pebble_grid)
+PATTERN_ROW (pattern_cube_grid)
+PATTERN_ROW (pattern_radial_lines)
+PATTERN_ROW (pattern_radial_burst)
+PATTERN_ROW (pattern_organic_grid)
+PATTERN_ROW (pattern_psychedelic_swirls)
+PATTERN_ROW (pattern_ornamental_lattice)
+PATTERN_ROW (pattern_circuit_traces)
+PATTERN_ROW (pattern_crystal_facets)
+PATTERN_ROW (pattern_organic_shards)
+PATTERN_ROW (pattern_chaos_webs)
+PATTERN_ROW (pattern_nebula_clouds)
+PATTERN_ROW (pattern_oval_grid)
+
+static const PatternRowFunc pattern_rows[] =
+{
+  [PATTERN_GRID]                = pattern_grid_row,
+  [PATTERN_DIAMOND_GRID]        = pattern_diamond_grid_row,
+  [PATTERN_SPIRAL]              = pattern_spiral_row,
+  [PATTERN_EYE_MOSAIC]          = pattern_eye_mosaic_row,
+  [PATTERN_BAROQUE_CURLS]       = pattern_baroque_curls_row,
+  [PATTERN_FLORAL_MOTIFS]       = pattern_floral_motifs_row,
+  [PATTERN_MARBLE_VEINS]        = pattern_marble_veins_row,
+  [PATTERN_CIRCLE_GRID]         = pattern_circle_grid_row,
+  [PATTERN_OVAL_WAVES]          = pattern_oval_waves_row,
+  [PATTERN_PEBBLE_GRID]         = pattern_pebble_grid_row,
+  [PATTERN_CONCENTRIC_CIRCLES]  = pattern_concentric_circles_row,
+  [PATTERN_TRIANGLE_SPIRAL]     = pattern_triangle_spiral_row,
+  [PATTERN_ARC_WAVES]           = pattern_arc_waves_row,
+  [PATTERN_SQUARE_TILES]        = pattern_square_tiles_row,
+  [PATTERN_BLINDS]              = pattern_blinds_row,
+  [PATTERN_STITCH_LINES]        = pattern_stitch_lines_row,
+  [PATTERN_CROSS_STITCHES]      = pattern_cross_stitches_row,
+  [PATTERN_STITCH_WEAVE]        = pattern_stitch_weave_row,
+  [PATTERN_STITCH_MOSAIC]       = pattern_stitch_mosaic_row,
+  [PATTERN_THREE_COLOR_STRIPES] = pattern_three_color_stripes_row,
+  [PATTERN_LONG_PEBBLE_GRID]    = pattern_long_pebble_grid_row,
+  [PATTERN_CUBE_GRID]           = pattern_cube_grid_row,
+  [PATTERN_RADIAL_LINES]        = pattern_radial_lines_row,
+  [PATTERN_RADIAL_BURST]        = pattern_radial_burst_row,
+  [PATTERN_ORGANIC_GRID]        = pattern_organic_grid_row,
+  [PATTERN_PSYCHEDELIC_SWIRLS]  = pattern_psychedelic_swirls_row,
+  [PATTERN_ORNAMENTAL_LATTICE]  = pattern_ornamental_lattice_row,
+  [PATTERN_CIRCUIT_TRACES]      = pattern_circuit_traces_row,
+  [PATTERN_CRYSTAL_FACETS]      = pattern_crystal_facets_row,
+  [PATTERN_ORGANIC_SHARDS]      = pattern_organic_shards_row,
+  [PATTERN_CHAOS_WEBS]          = pattern_chaos_webs_row,
+  [PATTERN_NEBULA_CLOUDS]       = pattern_nebula_clouds_row,
+  [PATTERN_OVAL_GRID]           = pattern_oval_grid_row,
+};
+
 static gboolean
-process (GeglOperation *operation,
-         void *in_buf,
-         void *out_buf,
-         glong samples,
-         const GeglRectangle *roi,
-         gint level)
+render (GeglOperation *operation,
+        void *out_buf,
+        glong samples,
+        const GeglRectangle *roi,
+        gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out = out_buf;
   gdouble r1, g1, b1, r2, g2, b2, r3, g3, b3;
   gdouble rad = o->rotation * G_PI / 180.0;
-  gdouble scale = o->scale;
-  gdouble outline_scale_1 = o->size_1;
-  gdouble outline_scale_2 = o->size_2;
-  gdouble outline_scale_3 = o->line_size_3;
+  gdouble cos_rad = cos (rad);
+  gdouble sin_rad = sin (rad);
+  gfloat threshold_1 = 0.33 / o->size_1;
+  gfloat threshold_2 = -0.33 / o->size_2;
+  PatternRowFunc pattern_row = pattern_rows[o->pattern];
+  PatternRow row;
+  gfloat *values;
 
   gegl_color_get_rgba (o->color1, &r1, &g1, &b1, NULL);
   gegl_color_get_rgba (o->color2, &r2, &g2, &b2, NULL);
   gegl_color_get_rgba (o->color3, &r3, &g3, &b3, NULL);
 
+  const gfloat colors[3][4] = { { r1, g1, b1, 1.0 },
+                                { r2, g2, b2, 1.0 },
+                                { r3, g3, b3, 1.0 } };
+
+  /* Rotated coordinates move by a fixed step along a row */
+  row.step_x = cos_rad;
+  row.step_y = sin_rad;
+  row.scale = o->scale;
+  row.width = roi->width;
+
+  values = g_new (gfloat, roi->width);
+
   for (gint y = roi->y; y < roi->y + roi->height; y++)
     {
-      for (gint x = roi->x; x < roi->x + roi->width; x++)
+      row.nx = roi->x * cos_rad - y * sin_rad - o->x_offset;
+      row.ny = roi->x * sin_rad + y * cos_rad - o->y_offset;
+
+      pattern_row (&row, values);
+
+      for (gint i = 0; i < roi->width; i++)
         {
-          gdouble nx = x * cos (rad) - y * sin (rad) - o->x_offset;
-          gdouble ny = x * sin (rad) + y * cos (rad) - o->y_offset;
-          gdouble val = 0.0;
-          gint index = ((y - roi->y) * roi->width + (x - roi->x)) * 4;
-
-          switch (o->pattern)
-            {
-            case PATTERN_GRID:
-              val = sin (nx / (20.0 * scale)) * cos (ny / (20.0 * scale));
-              break;
-            case PATTERN_DIAMOND_GRID:
-              val = sin (nx / (10.0 * scale)) + sin (ny / (10.0 * scale));
-              break;
-            case PATTERN_SPIRAL:
-              {
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                gdouble theta = atan2 (ny, nx);
-                val = sin (r + theta);
-              }
-              break;
-            case PATTERN_EYE_MOSAIC:
-              {
-                gdouble px = nx / (30.0 * scale);
-                gdouble py = ny / (30.0 * scale);
-                val = sin (px * G_PI) + cos (py * G_PI * sqrt (3.0));
-              }
-              break;
-            case PATTERN_BAROQUE_CURLS:
-              val = sin (nx / (20.0 * scale) + sin (ny / (20.0 * scale))) * cos (ny / (20.0 * scale));
-              break;
-            case PATTERN_FLORAL_MOTIFS:
-              {
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                gdouble theta = atan2 (ny, nx);
-                val = sin (5.0 * theta) * cos (r);
-              }
-              break;
-            case PATTERN_MARBLE_VEINS:
-              val = sin (nx / (20.0 * scale) + 2.0 * sin (ny / (20.0 * scale)));
-              break;
-            case PATTERN_CIRCLE_GRID:
-              {
-                gdouble px = fmod (nx / (20.0 * scale), 1.0);
-                gdouble py = fmod (ny / (20.0 * scale), 1.0);
-                val = cos (G_PI * sqrt ((px - 0.5) * (px - 0.5) + (py - 0.5) * (py - 0.5)));
-              }
-              break;
-            case PATTERN_OVAL_WAVES:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale) + sin (nx / (20.0 * scale));
-                val = cos (G_PI * sqrt (px * px + 0.5 * py * py));
-              }
-              break;
-            case PATTERN_PEBBLE_GRID:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale) * sqrt (3.0) / 2.0;
-                val = sin (px * G_PI) * cos (py * G_PI);
-              }
-              break;
-            case PATTERN_CONCENTRIC_CIRCLES:
-              {
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                val = sin (r * G_PI);
-              }
-              break;
-            case PATTERN_TRIANGLE_SPIRAL:
-              {
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                gdouble theta = atan2 (ny, nx);
-                val = sin (r + 3.0 * theta);
-              }
-              break;
-            case PATTERN_ARC_WAVES:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale);
-                val = sin (px + cos (py * G_PI));
-              }
-              break;
-            case PATTERN_SQUARE_TILES:
-              {
-                gdouble px = fmod (nx / (15.0 * scale), 1.0);
-                gdouble py = fmod (ny / (15.0 * scale), 1.0);
-                val = cos (G_PI * (fabs(px - 0.5) + fabs(py - 0.5)));
-              }
-              break;
-            case PATTERN_BLINDS:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = nx / (20.0 * scale);
-                val = sin (px + sin (py * 2.0));
-              }
-              break;
-            case PATTERN_STITCH_LINES:
-              {
-                gdouble px = fmod (nx / (15.0 * scale), 1.0);
-                gdouble py = ny / (15.0 * scale);
-                val = px < 0.3 ? cos (G_PI * py) : 0.0;
-              }
-              break;
-            case PATTERN_CROSS_STITCHES:
-              {
-                gdouble px = fmod (nx / (15.0 * scale), 1.0);
-                gdouble py = fmod (ny / (15.0 * scale), 1.0);
-                val = (fabs(px - py) < 0.2 || fabs(px + py - 1.0) < 0.2) ? cos (G_PI * px) : 0.0;
-              }
-              break;
-            case PATTERN_STITCH_WEAVE:
-              {
-                gdouble px = nx / (15.0 * scale);
-                gdouble py = ny / (15.0 * scale);
-                val = (fabs(px - floor(px) - 0.5) < 0.2 || fabs(py - floor(py) - 0.5) < 0.2) ? cos (G_PI * px) : 0.0;
-              }
-              break;
-            case PATTERN_STITCH_MOSAIC:
-              {
-                gdouble px = fmod (nx / (15.0 * scale), 1.0);
-                gdouble py = fmod (ny / (15.0 * scale), 1.0);
-                val = (px < 0.3 || py < 0.3) ? cos (G_PI * (px + py)) : 0.0;
-              }
-              break;
-            case PATTERN_THREE_COLOR_STRIPES:
-              {
-                gdouble px = nx / (15.0 * scale);
-                gdouble py = ny / (15.0 * scale);
-                val = cos (G_PI * fabs(fmod(px - py, 2.0) - 1.0));
-              }
-              break;
-            case PATTERN_LONG_PEBBLE_GRID:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale) * sqrt (3.0);
-                val = cos (G_PI * (px + py)) + cos (G_PI * (px - py));
-              }
-              break;
-            case PATTERN_CUBE_GRID:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale);
-                val = cos (G_PI * (fabs(px - py) + fabs(px + py)));
-              }
-              break;
-            case PATTERN_RADIAL_LINES:
-              {
-                gdouble theta = atan2 (ny, nx);
-                val = cos (10.0 * theta);
-              }
-              break;
-            case PATTERN_RADIAL_BURST:
-              {
-                gdouble theta = atan2 (ny, nx);
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                val = cos (12.0 * theta + floor(r));
-              }
-              break;
-            case PATTERN_ORGANIC_GRID:
-              {
-                gdouble px = nx / (20.0 * scale) + 0.2 * cos (ny / (20.0 * scale));
-                gdouble py = ny / (20.0 * scale) + 0.2 * cos (nx / (20.0 * scale));
-                val = cos (G_PI * (fabs(px - floor(px)) + fabs(py - floor(py))));
-              }
-              break;
-            case PATTERN_PSYCHEDELIC_SWIRLS:
-              {
-                gdouble r = sqrt (nx * nx + ny * ny) / (20.0 * scale);
-                gdouble theta = atan2 (ny, nx);
-                val = cos (G_PI * (r + 2.0 * theta));
-              }
-              break;
-            case PATTERN_ORNAMENTAL_LATTICE:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale);
-                val = cos (G_PI * (cos(px) + cos(py)));
-              }
-              break;
-            case PATTERN_CIRCUIT_TRACES:
-              {
-                gdouble px = nx / (15.0 * scale);
-                gdouble py = ny / (15.0 * scale);
-                val = cos (G_PI * (fabs(px - floor(px)) + fabs(py - floor(py + 0.5))));
-              }
-              break;
-            case PATTERN_CRYSTAL_FACETS:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale);
-                val = cos (G_PI * (fabs(px - py) * fabs(px + py)));
-              }
-              break;
-            case PATTERN_ORGANIC_SHARDS:
-              {
-                gdouble px = nx / (25.0 * scale);
-                gdouble py = ny / (25.0 * scale);
-                val = cos (G_PI * (px + 0.5 * cos(py * 1.5)) + cos (py + 0.5 * cos(px * 1.5)));
-              }
-              break;
-            case PATTERN_CHAOS_WEBS:
-              {
-                gdouble px = nx / (20.0 * scale);
-                gdouble py = ny / (20.0 * scale);
-                val = cos (G_PI * (cos(px + 0.3 * cos(py)) + cos(py + 0.3 * cos(px))));
-              }
-              break;
-            case PATTERN_NEBULA_CLOUDS:
-              {
-                gdouble px = nx / (25.0 * scale);
-                gdouble py = ny / (25.0 * scale);
-                val = cos (G_PI * (px * cos(py * 0.5) + py * cos(px * 0.5)));
-              }
-              break;
-            case PATTERN_OVAL_GRID:
-              {
-                gdouble px = fmod (nx / (20.0 * scale), 1.0);
-                gdouble py = fmod (ny / (20.0 * scale), 1.0);
-                val = cos (G_PI * sqrt((px - 0.5) * (px - 0.5) + (py - 0.5) * (py - 0.5) + 0.2 * cos(2.0 * G_PI * px)));
-              }
-              break;
-            default:
-              val = 0.0;
-            }
-
-          gdouble threshold_1 = 0.33 / outline_scale_1;
-          gdouble threshold_2 = -0.33 / outline_scale_2;
-          gdouble threshold_3 = -0.33 / outline_scale_3;
-
-          if (val > threshold_1)
-            {
-              out[index] = r1;
-              out[index + 1] = g1;
-              out[index + 2] = b1;
-              out[index + 3] = 1.0;
-            }
-          else if (val > threshold_2)
-            {
-              out[index] = r2;
-              out[index + 1] = g2;
-              out[index + 2] = b2;
-              out[index + 3] = 1.0;
-            }
-          else if (val <= threshold_3)
-            {
-              out[index] = r3;
-              out[index + 1] = g3;
-              out[index + 2] = b3;
-              out[index + 3] = 1.0;
-            }
-          else
-            {
-              out[index] = r3;
-              out[index + 1] = g3;
-              out[index + 2] = b3;
-              out[index + 3] = 1.0;
-            }
+          const gfloat *color = values[i] > threshold_1 ? colors[0] :
+                                values[i] > threshold_2 ? colors[1] :
+                                                          colors[2];
+
+          memcpy (out, color, 4 * sizeof (gfloat));
+          out += 4;
         }
     }
 
+  g_free (values);
+
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
       "name",        "ai/lb:tri-pattern-collection",
@@ -22,6 +22,8 @@
 #include <gegl.h>
 #include <gegl-plugin.h>
 #include <math.h>
+#include "lb-coverage.h"
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -65,9 +67,12 @@ property_color (color2, _("Foreground Color"), "white")
 property_boolean (transparent_background, _("Transparent Background"), FALSE)
     description (_("Make the background transparent instead of using the background color"))
 
+property_boolean (antialias, _("Antialiasing"), FALSE)
+    description (_("Smooth the pattern edges using their distance to each pixel"))
+
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     truchettiles
 #define GEGL_OP_C_SOURCE truchettiles.c
 
@@ -75,57 +80,47 @@ property_boolean (transparent_background, _("Transparent Background"), FALSE)
 
 static void prepare (GeglOperation *operation)
 {
-  gegl_operation_set_format (operation, "input", babl_format ("RGBA float"));
-  gegl_operation_set_format (operation, "output", babl_format ("RGBA float"));
+  lb_generator_set_format (operation, babl_format ("RGBA float"));
 }
 
 static void draw_arc(gfloat *out, const gfloat *color,
                     gfloat x, gfloat y, gfloat size,
-                    gint quadrant, gfloat thickness)
+                    gint quadrant, gfloat thickness, gboolean antialias)
 {
   gfloat center_x = (quadrant % 2) ? size : 0;
   gfloat center_y = (quadrant > 1) ? size : 0;
   gfloat dx = x - center_x;
   gfloat dy = y - center_y;
   gfloat dist = hypotf(dx, dy);
-  
-  if (fabs(dist - size/2) < thickness/2) {
-    memcpy(out, color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-  }
+  gfloat coverage = lb_coverage_less(fabs(dist - size/2), thickness/2, antialias);
+
+  lb_coverage_mix(out, color, coverage);
 }
 
 static void draw_dot(gfloat *out, const gfloat *color,
                      gfloat x, gfloat y, gfloat center_x, gfloat center_y,
-                     gfloat radius, gfloat thickness)
+                     gfloat radius, gfloat thickness, gboolean antialias)
 {
   gfloat dx = x - center_x;
   gfloat dy = y - center_y;
   gfloat dist = hypotf(dx, dy);
-  
-  if (dist <= radius + thickness/2 && dist >= radius - thickness/2) {
-    memcpy(out, color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-  }
+  gfloat sd = fabs(dist - radius) - thickness/2;
+
+  lb_coverage_mix(out, color, lb_coverage(sd, antialias));
 }
 
 static void draw_line(gfloat *out, const gfloat *color,
                       gfloat x1, gfloat y1, gfloat x2, gfloat y2,
-                      gfloat px, gfloat py, gfloat thickness)
+                      gfloat px, gfloat py, gfloat thickness, gboolean antialias)
 {
-  gfloat line_len = hypotf(x2-x1, y2-y1);
-  gfloat t = ((px-x1)*(x2-x1) + (py-y1)*(y2-y1)) / (line_len*line_len);
-  t = CLAMP(t, 0.0f, 1.0f);
-  gfloat projx = x1 + t*(x2-x1);
-  gfloat projy = y1 + t*(y2-y1);
-  gfloat dist = hypotf(px-projx, py-projy);
-  
-  if (dist < thickness/2) {
-    memcpy(out, color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-  }
+  gfloat dist = lb_sd_segment(px, py, x1, y1, x2, y2);
+
+  lb_coverage_mix(out, color, lb_coverage_less(dist, thickness/2, antialias));
 }
 
 static void draw_zigzag(gfloat *out, const gfloat *color,
                         gfloat x, gfloat y, gfloat size,
-                        gboolean vertical, gfloat thickness)
+                        gboolean vertical, gfloat thickness, gboolean antialias)
 {
   if (vertical) {
     gfloat step = size / 4;
@@ -134,7 +129,7 @@ static void draw_zigzag(gfloat *out, const gfloat *color,
       gfloat y2 = (i + 1) * step;
       gfloat x1 = (i % 2 == 0) ? size / 4 : size * 3 / 4;
       gfloat x2 = (i % 2 == 0) ? size * 3 / 4 : size / 4;
-      draw_line(out, color, x1, y1, x2, y2, x, y, thickness);
+      draw_line(out, color, x1, y1, x2, y2, x, y, thickness, antialias);
     }
   } else {
     gfloat step = size / 4;
@@ -143,14 +138,14 @@ static void draw_zigzag(gfloat *out, const gfloat *color,
       gfloat x2 = (i + 1) * step;
       gfloat y1 = (i % 2 == 0) ? size / 4 : size * 3 / 4;
       gfloat y2 = (i % 2 == 0) ? size * 3 / 4 : size / 4;
-      draw_line(out, color, x1, y1, x2, y2, x, y, thickness);
+      draw_line(out, color, x1, y1, x2, y2, x, y, thickness, antialias);
     }
   }
 }
 
 static void draw_spiral(gfloat *out, const gfloat *color,
                         gfloat x, gfloat y, gfloat size,
-                        gboolean clockwise, gfloat thickness)
+                        gboolean clockwise, gfloat thickness, gboolean antialias)
 {
   gfloat center_x = size / 2;
   gfloat center_y = size / 2;
@@ -167,17 +162,19 @@ static void draw_spiral(gfloat *out, const gfloat *color,
     angle = 2 * M_PI - angle;
     expected_radius = angle * spiral_factor;
   }
-  
-  if (fabs(dist - expected_radius) < thickness / 2 && dist <= max_radius) {
-    memcpy(out, color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-  }
+
+  // Strict on the band like the hard test, inclusive at the outer radius
+  gfloat coverage = MIN(lb_coverage_less(fabs(dist - expected_radius), thickness / 2, antialias),
+                        lb_coverage(dist - max_radius, antialias));
+
+  lb_coverage_mix(out, color, coverage);
 }
 
 static void draw_rotated_square(gfloat *out, const gfloat *color,
                                 gfloat x, gfloat y, gfloat size,
                                 gfloat center_x, gfloat center_y,
                                 gfloat square_size, gfloat thickness,
-                                gfloat angle)
+                                gfloat angle, gboolean antialias)
 {
   gfloat dx = x - center_x;
   gfloat dy = y - center_y;
@@ -189,19 +186,19 @@ static void draw_rotated_square(gfloat *out, const gfloat *color,
   gfloat half_size = square_size / 2;
   gfloat dist_x = fabs(rotated_x - center_x);
   gfloat dist_y = fabs(rotated_y - center_y);
-  
-  if ((dist_x <= half_size + thickness/2 && dist_x >= half_size - thickness/2 && dist_y <= half_size) ||
-      (dist_y <= half_size + thickness/2 && dist_y >= half_size - thickness/2 && dist_x <= half_size)) {
-    memcpy(out, color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-  }
+
+  // Union of the vertical and horizontal sides of the square outline
+  gfloat sd = lb_sd_union(lb_sd_intersect(fabs(dist_x - half_size) - thickness/2, dist_y - half_size),
+                          lb_sd_intersect(fabs(dist_y - half_size) - thickness/2, dist_x - half_size));
+
+  lb_coverage_mix(out, color, lb_coverage(sd, antialias));
 }
 
-static gboolean process (GeglOperation *operation,
-                        void *in_buf,
-                        void *out_buf,
-                        glong n_pixels,
-                        const GeglRectangle *roi,
-                        gint level)
+static gboolean render (GeglOperation *operation,
+                       void *out_buf,
+                       glong n_pixels,
+                       const GeglRectangle *roi,
+                       gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   gfloat *out = out_buf;
@@ -240,28 +237,31 @@ static gboolean process (GeglOperation *operation,
     
     switch (o->mode) {
       case GEGL_TRUCHET_LINES:
-        if ((flip && (local_x > local_y)) || (!flip && (local_x < local_y))) {
-          memcpy(out, fg_color, 4 * sizeof(gfloat)); // Changed to copy RGBA
-        }
+      {
+        // Half plane on one side of the tile diagonal
+        gfloat coverage = flip ? lb_coverage_less_scaled(local_y, local_x, M_SQRT1_2, o->antialias)
+                               : lb_coverage_less_scaled(local_x, local_y, M_SQRT1_2, o->antialias);
+        lb_coverage_mix(out, fg_color, coverage);
         break;
+      }
         
       case GEGL_TRUCHET_ARCS:
         if (flip) {
-          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 0, o->thickness);
-          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 3, o->thickness);
+          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 0, o->thickness, o->antialias);
+          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 3, o->thickness, o->antialias);
         } else {
-          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 1, o->thickness);
-          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 2, o->thickness);
+          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 1, o->thickness, o->antialias);
+          draw_arc(out, fg_color, local_x, local_y, o->tile_size, 2, o->thickness, o->antialias);
         }
         break;
         
       case GEGL_TRUCHET_LINES_ONLY:
         if (flip) {
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, 0, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, o->tile_size, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, 0, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, o->tile_size, local_x, local_y, o->thickness, o->antialias);
         } else {
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, 0, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, o->tile_size, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, 0, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, o->tile_size, local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
@@ -270,12 +270,12 @@ static gboolean process (GeglOperation *operation,
           draw_line(out, fg_color, 
                    0, o->tile_size/2 + sin(norm_x * M_PI * 2) * o->tile_size/4,
                    o->tile_size, o->tile_size/2 + sin(norm_x * M_PI * 2) * o->tile_size/4,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
         } else {
           draw_line(out, fg_color, 
                    o->tile_size/2 + sin(norm_y * M_PI * 2) * o->tile_size/4, 0,
                    o->tile_size/2 + sin(norm_y * M_PI * 2) * o->tile_size/4, o->tile_size,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
@@ -284,42 +284,42 @@ static gboolean process (GeglOperation *operation,
           draw_line(out, fg_color, 
                    o->tile_size/4, o->tile_size/4,
                    o->tile_size*3/4, o->tile_size*3/4,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
           draw_line(out, fg_color, 
                    o->tile_size*3/4, o->tile_size/4,
                    o->tile_size/4, o->tile_size*3/4,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
         } else {
           draw_line(out, fg_color, 
                    o->tile_size/2, o->tile_size/4,
                    o->tile_size/2, o->tile_size*3/4,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
           draw_line(out, fg_color, 
                    o->tile_size/4, o->tile_size/2,
                    o->tile_size*3/4, o->tile_size/2,
-                   local_x, local_y, o->thickness);
+                   local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
       case GEGL_TRUCHET_TRIANGLES:
         if (flip) {
-          draw_line(out, fg_color, 0, 0, o->tile_size, o->tile_size, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, 0, o->tile_size, o->tile_size, 0, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, 0, 0, o->tile_size, o->tile_size, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, 0, o->tile_size, o->tile_size, 0, local_x, local_y, o->thickness, o->antialias);
         } else {
-          draw_line(out, fg_color, 0, 0, o->tile_size, 0, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, 0, 0, 0, o->tile_size, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, 0, 0, o->tile_size, 0, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, 0, 0, 0, o->tile_size, local_x, local_y, o->thickness, o->antialias);
         }
         break;
 
       case GEGL_TRUCHET_DIAMONDS:
         if (flip) {
-          draw_line(out, fg_color, o->tile_size/2, 0, o->tile_size, o->tile_size/2, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size, o->tile_size/2, o->tile_size/2, o->tile_size, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size, 0, o->tile_size/2, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, 0, o->tile_size/2, o->tile_size/2, 0, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/2, 0, o->tile_size, o->tile_size/2, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size, o->tile_size/2, o->tile_size/2, o->tile_size, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size, 0, o->tile_size/2, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, 0, o->tile_size/2, o->tile_size/2, 0, local_x, local_y, o->thickness, o->antialias);
         } else {
-          draw_line(out, fg_color, o->tile_size/4, o->tile_size/4, o->tile_size*3/4, o->tile_size*3/4, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size*3/4, o->tile_size/4, o->tile_size/4, o->tile_size*3/4, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/4, o->tile_size/4, o->tile_size*3/4, o->tile_size*3/4, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size*3/4, o->tile_size/4, o->tile_size/4, o->tile_size*3/4, local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
@@ -330,39 +330,39 @@ static gboolean process (GeglOperation *operation,
           float start_y = o->tile_size/2 + sin(angle) * o->tile_size/4;
           float end_x = o->tile_size/2 + cos(angle + M_PI/2) * o->tile_size/2;
           float end_y = o->tile_size/2 + sin(angle + M_PI/2) * o->tile_size/2;
-          draw_line(out, fg_color, start_x, start_y, end_x, end_y, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, start_x, start_y, end_x, end_y, local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
       case GEGL_TRUCHET_ZIGZAG:
         if (flip) {
-          draw_zigzag(out, fg_color, local_x, local_y, o->tile_size, TRUE, o->thickness);
+          draw_zigzag(out, fg_color, local_x, local_y, o->tile_size, TRUE, o->thickness, o->antialias);
         } else {
-          draw_zigzag(out, fg_color, local_x, local_y, o->tile_size, FALSE, o->thickness);
+          draw_zigzag(out, fg_color, local_x, local_y, o->tile_size, FALSE, o->thickness, o->antialias);
         }
         break;
         
       case GEGL_TRUCHET_SPIRALS:
-        draw_spiral(out, fg_color, local_x, local_y, o->tile_size, flip, o->thickness);
+        draw_spiral(out, fg_color, local_x, local_y, o->tile_size, flip, o->thickness, o->antialias);
         break;
         
       case GEGL_TRUCHET_DOTS_AND_LINES:
-        draw_dot(out, fg_color, local_x, local_y, o->tile_size/2, o->tile_size/2, o->tile_size/8, o->thickness);
+        draw_dot(out, fg_color, local_x, local_y, o->tile_size/2, o->tile_size/2, o->tile_size/8, o->thickness, o->antialias);
         if (flip) {
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, 0, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, o->tile_size, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, 0, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, o->tile_size, local_x, local_y, o->thickness, o->antialias);
         } else {
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, 0, local_x, local_y, o->thickness);
-          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, o->tile_size, local_x, local_y, o->thickness);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, o->tile_size, 0, local_x, local_y, o->thickness, o->antialias);
+          draw_line(out, fg_color, o->tile_size/2, o->tile_size/2, 0, o->tile_size, local_x, local_y, o->thickness, o->antialias);
         }
         break;
         
       case GEGL_TRUCHET_NESTED_SQUARES: {
         gfloat center = o->tile_size / 2;
         gfloat angle = flip ? M_PI / 4 : -M_PI / 4;
-        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.8, o->thickness, angle);
-        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.6, o->thickness, angle);
-        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.4, o->thickness, angle);
+        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.8, o->thickness, angle, o->antialias);
+        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.6, o->thickness, angle, o->antialias);
+        draw_rotated_square(out, fg_color, local_x, local_y, o->tile_size, center, center, o->tile_size * 0.4, o->thickness, angle, o->antialias);
         break;
       }
     }
@@ -374,13 +374,25 @@ static gboolean process (GeglOperation *operation,
   return TRUE;
 }
 
+static gboolean
+process (GeglOperation       *operation,
+         GeglBuffer          *input,
+         GeglBuffer          *output,
+         const GeglRectangle *result,
+         gint                 level)
+{
+  return lb_generator_process (operation, output, result, level, render);
+}
+
 static void gegl_op_class_init (GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS (klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "ai/lb:truchet-tiles",
@@ -22,6 +22,7 @@
 #include <gegl-plugin.h>
 #include <math.h>
 #include <stdlib.h>
+#include "lb-generator.h"
 
 #ifdef GEGL_PROPERTIES
 
@@ -106,7 +107,7 @@ property_int(horizon_height, _("Horizon Height"), 40)
 
 #else
 
-#define GEGL_OP_POINT_FILTER
+#define GEGL_OP_FILTER
 #define GEGL_OP_NAME     vaporwave
 #define GEGL_OP_C_SOURCE vaporwave.c
 
@@ -116,12 +117,11 @@ static void
 prepare(GeglOperation *operation)
 {
   const Babl *space = gegl_operation_get_source_space(operation, "input");
-  gegl_operation_set_format(operation, "input", babl_format_with_space("RGBA float", space));
-  gegl_operation_set_format(operation, "output", babl_format_with_space("RGBA float", space));
+  lb_generator_set_format(operation, babl_format_with_space("RGBA float", space));
 }
 
 static gboolean
-process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
+render(GeglOperation *operation, void *out_buf, glong n_pixels, const GeglRectangle *roi, gint level)
 {
   GeglProperties *o = GEGL_PROPERTIES(operation);
   gfloat *output = (gfloat *)out_buf;
@@ -134,7 +134,6 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
   gegl_color_get_pixel(o->sun_color, babl_format("RGBA float"), sun_rgb);
   gegl_color_get_pixel(o->grid_color, babl_format("RGBA float"), grid_rgb);
   gegl_color_get_pixel(o->mountains_color, babl_format("RGBA float"), mountains_rgb);
-  srand(o->seed);
 
   /* Get full canvas dimensions */
   GeglRectangle *canvas = gegl_operation_source_get_bounding_box(operation, "input");
@@ -278,9 +277,11 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
         b = CLAMP(b + 0.1f, 0.0f, 1.0f); /* Stronger blue tint */
       }
 
-      /* Noise */
+      /* Noise, hashed from the seed and canvas position so every tile
+       * renders the same regardless of which thread processes it */
       if (o->noise) {
-        gfloat n = (rand() / (gfloat)RAND_MAX - 0.5f) * 0.06f; /* Increased noise strength */
+        gfloat n = gegl_random_float_range(o->rand, x + roi->x, y + roi->y, 0, 0,
+                                           -0.03f, 0.03f); /* Increased noise strength */
         r = CLAMP(r + n, 0.0f, 1.0f);
         g = CLAMP(g + n, 0.0f, 1.0f);
         b = CLAMP(b + n, 0.0f, 1.0f);
@@ -296,14 +297,26 @@ process(GeglOperation *operation, void *in_buf, void *out_buf, glong n_pixels, c
   return TRUE;
 }
 
+static gboolean
+process(GeglOperation       *operation,
+        GeglBuffer          *input,
+        GeglBuffer          *output,
+        const GeglRectangle *result,
+        gint                 level)
+{
+  return lb_generator_process(operation, output, result, level, render);
+}
+
 static void
 gegl_op_class_init(GeglOpClass *klass)
 {
   GeglOperationClass *operation_class = GEGL_OPERATION_CLASS(klass);
-  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS(klass);
+  GeglOperationFilterClass *filter_class = GEGL_OPERATION_FILTER_CLASS(klass);
 
   operation_class->prepare = prepare;
-  point_filter_class->process = process;
+  operation_class->get_required_for_output = lb_generator_get_required_for_output;
+  operation_class->threaded = TRUE;
+  filter_class->process = process;
 
   gegl_operation_class_set_keys(operation_class,
     "name",        "ai/lb:vaporwave",
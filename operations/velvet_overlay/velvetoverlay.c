@@ -46,6 +46,7 @@ property_double (opacity, _("Opacity"), 1.0)
 #define GEGL_OP_C_SOURCE velvetoverlay.c
 
 #include "gegl-op.h"
+#include "lb-blend.h"
 
 static void
 prepare (GeglOperation *operation)
@@ -133,8 +134,31 @@ process (GeglOperation       *op,
   /* Access the properties */
   gdouble intensity_factor = GEGL_PROPERTIES (op)->intensity_factor;
   gdouble opacity = GEGL_PROPERTIES (op)->opacity;
+  gfloat  opacity_f = opacity;
+  gfloat  strength = intensity_factor * 0.1f;
 
-  for (i = 0; i < n_pixels; i++)
+  i = 0;
+  if (components == 4)
+    for (; i + LB_BLEND_BLOCK <= n_pixels; i += LB_BLEND_BLOCK)
+      {
+        gfloat blended[LB_BLEND_BLOCK * 4];
+
+        for (gint j = 0; j < LB_BLEND_BLOCK * 4; j++)
+          {
+            gfloat diff = fabsf (aux[j] - in[j]);
+            gfloat processed = CLAMP (in[j] + strength * lb_blend_log (1.0f + diff) * (aux[j] + 0.2f), 0.0f, 1.0f);
+
+            blended[j] = lb_blend_mix (in[j], processed, opacity_f);
+          }
+
+        lb_blend_store (in, blended, out);
+
+        in  += LB_BLEND_BLOCK * 4;
+        aux += LB_BLEND_BLOCK * 4;
+        out += LB_BLEND_BLOCK * 4;
+      }
+
+  for (; i < n_pixels; i++)
     {
       gfloat a_r = aux[0];  /* Source (aux) red */
       gfloat a_g = aux[1];  /* Source green */
@@ -74,7 +74,7 @@ property_color (background_color, _("Background Color"), "#000000")
 
 #else
 
-#define GEGL_OP_FILTER
+#define GEGL_OP_POINT_FILTER
 #define GEGL_OP_NAME     weaves
 #define GEGL_OP_C_SOURCE weaves.c
 
@@ -88,43 +88,19 @@ prepare (GeglOperation *operation)
   gegl_operation_set_format (operation, "output", format);
 }
 
-static GeglRectangle
-get_bounding_box (GeglOperation *operation)
-{
-  GeglRectangle *in_rect = gegl_operation_source_get_bounding_box (operation, "input");
-  return in_rect ? *in_rect : (GeglRectangle){0, 0, 0, 0};
-}
-
-static GeglRectangle
-get_required_for_output (GeglOperation       *operation,
-                        const gchar         *input_pad,
-                        const GeglRectangle *roi)
-{
-  return get_bounding_box (operation);
-}
-
 static gboolean
 process (GeglOperation       *operation,
-         GeglBuffer          *input,
-         GeglBuffer          *output,
-         const GeglRectangle *result,
+         void                *in_buf,
+         void                *out_buf,
+         glong                n_pixels,
+         const GeglRectangle *roi,
          gint                 level)
 {
   GeglProperties *o = GEGL_PROPERTIES (operation);
   const Babl *format = babl_format ("RGBA float");
-  GeglBufferIterator *iter;
-
-  if (result->width < 1 || result->height < 1)
-    {
-      if (input != output)
-        gegl_buffer_copy (input, result, GEGL_ABYSS_CLAMP, output, result);
-      return TRUE;
-    }
-
-  iter = gegl_buffer_iterator_new (input, result, 0, format,
-                                  GEGL_ACCESS_READ, GEGL_ABYSS_CLAMP, 2);
-  gegl_buffer_iterator_add (iter, output, result, 0, format,
-                           GEGL_ACCESS_WRITE, GEGL_ABYSS_CLAMP);
+  gfloat *in_data = in_buf;
+  gfloat *out_data = out_buf;
+  gint x, y;
 
   /* Get thread and background colors */
   gfloat color1[4], color2[4], bg_color[4];
@@ -137,103 +113,95 @@ process (GeglOperation       *operation,
   gfloat cos_a = cosf (angle_rad);
   gfloat sin_a = sinf (angle_rad);
 
-  while (gegl_buffer_iterator_next (iter))
-    {
-      gfloat *in_data = iter->items[0].data;
-      gfloat *out_data = iter->items[1].data;
-      GeglRectangle roi = iter->items[0].roi;
-      gint x, y;
+  gfloat period = o->thread_width + o->thread_spacing;
+
+  /* The pattern only depends on the output position, so every pixel reads
+   * just the input pixel under it */
+  for (y = 0; y < roi->height; y++)
+    for (x = 0; x < roi->width; x++)
+      {
+        gint offset = (y * roi->width + x) * 4;
+        gfloat px = x + roi->x;
+        gfloat py = y + roi->y;
+
+        /* Rotate coordinates */
+        gfloat rx = px * cos_a + py * sin_a;
+        gfloat ry = -px * sin_a + py * cos_a;
+
+        /* Compute weave pattern */
+        gfloat wx = fmodf (rx, period);
+        gfloat wy = fmodf (ry, period);
+        gboolean is_thread_x = wx < o->thread_width;
+        gboolean is_thread_y = wy < o->thread_width;
 
-      for (y = 0; y < roi.height; y++)
-        for (x = 0; x < roi.width; x++)
+        gfloat *color = color1;
+        gfloat shadow = 1.0f;
+
+        /* Determine thread crossing based on pattern */
+        if (is_thread_x && is_thread_y)
           {
-            gint offset = (y * roi.width + x) * 4;
-            gfloat px = x + roi.x;
-            gfloat py = y + roi.y;
-
-            /* Rotate coordinates */
-            gfloat rx = px * cos_a + py * sin_a;
-            gfloat ry = -px * sin_a + py * cos_a;
-
-            /* Compute weave pattern */
-            gfloat period = o->thread_width + o->thread_spacing;
-            gfloat wx = fmodf (rx, period);
-            gfloat wy = fmodf (ry, period);
-            gboolean is_thread_x = wx < o->thread_width;
-            gboolean is_thread_y = wy < o->thread_width;
-
-            gfloat *color = color1;
-            gfloat shadow = 1.0f;
-
-            /* Determine thread crossing based on pattern */
-            if (is_thread_x && is_thread_y)
-              {
-                gfloat cx = floorf (rx / period);
-                gfloat cy = floorf (ry / period);
-                gboolean x_over_y = FALSE;
-
-                switch (o->pattern)
-                  {
-                  case WEAVE_PATTERN_PLAIN:
-                    /* Plain weave: Alternating over-under */
-                    x_over_y = fmodf (cx + cy, 2.0f) < 1.0f;
-                    break;
-
-                  case WEAVE_PATTERN_TWILL:
-                    /* Twill weave: Diagonal pattern, 2x2 offset */
-                    x_over_y = fmodf (cx + cy * 2.0f, 4.0f) < 2.0f;
-                    break;
-
-                  case WEAVE_PATTERN_SATIN:
-                    /* Satin weave: Sparse crossing, 4x1 offset */
-                    x_over_y = fmodf (cx + cy * 4.0f, 5.0f) < 1.0f;
-                    break;
-
-                  case WEAVE_PATTERN_DIAMOND:
-                    /* Diamond weave: Diagonal shifts forming diamond shapes */
-                    x_over_y = fmodf (fabs(cx - cy), 4.0f) < 2.0f;
-                    break;
-
-                  case WEAVE_PATTERN_HERRINGBONE:
-                    /* Herringbone: Zigzag twill */
-                    x_over_y = fmodf (cx + cy * 2.0f + floorf (cy / 4.0f) * 4.0f, 8.0f) < 4.0f;
-                    break;
-
-                  case WEAVE_PATTERN_WAVE:
-                    /* Wave weave: Sinusoidal pattern */
-                    x_over_y = sinf (G_PI * (cx + cy) / 4.0f) > 0.0f;
-                    break;
-                  }
-
-                color = x_over_y ? color1 : color2;
-                shadow = x_over_y ? 1.0f : 1.0f - o->shadow_intensity;
-              }
-            else if (is_thread_x)
-              {
-                color = color1;
-                shadow = 1.0f - o->shadow_intensity * 0.5f;
-              }
-            else if (is_thread_y)
-              {
-                color = color2;
-                shadow = 1.0f - o->shadow_intensity * 0.5f;
-              }
-            else
-              {
-                /* Background: use background color if enabled, else input image */
-                color = o->use_background_color ? bg_color : in_data + offset;
-                shadow = 1.0f;
-              }
+            gfloat cx = floorf (rx / period);
+            gfloat cy = floorf (ry / period);
+            gboolean x_over_y = FALSE;
 
-            /* Apply output color with shadow effect */
-            for (gint j = 0; j < 4; j++)
+            switch (o->pattern)
               {
-                out_data[offset + j] = color[j] * shadow;
-                if (j == 3 && !is_thread_x && !is_thread_y)
-                  out_data[offset + j] = color[j]; /* Preserve input alpha */
+              case WEAVE_PATTERN_PLAIN:
+                /* Plain weave: Alternating over-under */
+                x_over_y = fmodf (cx + cy, 2.0f) < 1.0f;
+                break;
+
+              case WEAVE_PATTERN_TWILL:
+                /* Twill weave: Diagonal pattern, 2x2 offset */
+                x_over_y = fmodf (cx + cy * 2.0f, 4.0f) < 2.0f;
+                break;
+
+              case WEAVE_PATTERN_SATIN:
+                /* Satin weave: Sparse crossing, 4x1 offset */
+                x_over_y = fmodf (cx + cy * 4.0f, 5.0f) < 1.0f;
+                break;
+
+              case WEAVE_PATTERN_DIAMOND:
+                /* Diamond weave: Diagonal shifts forming diamond shapes */
+                x_over_y = fmodf (fabs(cx - cy), 4.0f) < 2.0f;
+                break;
+
+              case WEAVE_PATTERN_HERRINGBONE:
+                /* Herringbone: Zigzag twill */
+                x_over_y = fmodf (cx + cy * 2.0f + floorf (cy / 4.0f) * 4.0f, 8.0f) < 4.0f;
+                break;
+
+              case WEAVE_PATTERN_WAVE:
+                /* Wave weave: Sinusoidal pattern */
+                x_over_y = sinf (G_PI * (cx + cy) / 4.0f) > 0.0f;
+                break;
               }
+
+            color = x_over_y ? color1 : color2;
+            shadow = x_over_y ? 1.0f : 1.0f - o->shadow_intensity;
           }
-    }
+        else if (is_thread_x)
+          {
+            color = color1;
+            shadow = 1.0f - o->shadow_intensity * 0.5f;
+          }
+        else if (is_thread_y)
+          {
+            color = color2;
+            shadow = 1.0f - o->shadow_intensity * 0.5f;
+          }
+        else
+          {
+            /* Background: use background color if enabled, else input image */
+            color = o->use_background_color ? bg_color : in_data + offset;
+            shadow = 1.0f;
+          }
+
+        /* Apply output color with shadow effect; the background is
+         * unshaded, so it keeps the input alpha */
+        for (gint j = 0; j < 4; j++)
+          out_data[offset + j] = color[j] * shadow;
+      }
 
   return TRUE;
 }
@@ -241,13 +209,11 @@ process (GeglOperation       *operation,
 static void
 gegl_op_class_init (GeglOpClass *klass)
 {
-  GeglOperationClass     *operation_class = GEGL_OPERATION_CLASS (klass);
-  GeglOperationFilterClass *filter_class  = GEGL_OPERATION_FILTER_CLASS (klass);
+  GeglOperationClass            *operation_class    = GEGL_OPERATION_CLASS (klass);
+  GeglOperationPointFilterClass *point_filter_class = GEGL_OPERATION_POINT_FILTER_CLASS (klass);
 
-  operation_class->prepare         = prepare;
-  operation_class->get_bounding_box = get_bounding_box;
-  operation_class->get_required_for_output = get_required_for_output;
-  filter_class->process            = process;
+  operation_class->prepare    = prepare;
+  point_filter_class->process = process;
 
   gegl_operation_class_set_keys (operation_class,
     "name",        "ai/lb:weave",